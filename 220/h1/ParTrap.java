@@ -0,0 +1,171 @@
+// File:     ParTrap.java
+// Author:   Cayla Shaver
+// Purpose:  Calculate area using the trapezoidal rule with a
+//           ForkJoinPool
+//
+// Input:    a:  left endpoint of interval
+//           b:  right endpoint of interval
+//           n:  number of trapezoids
+// Output:   estimate of area between the x-axis, x = a, x = b, and
+//           the graph of f(x) using n trapezoids, from the pool and
+//           from a serial compensated sum, and the elapsed times
+//
+// Compile:  javac ParTrap.java
+// Usage:    java ParTrap [threads]
+//              threads:  size of the pool (default:  number of
+//                        processors)
+//
+// Notes:    1.  f(x) is hardwired as a private static member, as in
+//               trap.java.
+//           2.  The points 1..n-1 are split in half recursively until
+//               a piece has at most THRESHOLD points;  each piece is
+//               a RecursiveTask that adds up its f values with
+//               compensated (Kahan-Babuska-Neumaier) summation, and
+//               the halves are merged with their compensation terms,
+//               like ksum.c.  So the result doesn't depend on how the
+//               pool schedules the pieces.
+//           3.  The points are computed as a + i*h, as in trap.c.
+
+import java.util.Scanner;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.RecursiveTask;
+
+public class ParTrap {
+
+   static final long THRESHOLD = 1L << 16;
+
+   public static void main(String args[]) {
+      double   area, serial;  // Store results
+      double   a, b;          // Left and right endpoints
+      long     n;             // Number of trapezoids
+      int      threads;
+      long     start, finish;
+
+      threads = (args.length > 0) ? Integer.parseInt(args[0])
+         : Runtime.getRuntime().availableProcessors();
+      ForkJoinPool pool = new ForkJoinPool(threads);
+      Scanner sc = new Scanner(System.in);
+
+      System.out.println("Enter a, b, and n");
+      a = sc.nextDouble();
+      b = sc.nextDouble();
+      n = sc.nextLong();
+
+      start = System.nanoTime();
+      area = parTrap(pool, a, b, n);
+      finish = System.nanoTime();
+      System.out.println("With n = " + n + " trapezoids and " + threads
+            + " threads, our estimate");
+      System.out.print("of the area from " + a + " to " + b);
+      System.out.println(" = " + area);
+      System.out.println("Elapsed time = " + (finish - start)/1.0e9
+            + " seconds");
+
+      start = System.nanoTime();
+      serial = trap(a, b, n);
+      finish = System.nanoTime();
+      System.out.println("Serial compensated sum = " + serial);
+      System.out.println("Elapsed time = " + (finish - start)/1.0e9
+            + " seconds");
+
+      pool.shutdown();
+   }  // main
+
+   // Method:       parTrap
+   // Purpose:      Estimate area using the trapezoidal rule, with the
+   //               sum split among the threads of pool
+   // Input args:   pool, a, b, n
+   // Return val:   Trapezoidal rule estimate of area between x-axis,
+   //               x = a, x = b, and graph of f(x)
+   static double parTrap(ForkJoinPool pool, double a, double b, long n) {
+      double   h = (b-a)/n;
+      KahanSum sum = pool.invoke(new SumTask(a, h, 1, n));
+
+      sum.add(f(a)/2);
+      sum.add(f(b)/2);
+      return sum.value()*h;
+   }  // parTrap
+
+   // Method:       trap
+   // Purpose:      Serial trapezoidal rule with the same compensated
+   //               sum, for checking parTrap
+   // Input args:   a, b, n
+   static double trap(double a, double b, long n) {
+      double   h = (b-a)/n;
+      KahanSum sum = new KahanSum();
+
+      sum.add(f(a)/2);
+      sum.add(f(b)/2);
+      for (long i = 1; i < n; i++)
+         sum.add(f(a + i*h));
+      return sum.value()*h;
+   }  // trap
+
+   // Method:     f
+   // Purpose:    Compute value of function being integrated
+   // Input arg:  x
+   static double f(double x) {
+      double return_val;
+      return_val = x * x + 1;
+      return return_val;
+   }  // f
+
+   // Class:      KahanSum
+   // Purpose:    Compensated sum:  a running sum and the running sum
+   //             of its rounding errors
+   static final class KahanSum {
+      double sum;
+      double comp;
+
+      void add(double x) {
+         double t = sum + x;
+         if (Math.abs(sum) >= Math.abs(x))
+            comp += (sum - t) + x;
+         else
+            comp += (x - t) + sum;
+         sum = t;
+      }
+
+      void merge(KahanSum other) {
+         add(other.sum);
+         comp += other.comp;
+      }
+
+      double value() {
+         return sum + comp;
+      }
+   }  // KahanSum
+
+   // Class:      SumTask
+   // Purpose:    Add up f(a + i*h) for first <= i < last, splitting
+   //             the range in half until it's at most THRESHOLD long
+   static final class SumTask extends RecursiveTask<KahanSum> {
+      final double a, h;
+      final long   first, last;
+
+      SumTask(double a, double h, long first, long last) {
+         this.a = a;
+         this.h = h;
+         this.first = first;
+         this.last = last;
+      }
+
+      @Override
+      protected KahanSum compute() {
+         if (last - first <= THRESHOLD) {
+            KahanSum sum = new KahanSum();
+            for (long i = first; i < last; i++)
+               sum.add(f(a + i*h));
+            return sum;
+         }
+         long    mid = (first + last) >>> 1;
+         SumTask left = new SumTask(a, h, first, mid);
+         left.fork();
+         KahanSum right = new SumTask(a, h, mid, last).compute();
+         KahanSum sum = left.join();
+         sum.merge(right);
+         return sum;
+      }
+   }  // SumTask
+
+}  // class ParTrap
@@ -0,0 +1,156 @@
+// File:     TrapBench.java
+// Author:   Cayla Shaver
+// Purpose:  Benchmark the serial and ForkJoinPool trapezoidal rules in
+//           ParTrap.java against the C trapezoidal rule in trap.c at
+//           the same n
+//
+// Compile:  javac ParTrap.java TrapBench.java
+//           gcc -g -Wall -O3 -march=native -I.. -o trap trap.c
+// Usage:    java TrapBench <n> [threads [path to trap]]
+//              n:        number of trapezoids (<= 2^31 - 1, since
+//                        trap.c uses an int)
+//              threads:  size of the pool (default:  number of
+//                        processors)
+//              trap:     the compiled trap.c (default ./trap)
+//
+// Output:   For each of java serial, java parallel, C scalar and C
+//           batch:  mean, standard deviation and minimum time over
+//           the measured iterations, and nanoseconds per point.
+//
+// Notes:    1.  Like JMH, each Java method is run WARMUP times before
+//               it's measured, so the JIT has compiled it, and then
+//               MEASURE times.  The results are added into a volatile
+//               "blackhole" so the JIT can't drop the calls.
+//           2.  trap.c is run as a separate process MEASURE times, and
+//               the times it prints for its scalar and batch loops
+//               are used, so process startup isn't counted.
+//           3.  The interval is [0, 3].
+
+import java.io.BufferedReader;
+import java.io.InputStreamReader;
+import java.io.OutputStreamWriter;
+import java.io.Writer;
+import java.util.concurrent.ForkJoinPool;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+public class TrapBench {
+
+   static final int    WARMUP = 5;
+   static final int    MEASURE = 10;
+   static final double A = 0.0;
+   static final double B = 3.0;
+
+   static volatile double blackhole;
+
+   public static void main(String args[]) throws Exception {
+      if (args.length < 1) {
+         System.err.println("usage: java TrapBench <n> [threads [trap]]");
+         System.exit(0);
+      }
+      long   n = Long.parseLong(args[0]);
+      int    threads = (args.length > 1) ? Integer.parseInt(args[1])
+         : Runtime.getRuntime().availableProcessors();
+      String trapPath = (args.length > 2) ? args[2] : "./trap";
+      ForkJoinPool pool = new ForkJoinPool(threads);
+
+      System.out.printf("n = %d, %d threads, %d warmup and %d measured "
+            + "iterations%n", n, threads, WARMUP, MEASURE);
+      System.out.printf("%-14s %12s %12s %12s %10s%n", "version",
+            "mean (s)", "stddev (s)", "min (s)", "ns/point");
+
+      double[] times = new double[MEASURE];
+      for (int i = 0; i < WARMUP; i++)
+         blackhole += ParTrap.trap(A, B, n);
+      for (int i = 0; i < MEASURE; i++) {
+         long start = System.nanoTime();
+         blackhole += ParTrap.trap(A, B, n);
+         times[i] = (System.nanoTime() - start)/1.0e9;
+      }
+      report("java serial", times, n);
+
+      for (int i = 0; i < WARMUP; i++)
+         blackhole += ParTrap.parTrap(pool, A, B, n);
+      for (int i = 0; i < MEASURE; i++) {
+         long start = System.nanoTime();
+         blackhole += ParTrap.parTrap(pool, A, B, n);
+         times[i] = (System.nanoTime() - start)/1.0e9;
+      }
+      report("java parallel", times, n);
+      pool.shutdown();
+
+      double[] scalar = new double[MEASURE];
+      double[] batch = new double[MEASURE];
+      if (runC(trapPath, n, scalar, batch)) {
+         report("C scalar", scalar, n);
+         report("C batch", batch, n);
+      }
+   }  // main
+
+   // Method:     runC
+   // Purpose:    Run trap.c MEASURE times and collect the times it
+   //             prints for the trapezoidal rule
+   // Input args: trapPath, n
+   // Out args:   scalar, batch
+   // Return val: false if trap couldn't be run
+   static boolean runC(String trapPath, long n, double[] scalar,
+         double[] batch) throws Exception {
+      Pattern p = Pattern.compile(
+            "Trapezoids:\\s+(\\S+) seconds scalar,\\s+(\\S+) seconds batch");
+
+      for (int i = 0; i < MEASURE; i++) {
+         Process proc;
+         try {
+            proc = new ProcessBuilder(trapPath).redirectErrorStream(true)
+               .start();
+         } catch (java.io.IOException e) {
+            System.err.println("Can't run " + trapPath + ": "
+                  + e.getMessage());
+            return false;
+         }
+         Writer in = new OutputStreamWriter(proc.getOutputStream());
+         in.write(A + " " + B + " " + n + "\n");
+         in.close();
+
+         BufferedReader out = new BufferedReader(
+               new InputStreamReader(proc.getInputStream()));
+         String  line;
+         boolean found = false;
+         while ((line = out.readLine()) != null) {
+            Matcher m = p.matcher(line);
+            if (m.find()) {
+               scalar[i] = Double.parseDouble(m.group(1));
+               batch[i] = Double.parseDouble(m.group(2));
+               found = true;
+            }
+         }
+         proc.waitFor();
+         if (!found) {
+            System.err.println(trapPath + " didn't print its times");
+            return false;
+         }
+      }
+      return true;
+   }  // runC
+
+   // Method:     report
+   // Purpose:    Print mean, standard deviation, minimum and
+   //             nanoseconds per point for one version
+   // Input args: name, times, n
+   static void report(String name, double[] times, long n) {
+      double sum = 0.0, sq = 0.0, min = Double.MAX_VALUE;
+
+      for (double t : times) {
+         sum += t;
+         min = Math.min(min, t);
+      }
+      double mean = sum/times.length;
+      for (double t : times)
+         sq += (t - mean)*(t - mean);
+      double stddev = Math.sqrt(sq/(times.length - 1));
+
+      System.out.printf("%-14s %12.4e %12.4e %12.4e %10.3f%n", name, mean,
+            stddev, min, 1.0e9*mean/n);
+   }  // report
+
+}  // class TrapBench
@@ -0,0 +1,360 @@
+/* File:    adapt_quad.c
+ * Author:  Cayla Shaver
+ * Purpose: Estimate the area under the graph of f(x) to within a
+ *          given tolerance with adaptive Simpson's rule, using Pthreads
+ *          and a work-stealing queue of subintervals.
+ *
+ * Input:   a, b, tol
+ * Output:  estimate of area between x-axis, x = a, x = b, and graph
+ *          of f(x), the number of function evaluations it took, and
+ *          the number of evaluations uniform Simpson's rule needs
+ *          for the same accuracy.
+ *
+ * Compile: gcc -g -Wall -O2 -I.. -o adapt_quad adapt_quad.c ksum.c
+ *             -lpthread -lm
+ * Run:     ./adapt_quad <thread_count>
+ *
+ * Notes:
+ *    1.  The function f(x) is hardwired.  It's x*x + 1 plus a narrow
+ *        spike of width about SPIKE_W at x = SPIKE_X, which is the
+ *        kind of integrand a uniform n either wastes points on or
+ *        misses.
+ *    2.  A task is a subinterval [l, r] with the f values at l, the
+ *        midpoint and r, its Simpson estimate, and its share of the
+ *        tolerance.  A thread takes a task, evaluates f at the two
+ *        quarter points, and compares the two-panel estimate with
+ *        the one-panel estimate.  If they agree to within 15*tol the
+ *        task is done (with Richardson extrapolation added),
+ *        otherwise its halves are pushed back with tol/2 each.
+ *    3.  Each thread has its own deque.  It pushes and pops at the
+ *        bottom (so it works depth first on recently split, cache
+ *        hot intervals), and when it's empty it steals from the top
+ *        of another thread's deque (so it takes a big interval).
+ *        Each deque is protected by its own mutex;  nothing else is
+ *        shared except a count of outstanding tasks.
+ *    4.  Each thread keeps a compensated sum (ksum.c) of its finished
+ *        intervals, and the sums are added at the end.
+ *    5.  The uniform comparison doubles n until Simpson's rule with n
+ *        subintervals is as close to the adaptive answer as tol, up
+ *        to MAX_UNIFORM_N.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <pthread.h>
+#include "timer.h"
+#include "ksum.h"
+
+const double SPIKE_X = 0.3;
+const double SPIKE_W = 1.0e-3;
+const int    MAX_DEPTH = 60;
+const long   MAX_UNIFORM_N = 1L << 30;
+const int    DEQUE_INIT = 64;
+
+typedef struct {
+   double l, r;             /* Endpoints                              */
+   double fl, fm, fr;       /* f at l, (l+r)/2, r                     */
+   double whole;            /* Simpson estimate on [l, r]             */
+   double tol;
+   int    depth;
+} task_t;
+
+typedef struct {
+   task_t*         tasks;
+   int             top;     /* Index of the oldest task               */
+   int             bottom;  /* Index one past the newest task         */
+   int             cap;
+   pthread_mutex_t mutex;
+} deque_t;
+
+/* Global variables:  shared by the threads */
+int      thread_count;
+deque_t* deques;
+long     outstanding;       /* Tasks pushed but not yet finished      */
+pthread_mutex_t count_mutex;
+ksum_t*  partial;           /* Each thread's sum of finished tasks    */
+long*    evals;             /* Each thread's number of f evaluations  */
+
+double f(double x);
+double Simpson(double a, double b, int n);
+void   Push(deque_t* q, task_t* t);
+int    Pop_bottom(deque_t* q, task_t* t);
+int    Steal_top(deque_t* q, task_t* t);
+int    Get_task(long my_rank, task_t* t);
+void*  Thread_work(void* rank);
+
+int main(int argc, char* argv[]) {
+   double  a, b, tol, start, finish, area, uniform;
+   long    thread, total_evals, n;
+   pthread_t* thread_handles;
+   ksum_t  total;
+   task_t  first;
+
+   if (argc != 2 || (thread_count = strtol(argv[1], NULL, 10)) <= 0) {
+      fprintf(stderr, "usage: %s <thread_count>\n", argv[0]);
+      exit(0);
+   }
+   printf("Enter a, b, and tol\n");
+   scanf("%lf", &a);
+   scanf("%lf", &b);
+   scanf("%lf", &tol);
+
+   deques = malloc(thread_count*sizeof(deque_t));
+   partial = malloc(thread_count*sizeof(ksum_t));
+   evals = calloc(thread_count, sizeof(long));
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   for (thread = 0; thread < thread_count; thread++) {
+      deques[thread].cap = DEQUE_INIT;
+      deques[thread].tasks = malloc(DEQUE_INIT*sizeof(task_t));
+      deques[thread].top = deques[thread].bottom = 0;
+      pthread_mutex_init(&deques[thread].mutex, NULL);
+   }
+   pthread_mutex_init(&count_mutex, NULL);
+
+   GET_TIME(start);
+   first.l = a;
+   first.r = b;
+   first.fl = f(a);
+   first.fm = f((a + b)/2);
+   first.fr = f(b);
+   first.whole = (b - a)/6*(first.fl + 4*first.fm + first.fr);
+   first.tol = tol;
+   first.depth = 0;
+   evals[0] = 3;
+   outstanding = 1;
+   Push(&deques[0], &first);
+
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Thread_work,
+            (void*) thread);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+   GET_TIME(finish);
+
+   Ksum_init(&total);
+   total_evals = 0;
+   for (thread = 0; thread < thread_count; thread++) {
+      Ksum_merge(&total, &partial[thread]);
+      total_evals += evals[thread];
+   }
+   area = Ksum_value(&total);
+   printf("With tol = %e and %d threads, our estimate\n", tol,
+         thread_count);
+   printf("of the area from %f to %f = %.15e\n", a, b, area);
+   printf("Function evaluations = %ld\n", total_evals);
+   printf("Elapsed time = %e seconds\n", finish - start);
+
+   for (n = 2; n <= MAX_UNIFORM_N; n *= 2) {
+      uniform = Simpson(a, b, n);
+      if (fabs(uniform - area) <= tol) break;
+   }
+   if (n <= MAX_UNIFORM_N)
+      printf("Uniform Simpson's rule needs n = %ld (%ld evaluations, "
+            "%.1fx more)\n", n, n + 1, (double) (n + 1)/total_evals);
+   else
+      printf("Uniform Simpson's rule isn't within tol for n <= %ld\n",
+            MAX_UNIFORM_N);
+
+   for (thread = 0; thread < thread_count; thread++) {
+      free(deques[thread].tasks);
+      pthread_mutex_destroy(&deques[thread].mutex);
+   }
+   pthread_mutex_destroy(&count_mutex);
+   free(deques);
+   free(partial);
+   free(evals);
+   free(thread_handles);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:    Thread_work
+ * Purpose:     Thread function:  refine tasks until there are none
+ *              left anywhere
+ * In arg:      rank
+ * Globals:     deques, outstanding (in/out), partial, evals (out)
+ */
+void* Thread_work(void* rank) {
+   long   my_rank = (long) rank;
+   task_t t, left, right;
+   double lm, rm, flm, frm, halves, err;
+   ksum_t my_sum;
+   long   my_evals = 0;
+
+   Ksum_init(&my_sum);
+   while (Get_task(my_rank, &t)) {
+      lm = (t.l + (t.l + t.r)/2)/2;
+      rm = ((t.l + t.r)/2 + t.r)/2;
+      flm = f(lm);
+      frm = f(rm);
+      my_evals += 2;
+
+      left.l = t.l;               right.l = (t.l + t.r)/2;
+      left.r = right.l;           right.r = t.r;
+      left.fl = t.fl;             right.fl = t.fm;
+      left.fm = flm;              right.fm = frm;
+      left.fr = t.fm;             right.fr = t.fr;
+      left.whole = (left.r - left.l)/6*(left.fl + 4*flm + left.fr);
+      right.whole = (right.r - right.l)/6*(right.fl + 4*frm + right.fr);
+      halves = left.whole + right.whole;
+      err = halves - t.whole;
+
+      if (fabs(err) <= 15*t.tol || t.depth >= MAX_DEPTH) {
+         Ksum_add(&my_sum, halves + err/15);
+         pthread_mutex_lock(&count_mutex);
+         outstanding--;
+         pthread_mutex_unlock(&count_mutex);
+      } else {
+         left.tol = right.tol = t.tol/2;
+         left.depth = right.depth = t.depth + 1;
+         pthread_mutex_lock(&count_mutex);
+         outstanding++;   /* Two new tasks replace one */
+         pthread_mutex_unlock(&count_mutex);
+         Push(&deques[my_rank], &right);
+         Push(&deques[my_rank], &left);
+      }
+   }
+
+   partial[my_rank] = my_sum;
+   evals[my_rank] += my_evals;
+   return NULL;
+}  /* Thread_work */
+
+
+/*------------------------------------------------------------------
+ * Function:    Get_task
+ * Purpose:     Get a task from this thread's deque, or steal one
+ * In arg:      my_rank
+ * Out arg:     t
+ * Return val:  1 if there's a task, 0 if all the work is done
+ *
+ * Note:        A thread whose deque is empty tries the other deques
+ *              in turn, starting with its right neighbor, until it
+ *              steals a task or there are no outstanding tasks.
+ */
+int Get_task(long my_rank, task_t* t) {
+   long victim, i;
+   long left;
+
+   if (Pop_bottom(&deques[my_rank], t)) return 1;
+   while (1) {
+      for (i = 1; i < thread_count; i++) {
+         victim = (my_rank + i) % thread_count;
+         if (Steal_top(&deques[victim], t)) return 1;
+      }
+      if (Pop_bottom(&deques[my_rank], t)) return 1;
+      pthread_mutex_lock(&count_mutex);
+      left = outstanding;
+      pthread_mutex_unlock(&count_mutex);
+      if (left == 0) return 0;
+      sched_yield();
+   }
+}  /* Get_task */
+
+
+/*------------------------------------------------------------------
+ * Function:    Push
+ * Purpose:     Add a task at the bottom of a deque, growing it if
+ *              it's full
+ * In arg:      t
+ * In/out arg:  q
+ */
+void Push(deque_t* q, task_t* t) {
+   int count;
+
+   pthread_mutex_lock(&q->mutex);
+   if (q->bottom == q->cap) {
+      count = q->bottom - q->top;
+      if (count < q->cap/2) {
+         /* Lots of room at the top:  slide the tasks down */
+         memmove(q->tasks, q->tasks + q->top, count*sizeof(task_t));
+      } else {
+         q->cap *= 2;
+         q->tasks = realloc(q->tasks, q->cap*sizeof(task_t));
+         memmove(q->tasks, q->tasks + q->top, count*sizeof(task_t));
+      }
+      q->top = 0;
+      q->bottom = count;
+   }
+   q->tasks[q->bottom++] = *t;
+   pthread_mutex_unlock(&q->mutex);
+}  /* Push */
+
+
+/*------------------------------------------------------------------
+ * Function:    Pop_bottom
+ * Purpose:     Take the newest task from a deque
+ * In/out arg:  q
+ * Out arg:     t
+ * Return val:  1 if there was a task, 0 if the deque was empty
+ */
+int Pop_bottom(deque_t* q, task_t* t) {
+   int got = 0;
+
+   pthread_mutex_lock(&q->mutex);
+   if (q->bottom > q->top) {
+      *t = q->tasks[--q->bottom];
+      got = 1;
+   }
+   pthread_mutex_unlock(&q->mutex);
+   return got;
+}  /* Pop_bottom */
+
+
+/*------------------------------------------------------------------
+ * Function:    Steal_top
+ * Purpose:     Take the oldest task from a deque
+ * In/out arg:  q
+ * Out arg:     t
+ * Return val:  1 if there was a task, 0 if the deque was empty
+ */
+int Steal_top(deque_t* q, task_t* t) {
+   int got = 0;
+
+   if (pthread_mutex_trylock(&q->mutex) != 0) return 0;
+   if (q->bottom > q->top) {
+      *t = q->tasks[q->top++];
+      got = 1;
+   }
+   pthread_mutex_unlock(&q->mutex);
+   return got;
+}  /* Steal_top */
+
+
+/*------------------------------------------------------------------
+ * Function:     Simpson
+ * Purpose:      Estimate area using Simpson's rule with n (even)
+ *               subintervals, with a compensated sum
+ * Input args:   a, b, n
+ */
+double Simpson(double a, double b, int n) {
+   double h = (b-a)/n;
+   ksum_t area;
+   int    i;
+
+   Ksum_init(&area);
+   Ksum_add(&area, f(a));
+   Ksum_add(&area, f(b));
+   for (i = 1; i <= n-1; i++)
+      Ksum_add(&area, (i % 2 == 0 ? 2 : 4)*f(a + i*h));
+   return Ksum_value(&area)*h/3;
+}  /* Simpson */
+
+
+/*------------------------------------------------------------------
+ * Function:     f
+ * Purpose:     Compute value of function to be integrated:  x*x + 1,
+ *               as in trap.c, plus a Lorentzian spike at SPIKE_X with
+ *               area about pi
+ * Input args:   x
+ */
+double f(double x) {
+   double return_val;
+   double s = x - SPIKE_X;
+
+   return_val = x*x + 1 + SPIKE_W/(s*s + SPIKE_W*SPIKE_W);
+   return return_val;
+}  /* f */
@@ -0,0 +1,58 @@
+/* File:     ksum.c
+ * Author:   Cayla Shaver
+ * Purpose:  Compensated summation (see ksum.h).
+ *
+ * Compile:  link with the caller, e.g.
+ *           gcc -g -Wall -O2 -I.. -o pth_trap pth_trap.c ksum.c -lpthread
+ *              -lm
+ */
+#include <math.h>
+#include "ksum.h"
+
+/*------------------------------------------------------------------
+ * Function:    Ksum_init
+ * Purpose:     Set a sum to 0
+ * Out arg:     s
+ */
+void Ksum_init(ksum_t* s) {
+   s->sum = s->comp = 0.0;
+}  /* Ksum_init */
+
+
+/*------------------------------------------------------------------
+ * Function:    Ksum_add
+ * Purpose:     Add x to the sum, keeping the rounding error
+ * In arg:      x
+ * In/out arg:  s
+ */
+void Ksum_add(ksum_t* s, double x) {
+   double t = s->sum + x;
+
+   if (fabs(s->sum) >= fabs(x))
+      s->comp += (s->sum - t) + x;
+   else
+      s->comp += (x - t) + s->sum;
+   s->sum = t;
+}  /* Ksum_add */
+
+
+/*------------------------------------------------------------------
+ * Function:    Ksum_merge
+ * Purpose:     Add the sum t to the sum s
+ * In arg:      t
+ * In/out arg:  s
+ */
+void Ksum_merge(ksum_t* s, const ksum_t* t) {
+   Ksum_add(s, t->sum);
+   s->comp += t->comp;
+}  /* Ksum_merge */
+
+
+/*------------------------------------------------------------------
+ * Function:    Ksum_value
+ * Purpose:     Return the compensated value of the sum
+ * In arg:      s
+ */
+double Ksum_value(const ksum_t* s) {
+   return s->sum + s->comp;
+}  /* Ksum_value */
@@ -0,0 +1,33 @@
+/* File:     ksum.h
+ * Author:   Cayla Shaver
+ * Purpose:  Compensated (Kahan-Babuska-Neumaier) summation, so long
+ *           sums and sums combined in a different order (e.g. by
+ *           several threads or processes) agree to within rounding of
+ *           the final result.
+ *
+ * Example:
+ *    #include "ksum.h"
+ *    . . .
+ *    ksum_t s;
+ *    Ksum_init(&s);
+ *    for (i = 0; i < n; i++)
+ *       Ksum_add(&s, x[i]);
+ *    total = Ksum_value(&s);
+ *
+ * Note:     Don't compile with -ffast-math:  it lets the compiler
+ *           optimize the compensation away.
+ */
+#ifndef _KSUM_H_
+#define _KSUM_H_
+
+typedef struct {
+   double sum;    /* Running sum                          */
+   double comp;   /* Running sum of the rounding errors   */
+} ksum_t;
+
+void   Ksum_init(ksum_t* s);
+void   Ksum_add(ksum_t* s, double x);
+void   Ksum_merge(ksum_t* s, const ksum_t* t);
+double Ksum_value(const ksum_t* s);
+
+#endif
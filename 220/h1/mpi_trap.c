@@ -0,0 +1,193 @@
+/* File:    mpi_trap.c
+ * Author:  Cayla Shaver
+ * Purpose: Calculate area using the trapezoidal rule and Simpson's
+ *          rule with MPI.
+ *
+ * Input:   a, b, n
+ * Output:  estimates of area between x-axis, x = a, x = b, and graph
+ *          of f(x) using n subintervals, and the elapsed times.
+ *
+ * Compile: mpicc -g -Wall -O2 -o mpi_trap mpi_trap.c ksum.c -lm
+ * Run:     mpiexec -n <number of processes> ./mpi_trap
+ *
+ * Notes:
+ *    1.  The function f(x) is hardwired.
+ *    2.  n is a long, so it can be in the billions.  n must be even
+ *        for Simpson's rule.
+ *    3.  Each process gets a block of the points 1..n-1 and adds up
+ *        their weighted f values with compensated summation (ksum.c).
+ *    4.  The partial sums, with their compensation terms, are combined
+ *        on process 0 with tree structured communication:  the
+ *        processes are paired with bitwise exclusive or, the lower
+ *        ranked process of each pair receives and the higher one
+ *        sends and drops out.  This works for any number of processes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+#include "ksum.h"
+
+double f(double x);    /* Function we're integrating */
+ksum_t Local_sum(double a, double h, long n, int simpson, int my_rank,
+      int p);
+ksum_t Tree_sum(ksum_t my_sum, int my_rank, int p, MPI_Comm comm);
+double Integrate(double a, double b, long n, int simpson, int my_rank,
+      int p, MPI_Comm comm);
+
+int main(void) {
+   int      p, my_rank;
+   MPI_Comm comm;
+   double   a, b, area, start, finish;
+   long     n;
+
+   MPI_Init(NULL, NULL);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   if (my_rank == 0) {
+      printf("Enter a, b, and n\n");
+      scanf("%lf", &a);
+      scanf("%lf", &b);
+      scanf("%ld", &n);
+   }
+   MPI_Bcast(&a, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(&b, 1, MPI_DOUBLE, 0, comm);
+   MPI_Bcast(&n, 1, MPI_LONG, 0, comm);
+
+   MPI_Barrier(comm);
+   start = MPI_Wtime();
+   area = Integrate(a, b, n, 0, my_rank, p, comm);
+   finish = MPI_Wtime();
+   if (my_rank == 0) {
+      printf("With n = %ld trapezoids and %d processes, our estimate\n",
+            n, p);
+      printf("of the area from %f to %f = %.15e\n", a, b, area);
+      printf("Elapsed time = %e seconds\n", finish - start);
+   }
+
+   if (n % 2 == 0) {
+      MPI_Barrier(comm);
+      start = MPI_Wtime();
+      area = Integrate(a, b, n, 1, my_rank, p, comm);
+      finish = MPI_Wtime();
+      if (my_rank == 0) {
+         printf("With n = %ld for Simpson's rule, our estimate\n", n);
+         printf("of the area from %f to %f = %.15e\n", a, b, area);
+         printf("Elapsed time = %e seconds\n", finish - start);
+      }
+   } else if (my_rank == 0) {
+      printf("n is odd, so Simpson's rule wasn't used\n");
+   }
+
+   MPI_Finalize();
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:     Integrate
+ * Purpose:      Estimate the area with the trapezoidal rule or
+ *               Simpson's rule
+ * Input args:   a, b, n, simpson, my_rank, p, comm
+ * Return val:   The estimate:  valid only on process 0
+ */
+double Integrate(double a, double b, long n, int simpson, int my_rank,
+      int p, MPI_Comm comm) {
+   double h = (b-a)/n;
+   ksum_t total;
+
+   total = Local_sum(a, h, n, simpson, my_rank, p);
+   total = Tree_sum(total, my_rank, p, comm);
+   if (simpson) {
+      Ksum_add(&total, f(a));
+      Ksum_add(&total, f(b));
+      return Ksum_value(&total)*h/3;
+   } else {
+      Ksum_add(&total, f(a)/2.0);
+      Ksum_add(&total, f(b)/2.0);
+      return Ksum_value(&total)*h;
+   }
+}  /* Integrate */
+
+
+/*------------------------------------------------------------------
+ * Function:     Local_sum
+ * Purpose:      Add up the weighted f values at this process's block
+ *               of the points 1..n-1
+ * Input args:   a, h, n, simpson, my_rank, p
+ * Return val:   compensated sum
+ */
+ksum_t Local_sum(double a, double h, long n, int simpson, int my_rank,
+      int p) {
+   long   points = n - 1;
+   long   first = 1 + my_rank*points/p;
+   long   last = 1 + (my_rank + 1)*points/p;
+   long   i;
+   ksum_t my_sum;
+
+   Ksum_init(&my_sum);
+   for (i = first; i < last; i++) {
+      if (!simpson)
+         Ksum_add(&my_sum, f(a + i*h));
+      else if (i % 2 == 0)
+         Ksum_add(&my_sum, 2*f(a + i*h));
+      else
+         Ksum_add(&my_sum, 4*f(a + i*h));
+   }
+   return my_sum;
+}  /* Local_sum */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Tree_sum
+ * Purpose:     Combine the processes' compensated sums on process 0
+ * Input args:  my_sum = process's partial sum
+ *              my_rank = process's rank
+ *              p = number of processes
+ *              comm = communicator
+ * Return val:  the total:  valid only on process 0
+ *
+ * Note:        A ksum_t is sent as two doubles, the sum and its
+ *              compensation.
+ */
+ksum_t Tree_sum(ksum_t my_sum, int my_rank, int p, MPI_Comm comm) {
+   int      partner;
+   int      done = 0;
+   unsigned bitmask = 1;
+   double   buf[2];
+   ksum_t   your_sum;
+
+   while (!done && bitmask < p) {
+      partner = my_rank ^ bitmask;
+      if (my_rank < partner) {
+         if (partner < p) {
+            MPI_Recv(buf, 2, MPI_DOUBLE, partner, 0, comm,
+                  MPI_STATUS_IGNORE);
+            your_sum.sum = buf[0];
+            your_sum.comp = buf[1];
+            Ksum_merge(&my_sum, &your_sum);
+         }
+         bitmask <<= 1;
+      } else {
+         buf[0] = my_sum.sum;
+         buf[1] = my_sum.comp;
+         MPI_Send(buf, 2, MPI_DOUBLE, partner, 0, comm);
+         done = 1;
+      }
+   }
+   return my_sum;
+}  /* Tree_sum */
+
+
+/*------------------------------------------------------------------
+ * Function:    f
+ * Purpose:     Compute value of function to be integrated
+ * Input args:  x
+ */
+double f(double x) {
+   double return_val;
+
+   return_val = x*x + 1;
+   return return_val;
+}  /* f */
@@ -0,0 +1,220 @@
+/* File:    pth_trap.c
+ * Author:  Cayla Shaver
+ * Purpose: Calculate area using the trapezoidal rule and Simpson's
+ *          rule with Pthreads.
+ *
+ * Input:   a, b, n
+ * Output:  estimates of area between x-axis, x = a, x = b, and graph
+ *          of f(x) using n subintervals, from the threads and from a
+ *          serial compensated sum, and the elapsed times.
+ *
+ * Compile: gcc -g -Wall -O2 -I.. -o pth_trap pth_trap.c ksum.c -lpthread
+ *             -lm
+ * Run:     ./pth_trap <thread_count>
+ *
+ * Notes:
+ *    1.  The function f(x) is hardwired.
+ *    2.  n is a long, so it can be in the billions.  n must be even
+ *        for Simpson's rule.
+ *    3.  Each thread gets a block of the points 1..n-1 and adds up
+ *        their weighted f values with compensated summation (ksum.c).
+ *        The partial sums are combined with a tree:  at stage s,
+ *        thread q adds in the sum of thread q + s if q is a multiple
+ *        of 2s, and then the threads meet at a barrier.
+ *    4.  The points are computed as a + i*h, as in trap.c, so every
+ *        thread count evaluates f at exactly the same points and the
+ *        results agree with the serial sum to within an ulp or so.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "timer.h"
+#include "ksum.h"
+
+/* Global variables:  shared by the threads */
+int     thread_count;
+double  a, b, h;
+long    n;
+int     simpson;          /* 0:  trapezoids, 1:  Simpson's rule */
+ksum_t* partial;          /* One partial sum per thread         */
+pthread_barrier_t barrier;
+
+double f(double x);    /* Function we're integrating */
+void*  Thread_sum(void* rank);
+double Pth_integrate(int use_simpson);
+double Serial_integrate(int use_simpson);
+double Ulps(double x, double y);
+
+int main(int argc, char* argv[]) {
+   double start, finish;
+   double area, serial;
+
+   if (argc != 2 || (thread_count = strtol(argv[1], NULL, 10)) <= 0) {
+      fprintf(stderr, "usage: %s <thread_count>\n", argv[0]);
+      exit(0);
+   }
+
+   printf("Enter a, b, and n\n");
+   scanf("%lf", &a);
+   scanf("%lf", &b);
+   scanf("%ld", &n);
+   h = (b-a)/n;
+
+   partial = malloc(thread_count*sizeof(ksum_t));
+   pthread_barrier_init(&barrier, NULL, thread_count);
+
+   GET_TIME(start);
+   area = Pth_integrate(0);
+   GET_TIME(finish);
+   serial = Serial_integrate(0);
+   printf("With n = %ld trapezoids and %d threads, our estimate\n",
+         n, thread_count);
+   printf("of the area from %f to %f = %.15e\n", a, b, area);
+   printf("Serial compensated sum          = %.15e (%.1f ulps)\n",
+         serial, Ulps(area, serial));
+   printf("Elapsed time = %e seconds\n", finish - start);
+
+   if (n % 2 == 0) {
+      GET_TIME(start);
+      area = Pth_integrate(1);
+      GET_TIME(finish);
+      serial = Serial_integrate(1);
+      printf("With n = %ld for Simpson's rule, our estimate\n", n);
+      printf("of the area from %f to %f = %.15e\n", a, b, area);
+      printf("Serial compensated sum          = %.15e (%.1f ulps)\n",
+            serial, Ulps(area, serial));
+      printf("Elapsed time = %e seconds\n", finish - start);
+   } else {
+      printf("n is odd, so Simpson's rule wasn't used\n");
+   }
+
+   pthread_barrier_destroy(&barrier);
+   free(partial);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:     Pth_integrate
+ * Purpose:      Start the threads and return their estimate
+ * In arg:       use_simpson
+ * Globals:      a, b, n, h, thread_count (in), simpson (out)
+ * Return val:   Trapezoidal or Simpson's rule estimate of the area
+ */
+double Pth_integrate(int use_simpson) {
+   pthread_t* thread_handles = malloc(thread_count*sizeof(pthread_t));
+   long       thread;
+   ksum_t     total;
+
+   simpson = use_simpson;
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Thread_sum,
+            (void*) thread);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+   free(thread_handles);
+
+   /* The tree leaves the total in partial[0] */
+   total = partial[0];
+   if (simpson) {
+      Ksum_add(&total, f(a));
+      Ksum_add(&total, f(b));
+      return Ksum_value(&total)*h/3;
+   } else {
+      Ksum_add(&total, f(a)/2.0);
+      Ksum_add(&total, f(b)/2.0);
+      return Ksum_value(&total)*h;
+   }
+}  /* Pth_integrate */
+
+
+/*------------------------------------------------------------------
+ * Function:     Thread_sum
+ * Purpose:      Add up the weighted f values at this thread's block
+ *               of points, then take part in the tree reduction
+ * In arg:       rank
+ * Globals:      a, h, n, simpson, thread_count (in), partial (in/out)
+ */
+void* Thread_sum(void* rank) {
+   long   my_rank = (long) rank;
+   long   points = n - 1;
+   long   first = 1 + my_rank*points/thread_count;
+   long   last = 1 + (my_rank + 1)*points/thread_count;
+   long   i;
+   int    stride;
+   ksum_t my_sum;
+
+   Ksum_init(&my_sum);
+   for (i = first; i < last; i++) {
+      if (!simpson)
+         Ksum_add(&my_sum, f(a + i*h));
+      else if (i % 2 == 0)
+         Ksum_add(&my_sum, 2*f(a + i*h));
+      else
+         Ksum_add(&my_sum, 4*f(a + i*h));
+   }
+   partial[my_rank] = my_sum;
+   pthread_barrier_wait(&barrier);
+
+   for (stride = 1; stride < thread_count; stride *= 2) {
+      if (my_rank % (2*stride) == 0 && my_rank + stride < thread_count)
+         Ksum_merge(&partial[my_rank], &partial[my_rank + stride]);
+      pthread_barrier_wait(&barrier);
+   }
+
+   return NULL;
+}  /* Thread_sum */
+
+
+/*------------------------------------------------------------------
+ * Function:     Serial_integrate
+ * Purpose:      Serial version of the same rule with one compensated
+ *               sum, for checking the threads' result
+ * In arg:       use_simpson
+ * Globals:      a, b, n, h (in)
+ */
+double Serial_integrate(int use_simpson) {
+   ksum_t sum;
+   long   i;
+
+   Ksum_init(&sum);
+   if (use_simpson) {
+      Ksum_add(&sum, f(a));
+      Ksum_add(&sum, f(b));
+      for (i = 1; i <= n-1; i++)
+         Ksum_add(&sum, (i % 2 == 0 ? 2 : 4)*f(a + i*h));
+      return Ksum_value(&sum)*h/3;
+   } else {
+      Ksum_add(&sum, f(a)/2.0);
+      Ksum_add(&sum, f(b)/2.0);
+      for (i = 1; i <= n-1; i++)
+         Ksum_add(&sum, f(a + i*h));
+      return Ksum_value(&sum)*h;
+   }
+}  /* Serial_integrate */
+
+
+/*------------------------------------------------------------------
+ * Function:    Ulps
+ * Purpose:     Distance between x and y in units of the last place
+ *              of y
+ */
+double Ulps(double x, double y) {
+   double ulp = nextafter(fabs(y), INFINITY) - fabs(y);
+
+   return fabs(x - y)/ulp;
+}  /* Ulps */
+
+
+/*------------------------------------------------------------------
+ * Function:    f
+ * Purpose:     Compute value of function to be integrated
+ * Input args:  x
+ */
+double f(double x) {
+   double return_val;
+
+   return_val = x*x + 1;
+   return return_val;
+}  /* f */
@@ -6,21 +6,44 @@
  * Output:  estimate of area between x-axis, x = a, x = b, and graph of f(x)
  *          using n trapezoids.
  *
- * Compile: gcc -g -Wall -o trap trap.c
+ * Compile: gcc -g -Wall -O3 -march=native -I.. -o trap trap.c
  * Run:     ./trap
  *
- * Note:    The function f(x) is hardwired.
+ * Notes:
+ *    1.  The function f(x) is hardwired.
+ *    2.  Trap_batch and Simpson_batch are the same rules, but they
+ *        evaluate the integrand with f_batch on blocks of BATCH
+ *        points.  f_batch is a plain loop over contiguous arrays, so
+ *        it vectorizes, and Simpson_batch adds up the odd and even
+ *        points in two separate strided passes instead of testing
+ *        i % 2 in the loop.  The partial sums are kept in ACC
+ *        independent accumulators so the additions vectorize too.
+ *    3.  Each rule is timed, and the batch versions are compared with
+ *        the scalar ones.
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <math.h>
+#include "timer.h"
+
+#define BATCH 512   /* Points per call to f_batch            */
+#define ACC   8     /* Independent accumulators in Sum_block */
 
 double Trap(double  a, double  b, int n, double h);
 double f(double x);    /* Function we're integrating */
 double Simpson(double a, double b, int n, double h);
+void   f_batch(const double* x, double* y, size_t n);
+double Sum_points(double x0, double step, long count);
+double Sum_block(const double* y, size_t n);
+double Trap_batch(double a, double b, int n, double h);
+double Simpson_batch(double a, double b, int n, double h);
 
 int main(void) {
    double  area, areaS;       /* Store result in area       */
+   double  areaB, areaSB;     /* Batch versions             */
+   double  start, finish;
+   double  t_trap, t_simp, t_trap_b, t_simp_b;
    double  a, b;       /* Left and right endpoints   */
    int     n;          /* Number of trapezoids       */
    double  h;          /* Trapezoid base width       */
@@ -31,8 +54,22 @@ int main(void) {
    scanf("%d", &n);
    
    h = (b-a)/n;
+   GET_TIME(start);
    area = Trap(a, b, n, h);
+   GET_TIME(finish);
+   t_trap = finish - start;
+   GET_TIME(start);
    areaS = Simpson(a, b, n, h);
+   GET_TIME(finish);
+   t_simp = finish - start;
+   GET_TIME(start);
+   areaB = Trap_batch(a, b, n, h);
+   GET_TIME(finish);
+   t_trap_b = finish - start;
+   GET_TIME(start);
+   areaSB = Simpson_batch(a, b, n, h);
+   GET_TIME(finish);
+   t_simp_b = finish - start;
 
    printf("With n = %d trapezoids, our estimate\n", n);
    printf("of the area from %f to %f = %.15f\n",
@@ -40,10 +77,17 @@ int main(void) {
 
    printf("With n = %d for Simpson's rule, our estimate\n", n);
    printf("of the area from %f to %f = %.15f\n",
-      a, b, area);
+      a, b, areaS);
+
+   printf("Batch trapezoids = %.15f, Simpson's rule = %.15f\n",
+      areaB, areaSB);
+   printf("Trapezoids:      %e seconds scalar, %e seconds batch (%.1fx)\n",
+      t_trap, t_trap_b, t_trap/t_trap_b);
+   printf("Simpson's rule:  %e seconds scalar, %e seconds batch (%.1fx)\n",
+      t_simp, t_simp_b, t_simp/t_simp_b);
 
    printf("The absolute value of the difference\n");
-   printf("between the trapezoids and Simpson's rule is %e", fabs(area - areaS));
+   printf("between the trapezoids and Simpson's rule is %e\n", fabs(area - areaS));
 
 
    return 0;
@@ -118,4 +162,97 @@ double Simpson(double a, double b, int n, double h) {
 
     return area;
 
-} /*  Simpson  */
\ No newline at end of file
+} /*  Simpson  */
+
+/*------------------------------------------------------------------
+ * Function:     f_batch
+ * Purpose:      Compute f at each of n points
+ * Input args:   x: the points
+ *               n: number of points
+ * Output arg:   y: y[i] = f(x[i])
+ */
+void f_batch(const double* restrict x, double* restrict y, size_t n) {
+   size_t i;
+
+   for (i = 0; i < n; i++)
+      y[i] = x[i]*x[i] + 1;
+}  /* f_batch */
+
+
+/*------------------------------------------------------------------
+ * Function:     Sum_block
+ * Purpose:      Add up n values with ACC independent accumulators
+ * Input args:   y, n
+ */
+double Sum_block(const double* y, size_t n) {
+   double acc[ACC] = {0.0};
+   double sum = 0.0;
+   size_t i, j;
+
+   for (i = 0; i + ACC <= n; i += ACC)
+      for (j = 0; j < ACC; j++)
+         acc[j] += y[i+j];
+   for (; i < n; i++)
+      sum += y[i];
+   for (j = 0; j < ACC; j++)
+      sum += acc[j];
+   return sum;
+}  /* Sum_block */
+
+
+/*------------------------------------------------------------------
+ * Function:     Sum_points
+ * Purpose:      Add up f at the count points x0, x0 + step,
+ *               x0 + 2*step, ..., BATCH points at a time
+ * Input args:   x0, step, count
+ */
+double Sum_points(double x0, double step, long count) {
+   double x[BATCH], y[BATCH];
+   double sum = 0.0;
+   long   first, i, len;
+
+   for (first = 0; first < count; first += BATCH) {
+      len = (count - first < BATCH) ? count - first : BATCH;
+      for (i = 0; i < len; i++)
+         x[i] = x0 + (first + i)*step;
+      f_batch(x, y, len);
+      sum += Sum_block(y, len);
+   }
+   return sum;
+}  /* Sum_points */
+
+
+/*------------------------------------------------------------------
+ * Function:     Trap_batch
+ * Purpose:      Estimate area using the trapezoidal rule, evaluating
+ *               f with f_batch
+ * Input args:   a, b, n, h:  as in Trap
+ * Return val:   Trapezoidal rule estimate
+ */
+double Trap_batch(double a, double b, int n, double h) {
+   double area;
+
+   area = (f(a) + f(b))/2.0;
+   area += Sum_points(a + h, h, n - 1);
+   return area*h;
+} /*  Trap_batch  */
+
+
+/*------------------------------------------------------------------
+ * Function:     Simpson_batch
+ * Purpose:      Estimate area using Simpson's rule, evaluating f with
+ *               f_batch, with the odd and even points in separate
+ *               passes
+ * Input args:   a, b, n, h:  as in Simpson
+ * Return val:   Simpson's rule estimate
+ *
+ * Note:         The odd points are a + h, a + 3h, ..., and the even
+ *               (interior) points are a + 2h, a + 4h, ...
+ */
+double Simpson_batch(double a, double b, int n, double h) {
+   double odd, even;
+
+   odd = Sum_points(a + h, 2*h, n/2);
+   even = Sum_points(a + 2*h, 2*h, (n - 1)/2);
+   return (f(a) + f(b) + 4*odd + 2*even)*h/3;
+} /*  Simpson_batch  */
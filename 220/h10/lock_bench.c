@@ -0,0 +1,486 @@
+/* File:     lock_bench.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ *
+ * Purpose:  Measure how locks behave under contention.  This does what
+ *           many_mutexes.c and semaphores.c do (threads take a lock and
+ *           add to total), but for every kind of lock, and with a
+ *           critical section and think time of any length.
+ *
+ * Compile:  gcc -g -Wall -O2 -I.. -o lock_bench lock_bench.c locks.c
+ *              ../numa_rt.c -lpthread
+ * Run:      ./lock_bench <max threads> [ms [cs list [think list [locks]]]]
+ *              max threads:  runs with 1, 2, 4, ... threads, and
+ *                 max threads
+ *              ms:  length of each run in milliseconds (default 200)
+ *              cs list:  critical section lengths, e.g. 0,100,1000
+ *                 (default 0,100)
+ *              think list:  think times, e.g. 0,1000 (default 0,1000)
+ *              locks:  the kinds of lock to run, e.g. mutex,mcs
+ *                 (default all of them)
+ *
+ * Input:    none
+ * Output:   One CSV line per (lock, threads, cs, think):
+ *              lock,threads,cs,think,seconds,ops,ops_per_s,jain,
+ *              min_share,max_share,p50_ns,p90_ns,p99_ns,max_ns,correct,
+ *              counts
+ *
+ * Notes:
+ *    1.  The locks are
+ *           mutex:     pthread_mutex_t with the default attributes
+ *           adaptive:  PTHREAD_MUTEX_ADAPTIVE_NP (spins a while before
+ *                      it sleeps)
+ *           spin:      pthread_spinlock_t
+ *           ticket:    Ticket_lock (locks.c), with proportional
+ *                      backoff
+ *           mcs:       Mcs_lock (locks.c)
+ *           clh:       Clh_lock (locks.c)
+ *           sem:       sem_t, as in semaphores.c
+ *           atomic:    no lock:  every update of the shared data is an
+ *                      atomic fetch-and-add
+ *    2.  Critical section of length cs:  total++ and cs increments of
+ *        shared.  Think time of length think:  think increments of a
+ *        local volatile, outside the lock.  Both are in loop
+ *        iterations, not seconds, so they're the same for every lock.
+ *    3.  A run lasts ms milliseconds:  the threads start together at a
+ *        barrier and go until main sets stop.  So a thread that gets
+ *        the lock less often does fewer operations, and the counts
+ *        show it.  Fairness is Jain's index (sum c)^2/(p sum c^2) of
+ *        the per-thread counts c, which is 1 when they're all equal
+ *        and 1/p when one thread does everything, and the smallest
+ *        and largest count divided by the average.
+ *    4.  Latency is the time from asking for the lock to getting it.
+ *        Every SAMPLE_EVERY-th operation of each thread is a
+ *        candidate, and each thread keeps a uniform random sample of
+ *        MAX_SAMPLES of its candidates from the whole run (reservoir
+ *        sampling:  candidate s replaces a random entry with
+ *        probability MAX_SAMPLES/(s+1)), so long runs aren't just
+ *        reporting their warm-up.  Only the candidates that will be
+ *        kept are timed.
+ *    5.  correct is "yes" if total and shared come out equal to the
+ *        sum of the counts and cs times that.
+ *    6.  Thread r is pinned with Numa_pin(r) (../numa_rt.c).  With
+ *        more threads than cores, the spinning locks depend on
+ *        Spin_pause's sched_yield (locks.c, note 5).
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "timer.h"
+#include "numa_rt.h"
+#include "locks.h"
+
+#define SAMPLE_EVERY 16
+#define MAX_SAMPLES 65536
+#define MAX_LIST 32
+
+typedef enum {MUTEX, ADAPTIVE, SPIN, TICKET, MCS, CLH, SEM, ATOMIC,
+   LOCK_COUNT} lock_kind_t;
+const char* lock_names[] = {"mutex", "adaptive", "spin", "ticket", "mcs",
+   "clh", "sem", "atomic"};
+
+typedef struct {
+   long  count;         /* Operations done      */
+   long  sample_count;  /* Latencies stored     */
+   long* samples;       /* Latencies in ns      */
+   char  pad[CACHE_LINE - 2*sizeof(long) - sizeof(long*)];
+} result_t;
+
+/* Shared by the threads of a run */
+lock_kind_t        kind;
+int                thread_count;
+long               cs;
+long               think;
+volatile int       stop;
+long               total;
+volatile long      shared;
+pthread_barrier_t  barrier;
+result_t*          results;
+pthread_mutex_t    mutex;
+pthread_spinlock_t spin;
+ticket_lock_t      ticket;
+mcs_lock_t         mcs;
+clh_lock_t         clh;
+sem_t              semi;
+
+void   Usage(char prog_name[]);
+int    Get_list(char* s, long list[]);
+void   Run(lock_kind_t k, int threads, long cs_len, long think_len,
+          int ms);
+void   Init_lock(lock_kind_t k);
+void   Destroy_lock(lock_kind_t k);
+void*  Lock_and_unlock(void* rank);
+long   Reservoir_slot(long s, unsigned long* seed_p);
+long   Now_ns(void);
+int    Compare_long(const void* a, const void* b);
+void   Print_row(double secs, long samples[], long sample_count);
+
+/*--------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int   max_threads, ms = 200, threads, last, cs_n, think_n, i, j, k;
+   long  cs_list[MAX_LIST] = {0, 100};
+   long  think_list[MAX_LIST] = {0, 1000};
+   int   run_lock[LOCK_COUNT];
+   char* name;
+
+   if (argc < 2 || argc > 6) Usage(argv[0]);
+   max_threads = strtol(argv[1], NULL, 10);
+   if (argc >= 3) ms = strtol(argv[2], NULL, 10);
+   cs_n = (argc >= 4) ? Get_list(argv[3], cs_list) : 2;
+   think_n = (argc >= 5) ? Get_list(argv[4], think_list) : 2;
+   if (max_threads <= 0 || ms <= 0 || cs_n <= 0 || think_n <= 0)
+      Usage(argv[0]);
+   for (k = 0; k < LOCK_COUNT; k++)
+      run_lock[k] = (argc < 6);
+   if (argc == 6)
+      for (name = strtok(argv[5], ","); name != NULL;
+            name = strtok(NULL, ",")) {
+         for (k = 0; k < LOCK_COUNT; k++)
+            if (strcmp(name, lock_names[k]) == 0) break;
+         if (k == LOCK_COUNT) Usage(argv[0]);
+         run_lock[k] = 1;
+      }
+
+   printf("lock,threads,cs,think,seconds,ops,ops_per_s,jain,min_share,"
+         "max_share,p50_ns,p90_ns,p99_ns,max_ns,correct,counts\n");
+   for (k = 0; k < LOCK_COUNT; k++) {
+      if (!run_lock[k]) continue;
+      last = 0;
+      for (threads = 1; last < max_threads; threads *= 2) {
+         if (threads > max_threads) threads = max_threads;
+         for (i = 0; i < cs_n; i++)
+            for (j = 0; j < think_n; j++)
+               Run(k, threads, cs_list[i], think_list[j], ms);
+         last = threads;
+         fflush(stdout);
+      }
+   }
+
+   return 0;
+}  /* main */
+
+/*---------------------------------------------------------------------
+ * Function:   Usage
+ * Purpose:    Print a message explaining how to start the program.
+ *             Then quit.
+ * In arg:     prog_name:  name of program from command line
+ */
+void Usage(char prog_name[]) {
+   int k;
+
+   fprintf(stderr, "usage: %s <max threads> [ms [cs list [think list "
+         "[locks]]]]\n", prog_name);
+   fprintf(stderr, "    ms:  length of each run in milliseconds\n");
+   fprintf(stderr, "    cs list, think list:  comma separated loop "
+         "lengths, e.g. 0,100,1000\n");
+   fprintf(stderr, "    locks:  comma separated, from");
+   for (k = 0; k < LOCK_COUNT; k++)
+      fprintf(stderr, " %s", lock_names[k]);
+   fprintf(stderr, "\n");
+   exit(0);
+}  /* Usage */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Get_list
+ * Purpose:    Parse a comma separated list of at most MAX_LIST
+ *             nonnegative longs
+ * In arg:     s
+ * Out arg:    list
+ * Ret val:    Number of entries, or 0 if s is bad
+ */
+int Get_list(char* s, long list[]) {
+   int   count = 0;
+   char* end;
+
+   while (*s != '\0' && count < MAX_LIST) {
+      list[count] = strtol(s, &end, 10);
+      if (end == s || list[count] < 0) return 0;
+      count++;
+      s = end;
+      if (*s == ',') s++;
+   }
+   return (*s == '\0') ? count : 0;
+}  /* Get_list */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Run
+ * Purpose:    Time threads threads taking lock k for ms milliseconds,
+ *             and print the CSV line
+ * In args:    k, threads, cs_len, think_len, ms
+ * Globals:    all of the shared ones (out)
+ */
+void Run(lock_kind_t k, int threads, long cs_len, long think_len, int ms) {
+   pthread_t* thread_handles;
+   long       thread, sample_count = 0;
+   long*      samples;
+   double     start, finish;
+
+   kind = k;
+   thread_count = threads;
+   cs = cs_len;
+   think = think_len;
+   stop = 0;
+   total = 0;
+   shared = 0;
+   Init_lock(k);
+   pthread_barrier_init(&barrier, NULL, threads + 1);
+   thread_handles = malloc(threads*sizeof(pthread_t));
+   if (posix_memalign((void**) &results, CACHE_LINE,
+            threads*sizeof(result_t)) != 0) {
+      fprintf(stderr, "Can't allocate results\n");
+      exit(1);
+   }
+
+   for (thread = 0; thread < threads; thread++)
+      pthread_create(&thread_handles[thread], NULL, Lock_and_unlock,
+            (void*) thread);
+   pthread_barrier_wait(&barrier);
+   GET_TIME(start);
+   usleep(ms*1000L);
+   __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+   for (thread = 0; thread < threads; thread++)
+      pthread_join(thread_handles[thread], NULL);
+   GET_TIME(finish);
+
+   for (thread = 0; thread < threads; thread++)
+      sample_count += results[thread].sample_count;
+   samples = malloc((sample_count > 0 ? sample_count : 1)*sizeof(long));
+   sample_count = 0;
+   for (thread = 0; thread < threads; thread++) {
+      memcpy(samples + sample_count, results[thread].samples,
+            results[thread].sample_count*sizeof(long));
+      sample_count += results[thread].sample_count;
+      free(results[thread].samples);
+   }
+   qsort(samples, sample_count, sizeof(long), Compare_long);
+   Print_row(finish - start, samples, sample_count);
+
+   free(samples);
+   free(results);
+   free(thread_handles);
+   pthread_barrier_destroy(&barrier);
+   Destroy_lock(k);
+}  /* Run */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Init_lock
+ * Purpose:    Initialize lock k (note 1)
+ */
+void Init_lock(lock_kind_t k) {
+   pthread_mutexattr_t attr;
+
+   switch (k) {
+      case MUTEX:
+         pthread_mutex_init(&mutex, NULL);
+         break;
+      case ADAPTIVE:
+         pthread_mutexattr_init(&attr);
+         pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+         pthread_mutex_init(&mutex, &attr);
+         pthread_mutexattr_destroy(&attr);
+         break;
+      case SPIN:
+         pthread_spin_init(&spin, PTHREAD_PROCESS_PRIVATE);
+         break;
+      case TICKET:
+         Ticket_init(&ticket);
+         break;
+      case MCS:
+         Mcs_init(&mcs);
+         break;
+      case CLH:
+         Clh_init(&clh);
+         break;
+      case SEM:
+         sem_init(&semi, 0, 1);
+         break;
+      default:
+         break;
+   }
+}  /* Init_lock */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Destroy_lock
+ * Purpose:    Free the resources used by lock k
+ */
+void Destroy_lock(lock_kind_t k) {
+   if (k == MUTEX || k == ADAPTIVE)
+      pthread_mutex_destroy(&mutex);
+   else if (k == SPIN)
+      pthread_spin_destroy(&spin);
+   else if (k == CLH)
+      Clh_destroy(&clh);
+   else if (k == SEM)
+      sem_destroy(&semi);
+}  /* Destroy_lock */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Lock_and_unlock
+ * Purpose:    Thread function:  take the lock, do the critical section,
+ *             let go, think, until stop is set (notes 2-4)
+ * In arg:     rank:  thread rank
+ * In globals: kind, cs, think, stop
+ * In/out globals:  total, shared, the locks
+ * Out global: results[rank]
+ */
+void* Lock_and_unlock(void* rank) {
+   long          my_rank = (long) rank;
+   result_t*     me = &results[my_rank];
+   volatile long local = 0;
+   long          count = 0, sample_count = 0, t0 = 0, i, slot = 0;
+   long*         samples = malloc(MAX_SAMPLES*sizeof(long));
+   unsigned long seed = 0x9e3779b97f4a7c15UL*(my_rank + 1);
+   int           timed;
+
+   Numa_pin(my_rank);
+   pthread_barrier_wait(&barrier);
+
+   while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+      timed = 0;
+      if (count % SAMPLE_EVERY == 0) {
+         slot = Reservoir_slot(count/SAMPLE_EVERY, &seed);
+         timed = (slot >= 0);
+      }
+      if (timed) t0 = Now_ns();
+      switch (kind) {
+         case MUTEX:
+         case ADAPTIVE: pthread_mutex_lock(&mutex);  break;
+         case SPIN:     pthread_spin_lock(&spin);    break;
+         case TICKET:   Ticket_lock(&ticket);        break;
+         case MCS:      Mcs_lock(&mcs);              break;
+         case CLH:      Clh_lock(&clh);              break;
+         case SEM:      sem_wait(&semi);             break;
+         default:                                    break;
+      }
+      if (timed) {
+         samples[slot] = Now_ns() - t0;
+         if (slot == sample_count) sample_count++;
+      }
+
+      if (kind == ATOMIC) {
+         __atomic_fetch_add(&total, 1, __ATOMIC_RELAXED);
+         for (i = 0; i < cs; i++)
+            __atomic_fetch_add(&shared, 1, __ATOMIC_RELAXED);
+      } else {
+         total++;
+         for (i = 0; i < cs; i++)
+            shared++;
+      }
+
+      switch (kind) {
+         case MUTEX:
+         case ADAPTIVE: pthread_mutex_unlock(&mutex); break;
+         case SPIN:     pthread_spin_unlock(&spin);   break;
+         case TICKET:   Ticket_unlock(&ticket);       break;
+         case MCS:      Mcs_unlock(&mcs);             break;
+         case CLH:      Clh_unlock(&clh);             break;
+         case SEM:      sem_post(&semi);              break;
+         default:                                     break;
+      }
+
+      for (i = 0; i < think; i++)
+         local++;
+      count++;
+   }
+
+   me->count = count;
+   me->sample_count = sample_count;
+   me->samples = samples;
+   return NULL;
+}  /* Lock_and_unlock */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Reservoir_slot
+ * Purpose:    Decide where candidate s of a thread's latency sample
+ *             goes (note 4)
+ * In arg:     s:  0, 1, 2, ...
+ * In/out arg: seed_p:  the thread's xorshift state
+ * Ret val:    s while the sample isn't full, then a random slot with
+ *             probability MAX_SAMPLES/(s+1), else -1 (don't time it)
+ */
+long Reservoir_slot(long s, unsigned long* seed_p) {
+   unsigned long x = *seed_p;
+   long          j;
+
+   if (s < MAX_SAMPLES) return s;
+   x ^= x << 13;
+   x ^= x >> 7;
+   x ^= x << 17;
+   *seed_p = x;
+   j = x % (unsigned long) (s + 1);
+   return (j < MAX_SAMPLES) ? j : -1;
+}  /* Reservoir_slot */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Now_ns
+ * Purpose:    Current time in nanoseconds
+ */
+long Now_ns(void) {
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec*1000000000L + t.tv_nsec;
+}  /* Now_ns */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Compare_long
+ * Purpose:    qsort comparison for longs
+ */
+int Compare_long(const void* a, const void* b) {
+   long x = *(const long*) a;
+   long y = *(const long*) b;
+
+   return (x > y) - (x < y);
+}  /* Compare_long */
+
+
+/*---------------------------------------------------------------------
+ * Function:   Print_row
+ * Purpose:    Print the CSV line for a run (notes 3-5)
+ * In args:    secs, samples:  sorted, sample_count
+ * In globals: kind, thread_count, cs, think, total, shared, results
+ */
+void Print_row(double secs, long samples[], long sample_count) {
+   long   ops = 0, min = -1, max = 0, c;
+   double sum_sq = 0.0, avg;
+   int    t, correct;
+
+   for (t = 0; t < thread_count; t++) {
+      c = results[t].count;
+      ops += c;
+      sum_sq += (double) c*c;
+      if (min < 0 || c < min) min = c;
+      if (c > max) max = c;
+   }
+   avg = (double) ops/thread_count;
+   correct = (total == ops && shared == cs*ops);
+
+   printf("%s,%d,%ld,%ld,%.4f,%ld,%.4e,%.4f,%.4f,%.4f,", lock_names[kind],
+         thread_count, cs, think, secs, ops, ops/secs,
+         sum_sq > 0 ? (double) ops*ops/(thread_count*sum_sq) : 1.0,
+         avg > 0 ? min/avg : 1.0, avg > 0 ? max/avg : 1.0);
+   if (sample_count > 0)
+      printf("%ld,%ld,%ld,%ld,", samples[sample_count/2],
+            samples[(long) (0.9*(sample_count - 1))],
+            samples[(long) (0.99*(sample_count - 1))],
+            samples[sample_count - 1]);
+   else
+      printf(",,,,");
+   printf("%s,", correct ? "yes" : "no");
+   for (t = 0; t < thread_count; t++)
+      printf("%s%ld", t > 0 ? ";" : "", results[t].count);
+   printf("\n");
+}  /* Print_row */
@@ -0,0 +1,414 @@
+/* File:     locks.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the spin locks in locks.h
+ *
+ * Compile:  link with the caller and -lpthread, e.g.
+ *           gcc -g -Wall -O2 -I.. -o lock_bench lock_bench.c locks.c
+ *              ../numa_rt.c -lpthread
+ *
+ * Notes:
+ *    1.  Ticket lock:  a thread takes a ticket with one fetch-and-add
+ *        and waits until owner gets to it, so the lock is granted in
+ *        the order it was asked for.  Every waiter reads the same
+ *        owner, so each unlock invalidates that line in every waiter's
+ *        cache.  To cut down on the reloads, a waiter that's k tickets
+ *        from the front pauses about k*TICKET_BACKOFF times before it
+ *        looks again (proportional backoff):  it can't get the lock
+ *        before the k threads ahead of it are done anyway.
+ *    2.  MCS lock:  the waiters form a queue of mcs_node_t's, one per
+ *        thread, and each one spins on the locked flag in its own
+ *        node, which is on its own cache line.  An unlock writes only
+ *        the next waiter's node, so the traffic per handoff doesn't
+ *        grow with the number of waiters.
+ *    3.  CLH lock:  also a queue, but each thread spins on the node of
+ *        the thread ahead of it, and an unlock just clears the
+ *        holder's own node.  The holder then takes over its
+ *        predecessor's node, which nobody else is looking at any
+ *        more, for its next lock, so the nodes move from thread to
+ *        thread.  The lock starts with one free node of its own, and
+ *        Clh_destroy frees the one it ends up with.
+ *    4.  So the queue locks can be used like a pthread_mutex_t, with
+ *        no node argument, each thread has LOCK_DEPTH nodes of each
+ *        kind in thread local storage and a bit mask of the ones in
+ *        use.  The lock records the node its holder used (and for CLH
+ *        the predecessor's node and the slot), so Mcs_unlock and
+ *        Clh_unlock find it again.  Locks can be released in any
+ *        order, but a thread can't hold more than LOCK_DEPTH of one
+ *        kind at once.  A thread's CLH nodes are freed when it exits,
+ *        and the ones of the thread that calls exit (usually main,
+ *        whose key destructors don't run) by an atexit handler.
+ *    5.  Spin_pause is the body of every wait loop:  a pause
+ *        instruction on x86, and a sched_yield every SPIN_YIELD spins.
+ *        Without the yield, a waiter that's running on the same core
+ *        as the holder (more threads than cores) would spin for its
+ *        whole time slice.  After SPIN_SLEEP spins it naps for
+ *        SPIN_NAP_NS instead of yielding:  the queue locks and the
+ *        ticket lock hand the lock to one particular thread, and if
+ *        that thread has been preempted, the scheduler may keep
+ *        picking the waiters that just yielded instead of it (this
+ *        happens with the EEVDF scheduler, which doesn't consider a
+ *        thread that has used more than its share of the CPU).
+ *        Sleeping takes the waiter off the run queue altogether.
+ *    6.  Acquire and release orderings keep the critical section's
+ *        loads and stores between the lock and the unlock.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "locks.h"
+
+static const char* alg_names[] = {"mutex", "ticket", "mcs", "clh"};
+
+/* Note 4 */
+static __thread mcs_node_t  mcs_nodes[LOCK_DEPTH];
+static __thread unsigned    mcs_used = 0;
+static __thread clh_node_t* clh_nodes[LOCK_DEPTH];
+static __thread unsigned    clh_used = 0;
+static pthread_key_t        clh_key;
+static pthread_once_t       clh_once = PTHREAD_ONCE_INIT;
+
+static void        Cpu_relax(void);
+static int         Take_slot(unsigned* used_p);
+static clh_node_t* Alloc_clh_node(void);
+static void        Make_clh_key(void);
+static void        Free_clh_nodes(void* arg);
+static void        Free_exit_clh_nodes(void);
+
+/*-------------------------------------------------------------------
+ * Function:    Cpu_relax
+ * Purpose:     Tell the CPU we're in a spin loop
+ */
+static void Cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_ia32_pause();
+#endif
+}  /* Cpu_relax */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Spin_pause
+ * Purpose:     Wait a little in a spin loop (note 5)
+ * In/out arg:  spins_p:  spins so far, start it at 0
+ */
+void Spin_pause(unsigned* spins_p) {
+   struct timespec nap = {0, SPIN_NAP_NS};
+
+   if (++*spins_p % SPIN_YIELD != 0)
+      Cpu_relax();
+   else if (*spins_p < SPIN_SLEEP)
+      sched_yield();
+   else
+      nanosleep(&nap, NULL);
+}  /* Spin_pause */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Ticket_init
+ * Purpose:     Initialize an unlocked ticket lock
+ */
+void Ticket_init(ticket_lock_t* lock) {
+   lock->next = 0;
+   lock->owner = 0;
+}  /* Ticket_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Ticket_lock
+ * Purpose:     Take a ticket and wait for it to be called (note 1)
+ */
+void Ticket_lock(ticket_lock_t* lock) {
+   unsigned me = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+   unsigned owner, spins = 0, i;
+
+   while ((owner = __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE)) != me) {
+      for (i = (me - owner - 1)*TICKET_BACKOFF + 1; i > 0; i--)
+         Spin_pause(&spins);
+   }
+}  /* Ticket_lock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Ticket_unlock
+ * Purpose:     Call the next ticket
+ */
+void Ticket_unlock(ticket_lock_t* lock) {
+   __atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}  /* Ticket_unlock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Mcs_init
+ * Purpose:     Initialize an unlocked MCS lock
+ */
+void Mcs_init(mcs_lock_t* lock) {
+   lock->tail = NULL;
+   lock->holder = NULL;
+}  /* Mcs_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Mcs_lock
+ * Purpose:     Join the end of the queue with one of this thread's
+ *              nodes, and wait on it (notes 2 and 4)
+ */
+void Mcs_lock(mcs_lock_t* lock) {
+   mcs_node_t* me = &mcs_nodes[Take_slot(&mcs_used)];
+   mcs_node_t* pred;
+   unsigned    spins = 0;
+
+   me->next = NULL;
+   me->locked = 1;
+   pred = __atomic_exchange_n(&lock->tail, me, __ATOMIC_ACQ_REL);
+   if (pred != NULL) {
+      __atomic_store_n(&pred->next, me, __ATOMIC_RELEASE);
+      while (__atomic_load_n(&me->locked, __ATOMIC_ACQUIRE))
+         Spin_pause(&spins);
+   }
+   lock->holder = me;
+}  /* Mcs_lock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Mcs_unlock
+ * Purpose:     Hand the lock to the next node in the queue, or mark
+ *              the lock free if there isn't one
+ */
+void Mcs_unlock(mcs_lock_t* lock) {
+   mcs_node_t* me = lock->holder;
+   mcs_node_t* succ = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE);
+   mcs_node_t* expected = me;
+   unsigned    spins = 0;
+
+   mcs_used &= ~(1u << (me - mcs_nodes));
+   if (succ == NULL) {
+      if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, 0,
+               __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+         return;
+      /* A thread has swapped itself into tail but hasn't linked
+       * itself to us yet */
+      while ((succ = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE)) == NULL)
+         Spin_pause(&spins);
+   }
+   __atomic_store_n(&succ->locked, 0, __ATOMIC_RELEASE);
+}  /* Mcs_unlock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Clh_init
+ * Purpose:     Initialize an unlocked CLH lock:  its tail is a node
+ *              that's already been released (note 3)
+ */
+void Clh_init(clh_lock_t* lock) {
+   lock->tail = Alloc_clh_node();
+   lock->tail->locked = 0;
+   lock->holder = lock->pred = NULL;
+   lock->slot = -1;
+}  /* Clh_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Clh_lock
+ * Purpose:     Put one of this thread's nodes at the end of the queue,
+ *              and wait on the node ahead of it (notes 3 and 4)
+ */
+void Clh_lock(clh_lock_t* lock) {
+   int         slot = Take_slot(&clh_used);
+   clh_node_t* me;
+   clh_node_t* pred;
+   unsigned    spins = 0;
+
+   if (clh_nodes[slot] == NULL)
+      clh_nodes[slot] = Alloc_clh_node();
+   me = clh_nodes[slot];
+   me->locked = 1;
+   pred = __atomic_exchange_n(&lock->tail, me, __ATOMIC_ACQ_REL);
+   while (__atomic_load_n(&pred->locked, __ATOMIC_ACQUIRE))
+      Spin_pause(&spins);
+   lock->holder = me;
+   lock->pred = pred;
+   lock->slot = slot;
+}  /* Clh_lock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Clh_unlock
+ * Purpose:     Release our node, and keep the predecessor's node for
+ *              the next lock
+ */
+void Clh_unlock(clh_lock_t* lock) {
+   clh_node_t* me = lock->holder;
+   int         slot = lock->slot;
+
+   clh_nodes[slot] = lock->pred;
+   clh_used &= ~(1u << slot);
+   __atomic_store_n(&me->locked, 0, __ATOMIC_RELEASE);
+}  /* Clh_unlock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Clh_destroy
+ * Purpose:     Free the node an unlocked CLH lock is holding
+ */
+void Clh_destroy(clh_lock_t* lock) {
+   free(lock->tail);
+   lock->tail = NULL;
+}  /* Clh_destroy */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Take_slot
+ * Purpose:     Find a free node slot in *used_p and mark it used
+ *              (note 4)
+ * Ret val:     The slot
+ */
+static int Take_slot(unsigned* used_p) {
+   int slot;
+
+   if (*used_p == ~0u) {
+      fprintf(stderr, "A thread can't hold more than %d queue locks\n",
+            LOCK_DEPTH);
+      exit(1);
+   }
+   slot = __builtin_ctz(~*used_p);
+   *used_p |= 1u << slot;
+   return slot;
+}  /* Take_slot */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Alloc_clh_node
+ * Purpose:     Allocate a cache line aligned CLH node, and make sure
+ *              the calling thread's nodes get freed when it exits
+ */
+static clh_node_t* Alloc_clh_node(void) {
+   void* p;
+
+   if (posix_memalign(&p, CACHE_LINE, sizeof(clh_node_t)) != 0) {
+      fprintf(stderr, "Can't allocate a lock node\n");
+      exit(1);
+   }
+   pthread_once(&clh_once, Make_clh_key);
+   pthread_setspecific(clh_key, clh_nodes);
+   return p;
+}  /* Alloc_clh_node */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Make_clh_key
+ * Purpose:     Create the key whose destructor frees a thread's CLH
+ *              nodes
+ */
+static void Make_clh_key(void) {
+   pthread_key_create(&clh_key, Free_clh_nodes);
+   atexit(Free_exit_clh_nodes);
+}  /* Make_clh_key */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Free_clh_nodes
+ * Purpose:     Free an exiting thread's CLH nodes
+ * In arg:      arg:  the thread's clh_nodes
+ */
+static void Free_clh_nodes(void* arg) {
+   clh_node_t** nodes = arg;
+   int          slot;
+
+   for (slot = 0; slot < LOCK_DEPTH; slot++) {
+      free(nodes[slot]);
+      nodes[slot] = NULL;
+   }
+}  /* Free_clh_nodes */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Free_exit_clh_nodes
+ * Purpose:     atexit handler:  free the CLH nodes of the thread that
+ *              calls exit or returns from main (note 4)
+ */
+static void Free_exit_clh_nodes(void) {
+   Free_clh_nodes(clh_nodes);
+}  /* Free_exit_clh_nodes */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lock_alg
+ * Purpose:     Return the lock_alg_t called name ("mutex", "ticket",
+ *              "mcs" or "clh"), or LOCK_ALGS if there isn't one
+ */
+lock_alg_t Lock_alg(const char* name) {
+   int alg;
+
+   for (alg = 0; alg < LOCK_ALGS; alg++)
+      if (strcmp(name, alg_names[alg]) == 0) break;
+   return alg;
+}  /* Lock_alg */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lock_name
+ * Purpose:     Return the name of alg
+ */
+const char* Lock_name(lock_alg_t alg) {
+   return (alg >= 0 && alg < LOCK_ALGS) ? alg_names[alg] : "unknown";
+}  /* Lock_name */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lock_init
+ * Purpose:     Initialize lock as an unlocked lock of kind alg
+ */
+void Lock_init(lock_t* lock, lock_alg_t alg) {
+   lock->alg = alg;
+   switch (alg) {
+      case LOCK_TICKET: Ticket_init(&lock->u.ticket);         break;
+      case LOCK_MCS:    Mcs_init(&lock->u.mcs);               break;
+      case LOCK_CLH:    Clh_init(&lock->u.clh);               break;
+      default:
+         lock->alg = LOCK_MUTEX;
+         pthread_mutex_init(&lock->u.mutex, NULL);
+         break;
+   }
+}  /* Lock_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lock_lock
+ * Purpose:     Lock lock, like pthread_mutex_lock
+ */
+void Lock_lock(lock_t* lock) {
+   switch (lock->alg) {
+      case LOCK_TICKET: Ticket_lock(&lock->u.ticket);         break;
+      case LOCK_MCS:    Mcs_lock(&lock->u.mcs);               break;
+      case LOCK_CLH:    Clh_lock(&lock->u.clh);               break;
+      default:          pthread_mutex_lock(&lock->u.mutex);   break;
+   }
+}  /* Lock_lock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lock_unlock
+ * Purpose:     Unlock lock, like pthread_mutex_unlock
+ */
+void Lock_unlock(lock_t* lock) {
+   switch (lock->alg) {
+      case LOCK_TICKET: Ticket_unlock(&lock->u.ticket);       break;
+      case LOCK_MCS:    Mcs_unlock(&lock->u.mcs);             break;
+      case LOCK_CLH:    Clh_unlock(&lock->u.clh);             break;
+      default:          pthread_mutex_unlock(&lock->u.mutex); break;
+   }
+}  /* Lock_unlock */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lock_destroy
+ * Purpose:     Free the resources used by an unlocked lock
+ */
+void Lock_destroy(lock_t* lock) {
+   if (lock->alg == LOCK_CLH)
+      Clh_destroy(&lock->u.clh);
+   else if (lock->alg == LOCK_MUTEX)
+      pthread_mutex_destroy(&lock->u.mutex);
+}  /* Lock_destroy */
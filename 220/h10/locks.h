@@ -0,0 +1,109 @@
+/* File:     locks.h
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to spin locks built on gcc's atomic builtins:  a
+ *           ticket lock with proportional backoff, and MCS and CLH
+ *           queue locks.  Each one is locked and unlocked like a
+ *           pthread_mutex_t, and lock_t can be any of them or a
+ *           pthread_mutex_t, chosen when it's initialized.
+ *
+ * Example:
+ *    #include "locks.h"
+ *    lock_t mutex;
+ *    . . .
+ *    Lock_init(&mutex, Lock_alg("mcs"));
+ *    . . .
+ *    Lock_lock(&mutex);
+ *    total++;
+ *    Lock_unlock(&mutex);
+ *    . . .
+ *    Lock_destroy(&mutex);
+ *
+ *    or use one kind directly, e.g.
+ *
+ *    clh_lock_t clh;
+ *    Clh_init(&clh);
+ *    Clh_lock(&clh);  ...  Clh_unlock(&clh);
+ *    Clh_destroy(&clh);
+ */
+#ifndef _LOCKS_H_
+#define _LOCKS_H_
+
+#include <pthread.h>
+
+#define CACHE_LINE 64
+
+/* Waiting (see locks.c):  spins between calls to sched_yield, spins
+ * before the yields become naps, and the length of a nap in ns */
+#define SPIN_YIELD 128
+#define SPIN_SLEEP (64*SPIN_YIELD)
+#define SPIN_NAP_NS 20000
+
+/* Ticket lock:  pauses per waiter ahead of us between checks */
+#define TICKET_BACKOFF 32
+
+/* Most queue locks of one kind a thread can hold at the same time */
+#define LOCK_DEPTH 32
+
+typedef enum {LOCK_MUTEX, LOCK_TICKET, LOCK_MCS, LOCK_CLH, LOCK_ALGS}
+   lock_alg_t;
+
+typedef struct {
+   volatile unsigned next;        /* Next ticket to hand out     */
+   char              pad[CACHE_LINE - sizeof(unsigned)];
+   volatile unsigned owner;       /* Ticket that holds the lock  */
+} __attribute__((aligned(CACHE_LINE))) ticket_lock_t;
+
+typedef struct mcs_node {
+   struct mcs_node* volatile next;
+   volatile int              locked;
+} __attribute__((aligned(CACHE_LINE))) mcs_node_t;
+
+typedef struct {
+   mcs_node_t* volatile tail;
+   char                 pad[CACHE_LINE - sizeof(mcs_node_t*)];
+   mcs_node_t*          holder;   /* Written by the holder only  */
+} __attribute__((aligned(CACHE_LINE))) mcs_lock_t;
+
+typedef struct {
+   volatile int locked;
+} __attribute__((aligned(CACHE_LINE))) clh_node_t;
+
+typedef struct {
+   clh_node_t* volatile tail;
+   char                 pad[CACHE_LINE - sizeof(clh_node_t*)];
+   clh_node_t*          holder;   /* Written by the holder only  */
+   clh_node_t*          pred;
+   int                  slot;
+} __attribute__((aligned(CACHE_LINE))) clh_lock_t;
+
+typedef struct {
+   lock_alg_t alg;
+   union {
+      pthread_mutex_t mutex;
+      ticket_lock_t   ticket;
+      mcs_lock_t      mcs;
+      clh_lock_t      clh;
+   } u;
+} lock_t;
+
+void        Spin_pause(unsigned* spins_p);
+void        Ticket_init(ticket_lock_t* lock);
+void        Ticket_lock(ticket_lock_t* lock);
+void        Ticket_unlock(ticket_lock_t* lock);
+void        Mcs_init(mcs_lock_t* lock);
+void        Mcs_lock(mcs_lock_t* lock);
+void        Mcs_unlock(mcs_lock_t* lock);
+void        Clh_init(clh_lock_t* lock);
+void        Clh_lock(clh_lock_t* lock);
+void        Clh_unlock(clh_lock_t* lock);
+void        Clh_destroy(clh_lock_t* lock);
+
+lock_alg_t  Lock_alg(const char* name);
+const char* Lock_name(lock_alg_t alg);
+void        Lock_init(lock_t* lock, lock_alg_t alg);
+void        Lock_lock(lock_t* lock);
+void        Lock_unlock(lock_t* lock);
+void        Lock_destroy(lock_t* lock);
+
+#endif
@@ -4,25 +4,33 @@
  *
  * Purpose:  Lock and unlock a mutex many times, and report on elapsed time
  *
- * Compile:  gcc -g -Wall -o many_mutexes many_mutexes.c -lpthread
- * Run:      ./many_mutexes <thread_count> <n>
+ * Compile:  gcc -g -Wall -I.. -o many_mutexes many_mutexes.c locks.c
+ *              -lpthread
+ * Run:      ./many_mutexes <thread_count> <n> [lock]
  *              n:  number of times the mutex is locked and unlocked
  *                  by each thread
+ *              lock:  mutex (pthread_mutex_t, the default), ticket,
+ *                  mcs or clh (see locks.c)
  *
  * Input:    none
  * Output:   Total number of times mutex was locked and elapsed time for
  *           the threads
+ *
+ * Note:     The mutex is a lock_t (locks.h), so the same loop can be
+ *           run with any of the locks in locks.c.  lock_bench.c
+ *           compares them under contention.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include "timer.h"
+#include "locks.h"
 
 int thread_count;
 int n;
 int total = 0;
-pthread_mutex_t mutex;
+lock_t mutex;
 
 void Usage(char prog_name[]);
 void* Lock_and_unlock(void* rank);
@@ -31,13 +39,15 @@ int main(int argc, char* argv[]) {
    pthread_t* thread_handles;
    long thread;
    double start, finish;
+   lock_alg_t alg = LOCK_MUTEX;
 
-   if (argc != 3) Usage(argv[0]);
+   if (argc != 3 && argc != 4) Usage(argv[0]);
    thread_count = strtol(argv[1], NULL, 10);
    n = strtol(argv[2], NULL, 10);
+   if (argc == 4 && (alg = Lock_alg(argv[3])) == LOCK_ALGS) Usage(argv[0]);
 
    thread_handles = malloc(thread_count*sizeof(pthread_t));
-   pthread_mutex_init(&mutex, NULL);
+   Lock_init(&mutex, alg);
 
    GET_TIME(start);
    for (thread = 0; thread < thread_count; thread++)
@@ -48,11 +58,11 @@ int main(int argc, char* argv[]) {
       pthread_join(thread_handles[thread], NULL);
    GET_TIME(finish);
 
-   printf("Total number of times mutex was locked and unlocked: %d\n",
-         total);
+   printf("Total number of times %s was locked and unlocked: %d\n",
+         Lock_name(alg), total);
    printf("Elapsed time = %e seconds\n", finish-start);
 
-   pthread_mutex_destroy(&mutex);
+   Lock_destroy(&mutex);
    free(thread_handles);
    return 0;
 }  /* main */
@@ -64,9 +74,10 @@ int main(int argc, char* argv[]) {
  * In arg:     prog_name:  name of program from command line
  */
 void Usage(char prog_name[]) {
-   fprintf(stderr, "usage: %s <thread_count> <n>\n", prog_name);
+   fprintf(stderr, "usage: %s <thread_count> <n> [lock]\n", prog_name);
    fprintf(stderr, "    n: number of times mutex is locked and ");
    fprintf(stderr, "unlocked by each thread\n");
+   fprintf(stderr, "    lock: mutex, ticket, mcs or clh\n");
    exit(0);
 }  /* Usage */
 
@@ -86,9 +97,9 @@ void* Lock_and_unlock(void* rank) {
    int i;
 
    for (i = 0; i < n; i++) {
-      pthread_mutex_lock(&mutex);
+      Lock_lock(&mutex);
       total++;
-      pthread_mutex_unlock(&mutex);
+      Lock_unlock(&mutex);
    }
 
    return NULL;
@@ -12,6 +12,9 @@
  * Input:    none
  * Output:   Total number of times semaphore was locked and elapsed time for
  *           the threads
+ *
+ * Note:     lock_bench.c compares this with the other kinds of lock.
+ *
  * Run time: Semaphores:   On the Penguin cluster with 4 threads and n = 1000000
  *           Run 1:  Total number of times semaphore was locked and unlocked: 4000000
  *           Elapsed time = 3.948181e+00 seconds
@@ -0,0 +1,301 @@
+/* File:  
+ *    pth_mc.c
+ *
+ * Author: Cayla Shaver
+ * Section: 2
+ * Purpose:
+ *    Estimate a d-dimensional integral over the unit cube with Monte
+ *    Carlo, using per-thread xoshiro256** substreams (xoshiro.c).
+ *
+ * Compile:
+ *    gcc -g -Wall -O3 -march=native -I.. -o pth_mc pth_mc.c xoshiro.c
+ *       -lpthread -lm
+ * Usage:
+ *    pth_mc <thread_count> <d> <n> [s]
+ *       d:  number of dimensions
+ *       n:  total number of samples
+ *       s:  use stratified sampling
+ *
+ * Input:
+ *    None
+ * Output:
+ *    The estimate, its standard error and a 95% confidence interval,
+ *    the exact value, and the elapsed time and samples per second.
+ *
+ * Notes:
+ *    1.  The integrand is hardwired:  f(x) = product of
+ *        (pi/2) sin(pi x_i), whose integral over the unit cube is 1
+ *        in any number of dimensions.
+ *    2.  Each thread has its own xoshiro substream and keeps its sum
+ *        and sum of squares in local variables.  Nothing is shared
+ *        until the threads finish and write their totals, which main
+ *        adds up, so the hot loop scales with the number of threads.
+ *    3.  Stratified sampling splits the first sd = min(d, MAX_SDIMS)
+ *        coordinates into k equal intervals each, for k^sd strata,
+ *        with k as large as possible while each stratum still gets
+ *        MIN_PER_STRATUM samples.  Each stratum gets the same number
+ *        of samples, and the threads get blocks of strata.  The
+ *        estimate is the mean of the stratum means and its variance
+ *        is the sum of the stratum variances/(samples*strata^2).
+ *    4.  Thread t's stream starts t*XOSHIRO_LANES jumps from the
+ *        seed, so its XOSHIRO_LANES lanes don't overlap any other
+ *        thread's.  Uniform hands out doubles from a buffer of UBUF
+ *        that Xoshiro_fill_double refills all at once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "timer.h"
+#include "xoshiro.h"
+
+#define SEED 220
+#define UBUF 512
+#define MAX_DIM 64
+#define CACHE_LINE 64
+
+const int    MAX_SDIMS = 3;
+const long   MIN_PER_STRATUM = 16;
+const double Z_95 = 1.959963984540054;
+
+typedef struct {
+   double sum;        /* Plain:  sum of f.  Stratified:  sum of means */
+   double sq;         /* Plain:  sum of f^2.  Stratified:  sum of     */
+                      /*    stratum variances/samples per stratum     */
+   char   pad[CACHE_LINE - 2*sizeof(double)];
+} result_t;
+
+typedef struct {
+   xoshiro_bulk_t b;
+   double         buf[UBUF];
+   int            next;       /* Next unused value in buf */
+} ustream_t;
+
+int       thread_count;
+int       d;
+long      n;
+int       stratified;
+int       sdims;          /* Stratified coordinates           */
+long      k;              /* Intervals per stratified coord   */
+long      strata;         /* k^sdims                          */
+result_t* results;
+
+void     Usage(char* prog_name);
+void     Ustream_init(ustream_t* u, long my_rank);
+double   Uniform(ustream_t* u);
+double   f(const double x[]);
+void*    Plain_work(void* rank);
+void*    Stratified_work(void* rank);
+
+/*--------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long       thread;
+   pthread_t* thread_handles; 
+   double     start, finish, sum, sq, est, var, err;
+   long       used;
+
+   if (argc != 4 && argc != 5) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   d = strtol(argv[2], NULL, 10);
+   n = strtol(argv[3], NULL, 10);
+   stratified = (argc == 5 && argv[4][0] == 's');
+   if (thread_count <= 0 || d <= 0 || d > MAX_DIM || n < 2)
+      Usage(argv[0]);
+
+   if (stratified) {
+      sdims = (d < MAX_SDIMS) ? d : MAX_SDIMS;
+      for (k = 1; pow(k + 1, sdims)*MIN_PER_STRATUM <= n; k++)
+         ;
+      strata = (long) pow(k, sdims);
+      if (strata < thread_count) {
+         fprintf(stderr, "n is too small to stratify for %d threads\n",
+               thread_count);
+         exit(0);
+      }
+   }
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   if (posix_memalign((void**) &results, CACHE_LINE,
+            thread_count*sizeof(result_t)) != 0) {
+      fprintf(stderr, "Can't allocate results\n");
+      exit(1);
+   }
+
+   GET_TIME(start);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL,
+          stratified ? Stratified_work : Plain_work, (void*) thread);
+   for (thread = 0; thread < thread_count; thread++) 
+      pthread_join(thread_handles[thread], NULL);
+   GET_TIME(finish);
+
+   /* The one reduction */
+   sum = sq = 0.0;
+   for (thread = 0; thread < thread_count; thread++) {
+      sum += results[thread].sum;
+      sq += results[thread].sq;
+   }
+   if (stratified) {
+      used = (n/strata)*strata;
+      est = sum/strata;
+      var = sq/((double) strata*strata);
+      printf("Stratified:  %ld strata (%ld per coordinate in %d "
+            "coordinates), %ld samples each\n", strata, k, sdims,
+            n/strata);
+   } else {
+      used = n;
+      est = sum/n;
+      var = (sq/n - est*est)/(n - 1);
+   }
+   err = sqrt(var);
+
+   printf("Estimate of the integral in %d dimensions = %.10f\n", d, est);
+   printf("Standard error = %.3e, 95%% confidence interval = "
+         "[%.10f, %.10f]\n", err, est - Z_95*err, est + Z_95*err);
+   printf("Exact value = 1\n");
+   printf("Elapsed time = %e seconds, %e samples per second\n",
+         finish - start, used/(finish - start));
+
+   free(results);
+   free(thread_handles);
+   return 0;
+}  /* main */
+
+
+/*--------------------------------------------------------------------
+ * Function:    Usage
+ * Purpose:     Print command line for function and terminate
+ * In arg:      prog_name
+ */
+void Usage(char* prog_name) {
+
+   fprintf(stderr, "usage: %s <thread count> <d> <n> [s]\n", prog_name);
+   fprintf(stderr, "   d:  number of dimensions (<= %d)\n", MAX_DIM);
+   fprintf(stderr, "   n:  number of samples\n");
+   fprintf(stderr, "   s:  stratified sampling\n");
+   exit(0);
+}  /* Usage */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Plain_work
+ * Purpose:     Thread function:  evaluate f at this thread's share of
+ *              the n random points
+ * In arg:      rank
+ * Globals:     thread_count, d, n (in), results (out)
+ */
+void *Plain_work(void* rank) {
+   long     my_rank = (long) rank;
+   long     my_n = n/thread_count + (my_rank < n % thread_count ? 1 : 0);
+   ustream_t state;
+   double   x[MAX_DIM];
+   double   sum = 0.0, sq = 0.0, y;
+   long     i;
+   int      j;
+
+   Ustream_init(&state, my_rank);
+   for (i = 0; i < my_n; i++) {
+      for (j = 0; j < d; j++)
+         x[j] = Uniform(&state);
+      y = f(x);
+      sum += y;
+      sq += y*y;
+   }
+
+   results[my_rank].sum = sum;
+   results[my_rank].sq = sq;
+   return NULL;
+}  /* Plain_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Stratified_work
+ * Purpose:     Thread function:  sample each of this thread's block of
+ *              strata n/strata times
+ * In arg:      rank
+ * Globals:     thread_count, d, n, sdims, k, strata (in), results (out)
+ *
+ * Note:        Stratum s covers [c_j/k, (c_j+1)/k) in coordinate j,
+ *              j < sdims, where c_j is digit j of s in base k.
+ */
+void *Stratified_work(void* rank) {
+   long     my_rank = (long) rank;
+   long     first = my_rank*strata/thread_count;
+   long     last = (my_rank + 1)*strata/thread_count;
+   long     per = n/strata;
+   ustream_t state;
+   double   x[MAX_DIM], low[MAX_DIM];
+   double   width = 1.0/k;
+   double   sum = 0.0, var_sum = 0.0, s_sum, s_sq, y, mean;
+   long     s, c, i;
+   int      j;
+
+   Ustream_init(&state, my_rank);
+   for (s = first; s < last; s++) {
+      for (j = 0, c = s; j < sdims; j++, c /= k)
+         low[j] = (c % k)*width;
+      s_sum = s_sq = 0.0;
+      for (i = 0; i < per; i++) {
+         for (j = 0; j < sdims; j++)
+            x[j] = low[j] + width*Uniform(&state);
+         for (; j < d; j++)
+            x[j] = Uniform(&state);
+         y = f(x);
+         s_sum += y;
+         s_sq += y*y;
+      }
+      mean = s_sum/per;
+      sum += mean;
+      var_sum += (s_sq/per - mean*mean)/(per - 1);
+   }
+
+   results[my_rank].sum = sum;
+   results[my_rank].sq = var_sum;
+   return NULL;
+}  /* Stratified_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    f
+ * Purpose:     The integrand:  product of (pi/2) sin(pi x_j)
+ * In arg:      x:  d coordinates
+ */
+double f(const double x[]) {
+   double prod = 1.0;
+   int    j;
+
+   for (j = 0; j < d; j++)
+      prod *= M_PI_2*sin(M_PI*x[j]);
+   return prod;
+}  /* f */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Ustream_init
+ * Purpose:     Start thread my_rank's substream (see note 4)
+ * In arg:      my_rank
+ * Out arg:     u
+ */
+void Ustream_init(ustream_t* u, long my_rank) {
+   xoshiro_t g;
+
+   Xoshiro_stream(&g, SEED, 0, my_rank*XOSHIRO_LANES);
+   Xoshiro_bulk_init(&u->b, &g);
+   u->next = UBUF;
+}  /* Ustream_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Uniform
+ * Purpose:     Return the next double in [0, 1) from u, refilling
+ *              its buffer when it runs out
+ * In/out arg:  u
+ */
+double Uniform(ustream_t* u) {
+   if (u->next == UBUF) {
+      Xoshiro_fill_double(&u->b, u->buf, UBUF);
+      u->next = 0;
+   }
+   return u->buf[u->next++];
+}  /* Uniform */
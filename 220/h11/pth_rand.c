@@ -1,60 +1,126 @@
-/* File:  
+/* File:
  *    pth_rand.c
  *
  * Author: Cayla Shaver
  * Section: 2
  * Purpose:
- *    Generate random numbers with function that isn't threadsafe.
+ *    Generate random numbers on each thread, using its own
+ *    xoshiro256** substream.
  *
  * Compile:
- *    gcc -g -Wall -o pth_rand pth_rand.c -lpthread
+ *    gcc -g -Wall -O3 -march=native -I.. -o pth_rand pth_rand.c
+ *       xoshiro.c -lpthread
  * Usage:
- *    pth_rand <thread_count> <number of random numbers per thread>
+ *    pth_rand <thread_count> <number of random numbers per thread> [p|t|b]
+ *       p:  printf each number as it's generated (default)
+ *       t:  format text into per-thread buffers, write them in rounds
+ *       b:  binary:  store the 64-bit values in per-thread buffers,
+ *           write them in rounds
  *
  * Input:
  *    None
  * Output:
- *    Random numbers from each thread
+ *    Random numbers from each thread to stdout.  The elapsed time and
+ *    numbers per second to stderr.
  *
- * Warning:
- *    The My_random function is *not* threadsafe.
+ * Notes:
+ *    1.  This used to use My_random, a multiplicative LCG mod
+ *        4294967291 seeded with rank + 1.  Its streams were just
+ *        different starting points on one short cycle, so they could
+ *        overlap.  Thread t now uses Xoshiro_stream(.., 0,
+ *        t*XOSHIRO_LANES) and bulk fills, so its lanes are at least
+ *        2^128 values from any other thread's (see xoshiro.c).
+ *    2.  Each value printed is the top 32 bits of a 64-bit draw.
+ *    3.  In p mode every number is a printf, and every printf locks
+ *        stdout, so the threads mostly wait for each other and the
+ *        lines come out interleaved.  In t and b modes nothing is
+ *        shared while the threads generate:  each one fills its own
+ *        buffer with its next ROUND values, the threads meet at a
+ *        barrier, and thread 0 hands that round's buffers to writev
+ *        in rank order.  Each thread has two buffers, so the others
+ *        fill the next round while thread 0 writes, and a buffer
+ *        isn't reused until the barrier after it's been written.  So
+ *        the output of t is the lines of p, ROUND from each thread
+ *        in turn, and the memory used doesn't depend on n.
+ *    4.  b writes n*thread_count native-endian uint64_t's, ROUND
+ *        from thread 0, then ROUND from thread 1, and so on.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #include <pthread.h>
+#include "timer.h"
+#include "xoshiro.h"
 
-#define MR_MULTIPLIER 279470273 
-#define MR_INCREMENT 0
-#define MR_MODULUS 4294967291U
+#define SEED 220
+#define BLOCK 512          /* Values per bulk fill  */
+#define MAX_LINE 32        /* "Th <rank> > <value>\n" */
+#define ROUND (16*BLOCK)   /* Values per thread per write       */
 
-int thread_count;
-int n;
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
-void Usage(char* prog_name);
-unsigned My_random(unsigned seed, unsigned rankseed);
-void *Thread_work(void* rank);  /* Thread function */
+int               thread_count;
+int               n;
+char              mode;
+char**            bufs;      /* t and b:  two buffers per thread      */
+struct iovec*     iov;       /* t and b:  one round's buffers         */
+pthread_barrier_t barrier;
+
+void   Usage(char* prog_name);
+void*  Thread_work(void* rank);  /* Thread function */
+size_t Format_line(char* s, long my_rank, unsigned val);
+void   Write_round(int half);
+void   Write_all(struct iovec iov[], int count);
 
 /*--------------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
-   long        thread;
-   pthread_t* thread_handles; 
+   long          thread;
+   pthread_t*    thread_handles;
+   double        start, finish;
 
-   if (argc != 3) Usage(argv[0]);
+   if (argc != 3 && argc != 4) Usage(argv[0]);
    thread_count = strtol(argv[1], NULL, 10);
    n = strtol(argv[2], NULL, 10);
+   mode = (argc == 4) ? argv[3][0] : 'p';
+   if (thread_count <= 0 || n < 0 ||
+         (mode != 'p' && mode != 't' && mode != 'b'))
+      Usage(argv[0]);
 
    thread_handles = malloc(thread_count*sizeof(pthread_t));
+   bufs = malloc(2*thread_count*sizeof(char*));
+   iov = malloc(2*thread_count*sizeof(struct iovec));
+   pthread_barrier_init(&barrier, NULL, thread_count);
 
-   printf("Enter text\n");
+   GET_TIME(start);
    for (thread = 0; thread < thread_count; thread++)
       pthread_create(&thread_handles[thread], NULL,
           Thread_work, (void*) thread);
 
-   for (thread = 0; thread < thread_count; thread++) 
+   for (thread = 0; thread < thread_count; thread++)
       pthread_join(thread_handles[thread], NULL);
 
+   if (mode == 'p') {
+      fflush(stdout);
+   } else {
+      for (thread = 0; thread < 2*thread_count; thread++)
+         free(bufs[thread]);
+   }
+   GET_TIME(finish);
+
+   fprintf(stderr, "Elapsed time = %e seconds, %e numbers per second\n",
+         finish - start, (double) n*thread_count/(finish - start));
+
+   pthread_barrier_destroy(&barrier);
+   free(iov);
+   free(bufs);
    free(thread_handles);
    return 0;
 }  /* main */
@@ -67,28 +133,68 @@ int main(int argc, char* argv[]) {
  */
 void Usage(char* prog_name) {
 
-   fprintf(stderr, "usage: %s <thread count> <number of random vals per thread>\n", 
+   fprintf(stderr, "usage: %s <thread count> <number of random vals per thread> [p|t|b]\n",
          prog_name);
+   fprintf(stderr, "   p:  printf each value\n");
+   fprintf(stderr, "   t:  buffer text per thread, writev in rounds\n");
+   fprintf(stderr, "   b:  buffer binary uint64's, writev in rounds\n");
    exit(0);
 }  /* Usage */
 
 
 /*-------------------------------------------------------------------
  * Function:    Thread_work
- * Purpose:     Each thread calls a function and prints a message
+ * Purpose:     Generate this thread's n numbers and print them, or
+ *              store them in its buffers and write them in rounds
+ *              (note 3)
  * In arg:      rank
- * Global vars: thread_count (in) 
+ * Global vars: n, mode (in), bufs, iov (out)
  * Return val:  Ignored
  */
 void *Thread_work(void* rank) {
-   long my_rank = (long) rank;
-   int i;
-   unsigned rankseed = my_rank + 1;
-
-   rankseed = My_random(rankseed, rankseed);  /* "Seed" Random number generator */
-   for (i = 0; i < n; i++){ 
-      rankseed = My_random(0, rankseed);
-      printf("Th %ld > %u\n", my_rank, My_random(0, rankseed));
+   long           my_rank = (long) rank;
+   int            i, j, len, half = 0;
+   xoshiro_t      g;
+   xoshiro_bulk_t b;
+   uint64_t       vals[BLOCK];
+   char*          buf = NULL;
+   size_t         used = 0;
+
+   Xoshiro_stream(&g, SEED, 0, my_rank*XOSHIRO_LANES);
+   Xoshiro_bulk_init(&b, &g);
+
+   if (mode != 'p') {
+      for (j = 0; j < 2; j++)
+         bufs[2*my_rank + j] = malloc((mode == 't') ?
+               ROUND*MAX_LINE : ROUND*sizeof(uint64_t));
+      buf = bufs[2*my_rank];
+   }
+
+   for (i = 0; i < n; i += BLOCK) {
+      len = (n - i < BLOCK) ? n - i : BLOCK;
+      if (mode == 'b') {
+         Xoshiro_fill_u64(&b, (uint64_t*) (buf + used), len);
+         used += len*sizeof(uint64_t);
+      } else {
+         Xoshiro_fill_u64(&b, vals, len);
+         for (j = 0; j < len; j++)
+            if (mode == 'p')
+               printf("Th %ld > %u\n", my_rank, (unsigned) (vals[j] >> 32));
+            else
+               used += Format_line(buf + used, my_rank,
+                     (unsigned) (vals[j] >> 32));
+      }
+
+      /* End of a round:  hand this buffer over, switch to the other */
+      if (mode != 'p' && ((i + len) % ROUND == 0 || i + len == n)) {
+         iov[half*thread_count + my_rank].iov_base = buf;
+         iov[half*thread_count + my_rank].iov_len = used;
+         pthread_barrier_wait(&barrier);
+         if (my_rank == 0) Write_round(half);
+         half = 1 - half;
+         buf = bufs[2*my_rank + half];
+         used = 0;
+      }
    }
 
    return NULL;
@@ -96,25 +202,78 @@ void *Thread_work(void* rank) {
 
 
 /*-------------------------------------------------------------------
- * Function:    My_random
- * Purpose:     Generate random numbers
- * In arg:      seed  (ignored if = 0)
- * Ret val:     A "random" unsigned int
- *
- * Note:        The first time the function is called, the random
- *              number should be "seeded" with a nonzero argument,
- *              and the return value ignored.  Subsequent calls 
- *              should have a zero argument and the return values
- *              will form a "pseudo-random" sequence.
+ * Function:    Format_line
+ * Purpose:     Store "Th <my_rank> > <val>\n" in s, without the
+ *              overhead of sprintf
+ * In args:     my_rank, val
+ * Out arg:     s:  at least MAX_LINE chars
+ * Ret val:     Number of chars stored (no '\0')
  */
-unsigned My_random(unsigned seed, unsigned rankseed) {
-   unsigned z = rankseed;  //was static
-   unsigned long tmp;
+size_t Format_line(char* s, long my_rank, unsigned val) {
+   char   digits[24];
+   int    d;
+   size_t len = 0;
 
-   if (seed != 0) z = seed;
-   
-   tmp = z*MR_MULTIPLIER; 
-   z = tmp % MR_MODULUS;
+   s[len++] = 'T';
+   s[len++] = 'h';
+   s[len++] = ' ';
+   d = 0;
+   do {
+      digits[d++] = '0' + my_rank % 10;
+      my_rank /= 10;
+   } while (my_rank > 0);
+   while (d > 0) s[len++] = digits[--d];
+   s[len++] = ' ';
+   s[len++] = '>';
+   s[len++] = ' ';
+   do {
+      digits[d++] = '0' + val % 10;
+      val /= 10;
+   } while (val > 0);
+   while (d > 0) s[len++] = digits[--d];
+   s[len++] = '\n';
 
-   return z;
-}  /* My_random */
\ No newline at end of file
+   return len;
+}  /* Format_line */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Write_round
+ * Purpose:     Write one round's buffers in rank order
+ * In arg:      half:  which of each thread's two buffers
+ * Global vars: iov (in/out), thread_count
+ */
+void Write_round(int half) {
+   Write_all(iov + half*thread_count, thread_count);
+}  /* Write_round */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Write_all
+ * Purpose:     writev all of iov to stdout, at most IOV_MAX entries
+ *              at a time, retrying after short writes
+ * In arg:      count
+ * In/out arg:  iov:  entries are used up as they're written
+ */
+void Write_all(struct iovec iov[], int count) {
+   ssize_t put;
+   int     first = 0;
+
+   while (first < count) {
+      put = writev(STDOUT_FILENO, iov + first,
+            (count - first < IOV_MAX) ? count - first : IOV_MAX);
+      if (put < 0) {
+         if (errno == EINTR) continue;
+         perror("writev");
+         exit(1);
+      }
+      while (first < count && (size_t) put >= iov[first].iov_len) {
+         put -= iov[first].iov_len;
+         first++;
+      }
+      if (first < count) {
+         iov[first].iov_base = (char*) iov[first].iov_base + put;
+         iov[first].iov_len -= put;
+      }
+   }
+}  /* Write_all */
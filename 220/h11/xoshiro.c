@@ -0,0 +1,239 @@
+/* File:  
+ *    xoshiro.c
+ *
+ * Author: Cayla Shaver
+ * Section: 2
+ * Purpose:
+ *    xoshiro256** (Blackman and Vigna) with jump-ahead substreams and
+ *    vectorizable bulk fills.  See xoshiro.h.
+ *
+ * Compile:
+ *    link with the caller, e.g.
+ *    gcc -g -Wall -O3 -march=native -o pth_rand pth_rand.c xoshiro.c
+ *       -lpthread
+ *
+ * Notes:
+ *    1.  Xoshiro_stream(g, seed, proc, thread) seeds g from seed with
+ *        splitmix64, then does proc long jumps (2^192 values each)
+ *        and thread jumps (2^128 values each).  So as long as no
+ *        stream uses more than 2^128 values and there are fewer than
+ *        2^64 threads per process, no two streams overlap.
+ *    2.  A xoshiro_bulk_t is XOSHIRO_LANES copies of a generator,
+ *        each one jump ahead of the one before.  The fills take one
+ *        value from every lane in turn, so they produce a different
+ *        (but just as random) sequence than Xoshiro_next, and they
+ *        use up XOSHIRO_LANES jumps of the stream:  give the next
+ *        thread a stream at least that many jumps further on.  The
+ *        multiplies by 5 and 9 are shifts and adds, so the step of
+ *        all the lanes vectorizes with plain SSE2/AVX2.
+ */
+#include <string.h>
+#include "xoshiro.h"
+
+static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL,
+   0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+static const uint64_t LONG_JUMP[] = {0x76e15d3efefdcbbfULL,
+   0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+
+static uint64_t Rotl(uint64_t x, int k);
+static void     Do_jump(xoshiro_t* g, const uint64_t poly[]);
+static void     Bulk_step(xoshiro_bulk_t* b, uint64_t out[]);
+
+/*-------------------------------------------------------------------
+ * Function:    Rotl
+ * Purpose:     Rotate x left k bits
+ */
+static uint64_t Rotl(uint64_t x, int k) {
+   return (x << k) | (x >> (64 - k));
+}  /* Rotl */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_seed
+ * Purpose:     Fill the state of g from a 64-bit seed with splitmix64
+ * In arg:      seed
+ * Out arg:     g
+ */
+void Xoshiro_seed(xoshiro_t* g, uint64_t seed) {
+   uint64_t z;
+   int      i;
+
+   for (i = 0; i < 4; i++) {
+      z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+      g->s[i] = z ^ (z >> 31);
+   }
+}  /* Xoshiro_seed */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_next
+ * Purpose:     Return the next 64-bit value of g's stream
+ * In/out arg:  g
+ */
+uint64_t Xoshiro_next(xoshiro_t* g) {
+   uint64_t* s = g->s;
+   uint64_t  result = Rotl(s[1]*5, 7)*9;
+   uint64_t  t = s[1] << 17;
+
+   s[2] ^= s[0];
+   s[3] ^= s[1];
+   s[1] ^= s[2];
+   s[0] ^= s[3];
+   s[2] ^= t;
+   s[3] = Rotl(s[3], 45);
+
+   return result;
+}  /* Xoshiro_next */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_double
+ * Purpose:     Return a double uniformly distributed in [0, 1)
+ * In/out arg:  g
+ */
+double Xoshiro_double(xoshiro_t* g) {
+   return (Xoshiro_next(g) >> 11)*0x1.0p-53;
+}  /* Xoshiro_double */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Do_jump
+ * Purpose:     Advance g by the number of steps encoded in poly
+ * In arg:      poly:  JUMP or LONG_JUMP
+ * In/out arg:  g
+ */
+static void Do_jump(xoshiro_t* g, const uint64_t poly[]) {
+   uint64_t t[4] = {0, 0, 0, 0};
+   int      i, b, j;
+
+   for (i = 0; i < 4; i++)
+      for (b = 0; b < 64; b++) {
+         if (poly[i] & (1ULL << b))
+            for (j = 0; j < 4; j++)
+               t[j] ^= g->s[j];
+         Xoshiro_next(g);
+      }
+   memcpy(g->s, t, sizeof(t));
+}  /* Do_jump */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_jump, Xoshiro_long_jump
+ * Purpose:     Advance g by 2^128 or 2^192 steps
+ * In/out arg:  g
+ */
+void Xoshiro_jump(xoshiro_t* g) {
+   Do_jump(g, JUMP);
+}  /* Xoshiro_jump */
+
+void Xoshiro_long_jump(xoshiro_t* g) {
+   Do_jump(g, LONG_JUMP);
+}  /* Xoshiro_long_jump */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_stream
+ * Purpose:     Set g to the substream for thread thread of process
+ *              proc (see note 1)
+ * In args:     seed, proc, thread
+ * Out arg:     g
+ */
+void Xoshiro_stream(xoshiro_t* g, uint64_t seed, long proc, long thread) {
+   long i;
+
+   Xoshiro_seed(g, seed);
+   for (i = 0; i < proc; i++)
+      Xoshiro_long_jump(g);
+   for (i = 0; i < thread; i++)
+      Xoshiro_jump(g);
+}  /* Xoshiro_stream */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_bulk_init
+ * Purpose:     Set up XOSHIRO_LANES lanes starting at g's state, each
+ *              one jump after the one before.  g is left one jump
+ *              after the last lane.
+ * In/out arg:  g
+ * Out arg:     b
+ */
+void Xoshiro_bulk_init(xoshiro_bulk_t* b, xoshiro_t* g) {
+   int lane, i;
+
+   for (lane = 0; lane < XOSHIRO_LANES; lane++) {
+      for (i = 0; i < 4; i++)
+         b->s[i][lane] = g->s[i];
+      Xoshiro_jump(g);
+   }
+}  /* Xoshiro_bulk_init */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Bulk_step
+ * Purpose:     Advance every lane one step
+ * In/out arg:  b
+ * Out arg:     out:  one value from each lane
+ */
+static void Bulk_step(xoshiro_bulk_t* b, uint64_t out[]) {
+   uint64_t* restrict s0 = b->s[0];
+   uint64_t* restrict s1 = b->s[1];
+   uint64_t* restrict s2 = b->s[2];
+   uint64_t* restrict s3 = b->s[3];
+   uint64_t  x, t;
+   int       lane;
+
+   for (lane = 0; lane < XOSHIRO_LANES; lane++) {
+      x = (s1[lane] << 2) + s1[lane];          /* s1*5 */
+      x = (x << 7) | (x >> 57);
+      out[lane] = (x << 3) + x;                /* *9   */
+      t = s1[lane] << 17;
+      s2[lane] ^= s0[lane];
+      s3[lane] ^= s1[lane];
+      s1[lane] ^= s2[lane];
+      s0[lane] ^= s3[lane];
+      s2[lane] ^= t;
+      s3[lane] = (s3[lane] << 45) | (s3[lane] >> 19);
+   }
+}  /* Bulk_step */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_fill_u64
+ * Purpose:     Fill out with n random 64-bit values
+ * In arg:      n
+ * In/out arg:  b
+ * Out arg:     out
+ */
+void Xoshiro_fill_u64(xoshiro_bulk_t* b, uint64_t out[], size_t n) {
+   uint64_t last[XOSHIRO_LANES];
+   size_t   i;
+
+   for (i = 0; i + XOSHIRO_LANES <= n; i += XOSHIRO_LANES)
+      Bulk_step(b, out + i);
+   if (i < n) {
+      Bulk_step(b, last);
+      memcpy(out + i, last, (n - i)*sizeof(uint64_t));
+   }
+}  /* Xoshiro_fill_u64 */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Xoshiro_fill_double
+ * Purpose:     Fill out with n doubles uniformly distributed in [0, 1)
+ * In arg:      n
+ * In/out arg:  b
+ * Out arg:     out
+ */
+void Xoshiro_fill_double(xoshiro_bulk_t* b, double out[], size_t n) {
+   uint64_t bits[XOSHIRO_LANES];
+   size_t   i, lane, len;
+
+   for (i = 0; i < n; i += XOSHIRO_LANES) {
+      Bulk_step(b, bits);
+      len = (n - i < XOSHIRO_LANES) ? n - i : XOSHIRO_LANES;
+      for (lane = 0; lane < len; lane++)
+         out[i + lane] = (bits[lane] >> 11)*0x1.0p-53;
+   }
+}  /* Xoshiro_fill_double */
@@ -0,0 +1,49 @@
+/* File:  
+ *    xoshiro.h
+ *
+ * Author: Cayla Shaver
+ * Section: 2
+ * Purpose:
+ *    Interface to xoshiro256**, a fast 64-bit random number generator
+ *    with period 2^256 - 1 that can jump ahead 2^128 or 2^192 values
+ *    in constant time.  Jumping gives every thread (and every MPI
+ *    process) its own substream that can't overlap anyone else's.
+ *
+ * Example:
+ *    #include "xoshiro.h"
+ *    . . .
+ *    xoshiro_t g;
+ *    Xoshiro_stream(&g, seed, my_proc_rank, my_thread_rank);
+ *    x = Xoshiro_double(&g);
+ */
+#ifndef _XOSHIRO_H_
+#define _XOSHIRO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Number of interleaved generators in a xoshiro_bulk_t */
+#define XOSHIRO_LANES 8
+
+typedef struct {
+   uint64_t s[4];
+} xoshiro_t;
+
+/* XOSHIRO_LANES generators stored lane by lane, so one step of all of
+ * them is a loop over contiguous arrays that the compiler vectorizes */
+typedef struct {
+   uint64_t s[4][XOSHIRO_LANES] __attribute__((aligned(64)));
+} xoshiro_bulk_t;
+
+void     Xoshiro_seed(xoshiro_t* g, uint64_t seed);
+uint64_t Xoshiro_next(xoshiro_t* g);
+double   Xoshiro_double(xoshiro_t* g);
+void     Xoshiro_jump(xoshiro_t* g);
+void     Xoshiro_long_jump(xoshiro_t* g);
+void     Xoshiro_stream(xoshiro_t* g, uint64_t seed, long proc, long thread);
+
+void     Xoshiro_bulk_init(xoshiro_bulk_t* b, xoshiro_t* g);
+void     Xoshiro_fill_u64(xoshiro_bulk_t* b, uint64_t out[], size_t n);
+void     Xoshiro_fill_double(xoshiro_bulk_t* b, double out[], size_t n);
+
+#endif
@@ -4,7 +4,7 @@
  *
  * Purpose:    A "hello,world" program that uses MPI
  *
- * Compile:    mpicc -g -Wall -o mpi_hello0 mpi_hello0.c
+ * Compile:    mpicc -g -Wall -I.. -o mpi_hello0 mpi_hello0.c ../ring.c
  * Run:        mpiexec -n<number of processes> ./mpi_hello0
  *
  * Input:      None
@@ -14,17 +14,23 @@
  * Algorithm:  Each process sends a message to process 0,
  *             which prints the messages it has received,
  *             as well as its own message.
+ *
+ * Note:       The send and receive are done together by Ring_shift
+ *             (../ring.c), so this still works if the messages are
+ *             too long for MPI to buffer.  mpi_p2p_bench.c times this
+ *             kind of exchange for a range of message sizes.
  */
 #include <stdio.h>
 #include <string.h>  /* For strlen             */
 #include <mpi.h>     /* For MPI functions, etc */
+#include "ring.h"    /* For Ring_shift         */
 
 const int MAX_STRING = 100;
 
 int main(void) {
    char       greeting[MAX_STRING];
+   char       received[MAX_STRING];
    int        my_rank, p;
-   int        dest, source;
 
    /* Start up MPI */
    MPI_Init(NULL, NULL);
@@ -35,20 +41,15 @@ int main(void) {
    /* Get my rank among all the processes */
    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
 
-   dest = (my_rank + 1) % p;
-   source = (my_rank + p - 1) % p;
-
    if (p == 1) {
       printf("Argh I be from %d. \n", my_rank);
    } else {
       sprintf(greeting, "Argh I be from %d ", 
             my_rank);
-      MPI_Send(greeting, strlen(greeting)+1, MPI_CHAR, dest, 0,
-            MPI_COMM_WORLD);
-      MPI_Recv(greeting, MAX_STRING, MPI_CHAR, source, 
-            0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      Ring_shift(greeting, strlen(greeting)+1, received, MAX_STRING,
+            MPI_CHAR, MPI_COMM_WORLD);
       printf("Argh this be my process %d received a message: %s \n", 
-         my_rank, greeting);
+         my_rank, received);
 
    }
 
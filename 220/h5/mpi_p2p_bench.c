@@ -0,0 +1,406 @@
+/* File:       mpi_p2p_bench.c
+ * Author:     Cayla Shaver
+ * Section:    2
+ *
+ * Purpose:    Point-to-point microbenchmarks for qualifying the MPI
+ *             fabric:  what mpi_hello0.c does once with a short
+ *             string, timed over a range of message sizes.
+ *
+ * Compile:    mpicc -g -Wall -O2 -o mpi_p2p_bench mpi_p2p_bench.c
+ * Run:        mpiexec -n <p> ./mpi_p2p_bench [test [mode [min [max [reps]]]]]
+ *                test:  l = ping-pong latency
+ *                       w = streaming bandwidth
+ *                       x = bidirectional bandwidth
+ *                       r = ring exchange (uses all p processes)
+ *                       a = all of them (default)
+ *                mode:  b = blocking, n = non-blocking,
+ *                       p = persistent requests, a = all (default)
+ *                min, max:  message sizes in bytes, default 1 and
+ *                       64 MB.  Sizes run over min, 2*min, 4*min, ...
+ *                reps:  timed iterations for messages up to 64 KB,
+ *                       default 1000.  Longer messages get fewer.
+ *
+ * Input:      None
+ * Output:     One CSV line per test, mode and size:
+ *                test,mode,bytes,iters,min_us,p50_us,p90_us,p99_us,
+ *                max_us,MB_per_s
+ *             MB_per_s uses the median time.
+ *
+ * Notes:
+ *    1.  l, w and x run between process 0 and process p-1, so with
+ *        the usual block mapping of processes to nodes they measure
+ *        the link between the first and last node.  The others just
+ *        wait.  Process 0 times every iteration, and the percentiles
+ *        come from those times.
+ *    2.  l reports the one way time:  half of a round trip.
+ *    3.  w:  process 0 sends a window of messages and process p-1
+ *        answers with a 1 byte ack, so each iteration moves
+ *        window*bytes bytes.  x:  both processes send a window to
+ *        each other at the same time, so 2*window*bytes.  The window
+ *        is WINDOW messages, or fewer so that it's at most
+ *        WINDOW_BYTES.
+ *    4.  r:  every process sends to process my_rank+1 and receives
+ *        from my_rank-1 at once.  MB_per_s is per process.
+ *    5.  Each iteration is a list of sends and receives in one or two
+ *        phases (Build_ops).  b does a phase with MPI_Send/MPI_Recv,
+ *        or with MPI_Sendrecv when it has both sends and receives
+ *        (sending first would deadlock past the eager limit).  n
+ *        posts the phase with MPI_Irecv/MPI_Isend and waits for all of
+ *        it.  p sets the requests up once per size with
+ *        MPI_Recv_init/MPI_Send_init and just starts them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#define WINDOW 64
+#define WINDOW_BYTES (16 << 20)
+#define MAX_OPS (2*WINDOW + 1)
+#define WARMUP 3
+
+const int DEF_MAX = 64 << 20;
+const int DEF_REPS = 1000;
+const int FULL_REPS_MAX = 65536;   /* Longer messages get fewer reps */
+
+typedef struct {
+   int   is_send;
+   char* buf;
+   int   bytes;
+   int   peer;
+} op_t;
+
+typedef struct {
+   op_t        ops[MAX_OPS];
+   int         n_ops;
+   int         phase_end[2];       /* ops [0, phase_end[0]) are phase 0 */
+   int         n_phases;
+   MPI_Request reqs[MAX_OPS];
+} iter_t;
+
+void   Usage(char* prog_name, int my_rank);
+int    Window(int bytes);
+int    Iterations(int bytes, int reps);
+void   Build_ops(iter_t* it, char test, int bytes, char* sbuf, char* rbuf,
+          char* ack, int my_rank, int p);
+void   Init_persistent(iter_t* it, MPI_Comm comm);
+void   Free_persistent(iter_t* it);
+void   Run_iteration(iter_t* it, char mode, MPI_Comm comm);
+void   Run(char test, char mode, int bytes, int reps, char* sbuf, char* rbuf,
+          int my_rank, int p, MPI_Comm comm);
+int    Cmp_double(const void* a, const void* b);
+double Percentile(double sorted[], int n, double q);
+
+int main(int argc, char* argv[]) {
+   int      my_rank, p;
+   MPI_Comm comm;
+   char     test = 'a', mode = 'a';
+   int      min_b = 1, max_b = DEF_MAX, reps = DEF_REPS, bytes, buf_bytes;
+   const char* tests = "lwxr";
+   const char* modes = "bnp";
+   const char* t;
+   const char* m;
+   char*    sbuf;
+   char*    rbuf;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   if (argc > 1) test = argv[1][0];
+   if (argc > 2) mode = argv[2][0];
+   if (argc > 3) min_b = strtol(argv[3], NULL, 10);
+   if (argc > 4) max_b = strtol(argv[4], NULL, 10);
+   if (argc > 5) reps = strtol(argv[5], NULL, 10);
+   if (argc > 6 || strchr("lwxra", test) == NULL ||
+         strchr("bnpa", mode) == NULL || min_b <= 0 || max_b < min_b ||
+         reps <= 0)
+      Usage(argv[0], my_rank);
+   if (p < 2) {
+      if (my_rank == 0) fprintf(stderr, "Need at least 2 processes\n");
+      MPI_Finalize();
+      return 0;
+   }
+
+   /* Big enough for the largest window */
+   buf_bytes = 0;
+   for (bytes = min_b; bytes > 0 && bytes <= max_b; bytes *= 2)
+      if (Window(bytes)*bytes > buf_bytes) buf_bytes = Window(bytes)*bytes;
+   sbuf = malloc(buf_bytes);
+   rbuf = malloc(buf_bytes);
+   memset(sbuf, my_rank, buf_bytes);
+
+   if (my_rank == 0)
+      printf("test,mode,bytes,iters,min_us,p50_us,p90_us,p99_us,max_us,MB_per_s\n");
+   for (t = tests; *t != '\0'; t++) {
+      if (test != 'a' && test != *t) continue;
+      for (m = modes; *m != '\0'; m++) {
+         if (mode != 'a' && mode != *m) continue;
+         for (bytes = min_b; bytes > 0 && bytes <= max_b; bytes *= 2)
+            Run(*t, *m, bytes, reps, sbuf, rbuf, my_rank, p, comm);
+      }
+   }
+
+   free(sbuf);
+   free(rbuf);
+   MPI_Finalize();
+   return 0;
+}  /* main */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Usage
+ * Purpose:     Print a message showing how to run the program and quit
+ * In args:     prog_name, my_rank
+ */
+void Usage(char* prog_name, int my_rank) {
+   if (my_rank == 0) {
+      fprintf(stderr, "usage: mpiexec -n <p> %s [test [mode [min [max [reps]]]]]\n",
+            prog_name);
+      fprintf(stderr, "   test:  l (latency), w (bandwidth), x (bidirectional),\n");
+      fprintf(stderr, "          r (ring), a (all)\n");
+      fprintf(stderr, "   mode:  b (blocking), n (non-blocking), p (persistent), a (all)\n");
+   }
+   MPI_Finalize();
+   exit(0);
+}  /* Usage */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Window
+ * Purpose:     Number of messages of bytes bytes in a w or x window
+ */
+int Window(int bytes) {
+   int w = WINDOW_BYTES/bytes;
+
+   if (w > WINDOW) return WINDOW;
+   if (w < 1) return 1;
+   return w;
+}  /* Window */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Iterations
+ * Purpose:     Number of timed iterations for bytes byte messages:
+ *              reps up to FULL_REPS_MAX bytes, then scaled down so the
+ *              total volume stays about the same, but at least 10
+ */
+int Iterations(int bytes, int reps) {
+   long iters = reps;
+
+   if (bytes > FULL_REPS_MAX)
+      iters = (long) reps*FULL_REPS_MAX/bytes;
+   return (iters < 10) ? 10 : (int) iters;
+}  /* Iterations */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Build_ops
+ * Purpose:     List the sends and receives this process does in one
+ *              iteration of test (notes 3-5)
+ * In args:     test, bytes, sbuf, rbuf, ack, my_rank, p
+ * Out arg:     it:  ops, n_ops, phase_end, n_phases.  n_ops = 0 if
+ *                 this process sits the test out.
+ */
+void Build_ops(iter_t* it, char test, int bytes, char* sbuf, char* rbuf,
+      char* ack, int my_rank, int p) {
+   int   last = p - 1, window = Window(bytes), i, n = 0;
+   op_t* ops = it->ops;
+
+   it->n_phases = 1;
+   if (test == 'r') {
+      ops[n++] = (op_t) {0, rbuf, bytes, (my_rank + p - 1) % p};
+      ops[n++] = (op_t) {1, sbuf, bytes, (my_rank + 1) % p};
+      it->phase_end[0] = n;
+   } else if (my_rank != 0 && my_rank != last) {
+      /* Sit out */
+   } else if (test == 'l') {
+      it->n_phases = 2;
+      if (my_rank == 0) {
+         ops[n++] = (op_t) {1, sbuf, bytes, last};
+         it->phase_end[0] = n;
+         ops[n++] = (op_t) {0, rbuf, bytes, last};
+      } else {
+         ops[n++] = (op_t) {0, rbuf, bytes, 0};
+         it->phase_end[0] = n;
+         ops[n++] = (op_t) {1, sbuf, bytes, 0};
+      }
+      it->phase_end[1] = n;
+   } else if (test == 'w') {
+      it->n_phases = 2;
+      for (i = 0; i < window; i++)
+         if (my_rank == 0)
+            ops[n++] = (op_t) {1, sbuf + (long) i*bytes, bytes, last};
+         else
+            ops[n++] = (op_t) {0, rbuf + (long) i*bytes, bytes, 0};
+      it->phase_end[0] = n;
+      ops[n++] = (op_t) {my_rank != 0, ack, 1, (my_rank == 0) ? last : 0};
+      it->phase_end[1] = n;
+   } else {  /* test == 'x' */
+      for (i = 0; i < window; i++)
+         ops[n++] = (op_t) {0, rbuf + (long) i*bytes, bytes, last - my_rank};
+      for (i = 0; i < window; i++)
+         ops[n++] = (op_t) {1, sbuf + (long) i*bytes, bytes, last - my_rank};
+      it->phase_end[0] = n;
+   }
+   it->n_ops = n;
+}  /* Build_ops */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Init_persistent, Free_persistent
+ * Purpose:     Set up (free) a persistent request for each op in it
+ * In arg:      comm
+ * In/out arg:  it
+ */
+void Init_persistent(iter_t* it, MPI_Comm comm) {
+   int   i;
+   op_t* o;
+
+   for (i = 0; i < it->n_ops; i++) {
+      o = &it->ops[i];
+      if (o->is_send)
+         MPI_Send_init(o->buf, o->bytes, MPI_BYTE, o->peer, 0, comm,
+               &it->reqs[i]);
+      else
+         MPI_Recv_init(o->buf, o->bytes, MPI_BYTE, o->peer, 0, comm,
+               &it->reqs[i]);
+   }
+}  /* Init_persistent */
+
+void Free_persistent(iter_t* it) {
+   int i;
+
+   for (i = 0; i < it->n_ops; i++)
+      MPI_Request_free(&it->reqs[i]);
+}  /* Free_persistent */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Run_iteration
+ * Purpose:     Do the ops in it once, phase by phase, in mode (note 5)
+ * In args:     mode, comm
+ * In/out arg:  it:  reqs
+ */
+void Run_iteration(iter_t* it, char mode, MPI_Comm comm) {
+   int   ph, first = 0, last, i, j, sends;
+   op_t* o;
+   op_t* r;
+
+   for (ph = 0; ph < it->n_phases; first = it->phase_end[ph], ph++) {
+      last = it->phase_end[ph];
+      if (mode == 'p') {
+         MPI_Startall(last - first, it->reqs + first);
+         MPI_Waitall(last - first, it->reqs + first, MPI_STATUSES_IGNORE);
+      } else if (mode == 'n') {
+         /* Receives come first in the list, so they're posted first */
+         for (i = first; i < last; i++) {
+            o = &it->ops[i];
+            if (o->is_send)
+               MPI_Isend(o->buf, o->bytes, MPI_BYTE, o->peer, 0, comm,
+                     &it->reqs[i]);
+            else
+               MPI_Irecv(o->buf, o->bytes, MPI_BYTE, o->peer, 0, comm,
+                     &it->reqs[i]);
+         }
+         MPI_Waitall(last - first, it->reqs + first, MPI_STATUSES_IGNORE);
+      } else {
+         for (sends = 0, i = first; i < last; i++)
+            sends += it->ops[i].is_send;
+         if (sends == 0 || sends == last - first) {
+            for (i = first; i < last; i++) {
+               o = &it->ops[i];
+               if (o->is_send)
+                  MPI_Send(o->buf, o->bytes, MPI_BYTE, o->peer, 0, comm);
+               else
+                  MPI_Recv(o->buf, o->bytes, MPI_BYTE, o->peer, 0, comm,
+                        MPI_STATUS_IGNORE);
+            }
+         } else {
+            /* Pair the k-th receive with the k-th send */
+            for (i = first, j = first; i < last && j < last; i++, j++) {
+               while (i < last && it->ops[i].is_send) i++;
+               while (j < last && !it->ops[j].is_send) j++;
+               if (i == last || j == last) break;
+               r = &it->ops[i];
+               o = &it->ops[j];
+               MPI_Sendrecv(o->buf, o->bytes, MPI_BYTE, o->peer, 0,
+                     r->buf, r->bytes, MPI_BYTE, r->peer, 0, comm,
+                     MPI_STATUS_IGNORE);
+            }
+         }
+      }
+   }
+}  /* Run_iteration */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Run
+ * Purpose:     Time one test in one mode with one message size and
+ *              print a line of results on process 0
+ * In args:     test, mode, bytes, reps, sbuf, rbuf, my_rank, p, comm
+ */
+void Run(char test, char mode, int bytes, int reps, char* sbuf, char* rbuf,
+      int my_rank, int p, MPI_Comm comm) {
+   iter_t  it;
+   char    ack = 0;
+   int     iters = Iterations(bytes, reps), i;
+   double* times = malloc(iters*sizeof(double));
+   double  start, p50, moved;
+
+   Build_ops(&it, test, bytes, sbuf, rbuf, &ack, my_rank, p);
+   if (mode == 'p') Init_persistent(&it, comm);
+
+   MPI_Barrier(comm);
+   for (i = -WARMUP; i < iters; i++) {
+      start = MPI_Wtime();
+      if (it.n_ops > 0) Run_iteration(&it, mode, comm);
+      if (i >= 0) times[i] = MPI_Wtime() - start;
+   }
+   MPI_Barrier(comm);
+
+   if (mode == 'p') Free_persistent(&it);
+
+   if (my_rank == 0) {
+      if (test == 'l')
+         for (i = 0; i < iters; i++)
+            times[i] /= 2;
+      qsort(times, iters, sizeof(double), Cmp_double);
+      p50 = Percentile(times, iters, 0.5);
+      if (test == 'w')
+         moved = (double) Window(bytes)*bytes;
+      else if (test == 'x')
+         moved = 2.0*Window(bytes)*bytes;
+      else
+         moved = bytes;
+      printf("%c,%c,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f\n", test, mode,
+            bytes, iters, 1e6*times[0], 1e6*p50,
+            1e6*Percentile(times, iters, 0.9),
+            1e6*Percentile(times, iters, 0.99), 1e6*times[iters-1],
+            moved/p50/1e6);
+      fflush(stdout);
+   }
+   free(times);
+}  /* Run */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Percentile
+ * Purpose:     Nearest rank percentile q (0 <= q <= 1) of n sorted
+ *              values
+ */
+double Percentile(double sorted[], int n, double q) {
+   return sorted[(int) (q*(n - 1) + 0.5)];
+}  /* Percentile */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Cmp_double
+ * Purpose:     Compare two doubles for qsort
+ */
+int Cmp_double(const void* a, const void* b) {
+   double x = *(const double*) a, y = *(const double*) b;
+
+   return (x > y) - (x < y);
+}  /* Cmp_double */
@@ -0,0 +1,256 @@
+/* File:     bcast.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the broadcasts in bcast.h
+ *
+ * Compile:  link with the caller and ../hier.c, e.g.
+ *           mpicc -g -Wall -O2 -I.. -o bd bcast_driver.c bcast.c ../hier.c
+ *
+ * Notes:
+ *    1.  All the algorithms work with ranks relative to the root,
+ *        vr = (my_rank - root + p) % p, so any process can be the
+ *        root.  The buffer is treated as bytes, so type must be
+ *        contiguous, and it must be the same on every process.
+ *    2.  The binomial tree:  the parent of vr is vr with its lowest
+ *        1 bit cleared, and its children are vr + mask for the
+ *        powers of 2 mask below that bit (below p for vr = 0), as
+ *        long as vr + mask < p.  So it works for any p.  The largest
+ *        subtree is sent to first.
+ *    3.  Sending the whole message down the tree takes log p times
+ *        as long as one send.  Pipelining splits it into BC_SEG byte
+ *        segments:  an interior process passes segment s on to its
+ *        children while it's receiving segment s+1, so for long
+ *        messages the time approaches (depth + segments)*segment
+ *        time instead of depth*(message time).
+ *    4.  Scatter + allgather (van de Geijn):  split the message into
+ *        p blocks, scatter them down the binomial tree, then pass
+ *        them around a ring p-1 times.  Each process sends and
+ *        receives about 2n bytes no matter how large p is, which
+ *        wins for very long messages.
+ *    5.  BC_AUTO uses the binomial tree below BC_SHORT_MSG bytes (or
+ *        with fewer than 3 processes, where there's nothing to
+ *        pipeline), the pipeline below BC_LONG_MSG and scatter +
+ *        allgather above.  bcast_bench.c will show where the
+ *        crossovers are on a given system.
+ *    6.  Hier_bcast_buf gets the message to the leader of the root's
+ *        node, runs one of the algorithms above among the node
+ *        leaders only, and then each leader copies it to the rest of
+ *        its node through shared memory.  So the message crosses
+ *        between nodes num_nodes - 1 times instead of up to p - 1.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bcast.h"
+
+static void Binomial(char* buf, int bytes, int vr, int p, int root,
+      MPI_Comm comm);
+static void Pipeline(char* buf, int bytes, int vr, int p, int root,
+      MPI_Comm comm);
+static void Scatter_allgather(char* buf, int bytes, int vr, int p,
+      int root, MPI_Comm comm);
+static int  Low_bit(int vr, int p);
+static int  Block_start(int b, int bytes, int p);
+
+/*-----------------------------------------------------------------
+ * Function:    Bcast_alg
+ * Purpose:     Convert a command line letter (b, p, s, a, m) to an
+ *              algorithm
+ * In arg:      c
+ * Ret val:     The algorithm, or -1 if c isn't one of the letters
+ */
+bc_alg_t Bcast_alg(char c) {
+   switch (c) {
+      case 'b': return BC_BINOMIAL;
+      case 'p': return BC_PIPELINE;
+      case 's': return BC_SCATTER;
+      case 'a': return BC_AUTO;
+      case 'm': return BC_MPI;
+      default:  return (bc_alg_t) -1;
+   }
+}  /* Bcast_alg */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Bcast_name
+ * Purpose:     Inverse of Bcast_alg
+ * In arg:      alg
+ */
+char Bcast_name(bc_alg_t alg) {
+   return "bpsam"[alg];
+}  /* Bcast_name */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Bcast_buf
+ * Purpose:     Broadcast count elements of type type in buf from
+ *              process root to every process in comm
+ * In args:     count, type, root, alg, comm
+ * In/out arg:  buf:  in on root, out on the other processes
+ */
+void Bcast_buf(void* buf, int count, MPI_Datatype type, int root,
+      bc_alg_t alg, MPI_Comm comm) {
+   int p, my_rank, vr, size, bytes;
+
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+   MPI_Type_size(type, &size);
+   bytes = count*size;
+   vr = (my_rank - root + p) % p;
+
+   if (alg == BC_AUTO) {
+      if (bytes < BC_SHORT_MSG || p < 3)
+         alg = BC_BINOMIAL;
+      else if (bytes < BC_LONG_MSG)
+         alg = BC_PIPELINE;
+      else
+         alg = BC_SCATTER;
+   }
+
+   switch (alg) {
+      case BC_BINOMIAL:
+         Binomial(buf, bytes, vr, p, root, comm);
+         break;
+      case BC_PIPELINE:
+         Pipeline(buf, bytes, vr, p, root, comm);
+         break;
+      case BC_SCATTER:
+         Scatter_allgather(buf, bytes, vr, p, root, comm);
+         break;
+      default:
+         MPI_Bcast(buf, count, type, root, comm);
+   }
+}  /* Bcast_buf */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_bcast_buf
+ * Purpose:     Node-aware version of Bcast_buf (note 6)
+ * In args:     h:  made by Hier_create on the communicator
+ *              count, type, root, alg
+ * In/out arg:  buf
+ */
+void Hier_bcast_buf(hier_t* h, void* buf, int count, MPI_Datatype type,
+      int root, bc_alg_t alg) {
+   int size, bytes;
+
+   MPI_Type_size(type, &size);
+   bytes = count*size;
+
+   Hier_root_to_leader(h, buf, bytes, root);
+   if (h->leaders != MPI_COMM_NULL)
+      Bcast_buf(buf, count, type, h->leader_of[root], alg, h->leaders);
+   Hier_node_bcast(h, buf, bytes);
+}  /* Hier_bcast_buf */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Low_bit
+ * Purpose:     Find the bit that connects vr to its parent in the
+ *              binomial tree
+ * Ret val:     The lowest 1 bit of vr, or the smallest power of 2
+ *              >= p if vr = 0
+ */
+static int Low_bit(int vr, int p) {
+   int mask = 1;
+
+   while (mask < p && !(vr & mask))
+      mask <<= 1;
+   return mask;
+}  /* Low_bit */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Binomial
+ * Purpose:     Send the whole buffer down the binomial tree (note 2)
+ */
+static void Binomial(char* buf, int bytes, int vr, int p, int root,
+      MPI_Comm comm) {
+   int low = Low_bit(vr, p), mask;
+
+   if (vr != 0)
+      MPI_Recv(buf, bytes, MPI_BYTE, (vr - low + root) % p, 0, comm,
+            MPI_STATUS_IGNORE);
+   for (mask = low >> 1; mask > 0; mask >>= 1)
+      if (vr + mask < p)
+         MPI_Send(buf, bytes, MPI_BYTE, (vr + mask + root) % p, 0, comm);
+}  /* Binomial */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Pipeline
+ * Purpose:     Send the buffer down the binomial tree in BC_SEG byte
+ *              segments (note 3)
+ */
+static void Pipeline(char* buf, int bytes, int vr, int p, int root,
+      MPI_Comm comm) {
+   int          low = Low_bit(vr, p), mask, children = 0;
+   int          segs = (bytes + BC_SEG - 1)/BC_SEG, s, len, r = 0;
+   MPI_Request* reqs;
+
+   for (mask = low >> 1; mask > 0; mask >>= 1)
+      if (vr + mask < p) children++;
+   reqs = malloc((segs*children + 1)*sizeof(MPI_Request));
+
+   for (s = 0; s < segs; s++) {
+      len = (bytes - s*BC_SEG < BC_SEG) ? bytes - s*BC_SEG : BC_SEG;
+      if (vr != 0)
+         MPI_Recv(buf + s*BC_SEG, len, MPI_BYTE, (vr - low + root) % p,
+               0, comm, MPI_STATUS_IGNORE);
+      for (mask = low >> 1; mask > 0; mask >>= 1)
+         if (vr + mask < p)
+            MPI_Isend(buf + s*BC_SEG, len, MPI_BYTE,
+                  (vr + mask + root) % p, 0, comm, &reqs[r++]);
+   }
+   MPI_Waitall(r, reqs, MPI_STATUSES_IGNORE);
+   free(reqs);
+}  /* Pipeline */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Scatter_allgather
+ * Purpose:     Scatter p blocks of the buffer down the binomial tree,
+ *              then allgather them around a ring (note 4)
+ */
+static void Scatter_allgather(char* buf, int bytes, int vr, int p,
+      int root, MPI_Comm comm) {
+   int low = Low_bit(vr, p), mask, hi, i, send_b, recv_b;
+   int right = (vr + 1 + root) % p, left = (vr - 1 + p + root) % p;
+
+   /* Scatter:  vr gets blocks vr, ..., vr + low - 1 from its parent */
+   if (vr != 0) {
+      hi = (vr + low < p) ? vr + low : p;
+      MPI_Recv(buf + Block_start(vr, bytes, p),
+            Block_start(hi, bytes, p) - Block_start(vr, bytes, p),
+            MPI_BYTE, (vr - low + root) % p, 0, comm, MPI_STATUS_IGNORE);
+   }
+   for (mask = low >> 1; mask > 0; mask >>= 1)
+      if (vr + mask < p) {
+         hi = (vr + 2*mask < p) ? vr + 2*mask : p;
+         MPI_Send(buf + Block_start(vr + mask, bytes, p),
+               Block_start(hi, bytes, p) - Block_start(vr + mask, bytes, p),
+               MPI_BYTE, (vr + mask + root) % p, 0, comm);
+      }
+
+   /* Ring allgather:  at step i pass on the block received at step
+    * i - 1 (our own block at step 0) */
+   for (i = 0; i < p - 1; i++) {
+      send_b = (vr - i + p) % p;
+      recv_b = (vr - i - 1 + p) % p;
+      MPI_Sendrecv(buf + Block_start(send_b, bytes, p),
+            Block_start(send_b + 1, bytes, p) - Block_start(send_b, bytes, p),
+            MPI_BYTE, right, 1,
+            buf + Block_start(recv_b, bytes, p),
+            Block_start(recv_b + 1, bytes, p) - Block_start(recv_b, bytes, p),
+            MPI_BYTE, left, 1, comm, MPI_STATUS_IGNORE);
+   }
+}  /* Scatter_allgather */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Block_start
+ * Purpose:     Offset of block b when bytes bytes are split into p
+ *              nearly equal blocks
+ */
+static int Block_start(int b, int bytes, int p) {
+   return (int) ((long) b*bytes/p);
+}  /* Block_start */
@@ -0,0 +1,45 @@
+/* File:     bcast.h
+ * Author:   Cayla Shaver
+ * Purpose:  Broadcasts of arbitrary contiguous buffers from any root
+ *           to any number of processes, built on point-to-point
+ *           communication:  a binomial tree, a binomial tree with the
+ *           message split into pipelined segments, and van de Geijn's
+ *           scatter + ring allgather.
+ *
+ * Example:
+ *    #include "bcast.h"
+ *    . . .
+ *    Bcast_buf(x, n, MPI_DOUBLE, 0, BC_AUTO, comm);
+ *
+ *    or, on a cluster of multicore nodes (see ../hier.h),
+ *    Hier_bcast_buf(&h, x, n, MPI_DOUBLE, 0, BC_AUTO);
+ */
+#ifndef _BCAST_H_
+#define _BCAST_H_
+
+#include <mpi.h>
+#include "hier.h"
+
+typedef enum {
+   BC_BINOMIAL,    /* b:  whole message down a binomial tree          */
+   BC_PIPELINE,    /* p:  BC_SEG byte segments pipelined down the tree */
+   BC_SCATTER,     /* s:  binomial scatter, then ring allgather        */
+   BC_AUTO,        /* a:  choose by message size                       */
+   BC_MPI          /* m:  MPI_Bcast                                    */
+} bc_alg_t;
+
+/* Message sizes in bytes where BC_AUTO switches algorithms */
+#define BC_SHORT_MSG 12288
+#define BC_LONG_MSG  524288
+
+/* Segment size for BC_PIPELINE */
+#define BC_SEG 8192
+
+bc_alg_t Bcast_alg(char c);
+char     Bcast_name(bc_alg_t alg);
+void     Bcast_buf(void* buf, int count, MPI_Datatype type, int root,
+               bc_alg_t alg, MPI_Comm comm);
+void     Hier_bcast_buf(hier_t* h, void* buf, int count, MPI_Datatype type,
+               int root, bc_alg_t alg);
+
+#endif
@@ -0,0 +1,144 @@
+/* File:     bcast_bench.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ *
+ * Purpose:  Time the broadcasts in bcast.c against MPI_Bcast for a
+ *           range of message sizes.
+ *
+ * Input:    None.
+ * Output:   One CSV line per algorithm and message size:
+ *              alg,hier,p,bytes,reps,min_s,median_s,MB_per_s,correct
+ *           hier is 1 for Hier_bcast_buf, 0 for Bcast_buf.  MB_per_s is
+ *           the message size over the median time.
+ *
+ * Compile:  mpicc -g -Wall -O2 -I.. -o bcast_bench bcast_bench.c bcast.c
+ *              ../hier.c
+ * Run:      mpiexec -n <p> bcast_bench <min bytes> <max bytes> [reps [root]]
+ *              The size runs over min, 2*min, 4*min, ... <= max.
+ *              reps defaults to 20 and root to 0.
+ *
+ * Notes:
+ *    1.  Before each rep the processes other than root clear their
+ *        buffers.  The time of a rep is the longest time taken by
+ *        any process.
+ *    2.  correct is 1 if every process got every byte on the last
+ *        rep.
+ *    3.  On one machine set HIER_PPN (see ../hier.h) to see what the
+ *        node-aware versions do with more than one node.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "bcast.h"
+
+void Usage(char* prog_name, int my_rank);
+int  Cmp_double(const void* a, const void* b);
+void Run(bc_alg_t alg, hier_t* h, int bytes, int reps, int root,
+      int my_rank, int p, MPI_Comm comm);
+
+int main(int argc, char* argv[]) {
+   int      p, my_rank;
+   MPI_Comm comm;
+   int      min_b, max_b, reps = 20, root = 0, bytes;
+   bc_alg_t alg;
+   hier_t   h;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   if (argc < 3 || argc > 5) Usage(argv[0], my_rank);
+   min_b = strtol(argv[1], NULL, 10);
+   max_b = strtol(argv[2], NULL, 10);
+   if (argc >= 4) reps = strtol(argv[3], NULL, 10);
+   if (argc == 5) root = strtol(argv[4], NULL, 10);
+   if (min_b <= 0 || max_b < min_b || reps <= 0 || root < 0 || root >= p)
+      Usage(argv[0], my_rank);
+
+   Hier_create(&h, comm);
+   if (my_rank == 0)
+      printf("alg,hier,p,bytes,reps,min_s,median_s,MB_per_s,correct\n");
+   for (bytes = min_b; bytes <= max_b && bytes > 0; bytes *= 2)
+      for (alg = BC_BINOMIAL; alg <= BC_MPI; alg++) {
+         Run(alg, NULL, bytes, reps, root, my_rank, p, comm);
+         Run(alg, &h, bytes, reps, root, my_rank, p, comm);
+      }
+   Hier_free(&h);
+
+   MPI_Finalize();
+   return 0;
+}  /* main */
+
+
+/*---------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print a message showing how to run the program and quit
+ * In args:   prog_name, my_rank
+ */
+void Usage(char* prog_name, int my_rank) {
+   if (my_rank == 0)
+      fprintf(stderr, "usage: mpiexec -n <p> %s <min bytes> <max bytes> [reps [root]]\n",
+            prog_name);
+   MPI_Finalize();
+   exit(0);
+}  /* Usage */
+
+
+/*---------------------------------------------------------------
+ * Function:  Run
+ * Purpose:   Time reps broadcasts of bytes bytes with alg, and print
+ *            the results on process 0
+ * In args:   alg
+ *            h:  NULL for Bcast_buf, else use Hier_bcast_buf
+ *            bytes, reps, root, my_rank, p, comm
+ */
+void Run(bc_alg_t alg, hier_t* h, int bytes, int reps, int root,
+      int my_rank, int p, MPI_Comm comm) {
+   char*   buf = malloc(bytes);
+   double* times = malloc(reps*sizeof(double));
+   double  start, elapsed, median;
+   int     i, r, ok = 1, all_ok;
+
+   if (my_rank == root)
+      for (i = 0; i < bytes; i++)
+         buf[i] = (char) (31*i + 7);
+
+   for (r = 0; r < reps; r++) {
+      if (my_rank != root) memset(buf, 0, bytes);
+      MPI_Barrier(comm);
+      start = MPI_Wtime();
+      if (h == NULL)
+         Bcast_buf(buf, bytes, MPI_BYTE, root, alg, comm);
+      else
+         Hier_bcast_buf(h, buf, bytes, MPI_BYTE, root, alg);
+      elapsed = MPI_Wtime() - start;
+      MPI_Reduce(&elapsed, &times[r], 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+   }
+   for (i = 0; i < bytes; i++)
+      if (buf[i] != (char) (31*i + 7)) ok = 0;
+   MPI_Reduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, 0, comm);
+
+   if (my_rank == 0) {
+      qsort(times, reps, sizeof(double), Cmp_double);
+      median = times[reps/2];
+      printf("%c,%d,%d,%d,%d,%e,%e,%.1f,%d\n", Bcast_name(alg),
+            h != NULL, p, bytes, reps, times[0], median,
+            bytes/median/1.0e6, all_ok);
+   }
+
+   free(times);
+   free(buf);
+}  /* Run */
+
+
+/*---------------------------------------------------------------
+ * Function:  Cmp_double
+ * Purpose:   Compare two doubles for qsort
+ */
+int Cmp_double(const void* a, const void* b) {
+   double x = *(const double*) a, y = *(const double*) b;
+
+   return (x > y) - (x < y);
+}  /* Cmp_double */
@@ -10,44 +10,49 @@
  *    2. Processes call Bcast
  *    3. Each process prints value it received
  *
- * Compile:  mpicc -g -Wall -o bd bcast_driver.c
+ * Compile:  mpicc -g -Wall -I.. -o bd bcast_driver.c bcast.c ../hier.c
  * Run:      mpiexec -n <number of processes> bd
  *
  * Notes:
- *    1. This program only needs to work when p is a power of 2.
- *    2. I suggest you used this tree:
- *       0->1
- *       0->2, 1->3
- *       0->4, 1->5, 2->6, 3->7
- *       etc.
- *   3.  This is NOT a working program:  the Bcast function uses
- *       pseudo-code.
+ *    1. This works for any p.
+ *    2. Bcast is a wrapper for Bcast_buf in bcast.c, which broadcasts
+ *       buffers of any length and picks the algorithm by message
+ *       size.  bcast_bench.c compares the algorithms with MPI_Bcast.
+ *    3. Bcast is node-aware:  the value goes between nodes only among
+ *       one leader process per node, and each leader passes it on to
+ *       the other processes on its node in shared memory (../hier.c).
+ *       Building the hierarchy takes several collectives, so main
+ *       builds it once and passes it to Bcast.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <mpi.h>
+#include "bcast.h"
 
-int Bcast(int in_val, int my_rank, int p, MPI_Comm comm);
+int Bcast(int in_val, hier_t* h);
 
 int main(int argc, char* argv[]) {
    int p, my_rank;
    MPI_Comm comm;
+   hier_t h;
    int result, in_val;
 
    MPI_Init(&argc, &argv);
    comm = MPI_COMM_WORLD;
    MPI_Comm_size(comm, &p);
    MPI_Comm_rank(comm, &my_rank);
+   Hier_create(&h, comm);
 
    if (my_rank == 0) {
       printf("Enter an int\n");
       scanf("%d", &in_val);
    }
 
-   result = Bcast(in_val, my_rank, p, comm);
+   result = Bcast(in_val, &h);
 
    printf("Proc %d > result = %d\n", my_rank, result); 
 
+   Hier_free(&h);
    MPI_Finalize();
    return 0;
 }  /* main */
@@ -59,49 +64,30 @@ int main(int argc, char* argv[]) {
  *              processes
  *
  * Input args:  in_val = the value to be broadcast from process 0
- *              my_rank = process's rank
- *              p = number of processes
- *              comm = communicator
+ *              h = made by Hier_create on the communicator
  * Return val:  on each process the value broadcast by process 0
  *
  * Notes:
- *    1.  Uses tree structured communication.
- *    2.  The pairing of the processes is done using bitwise
- *        exclusive or.  Here's a table showing the rule for
- *        for bitwise exclusive or
- *           X Y X^Y
- *           0 0  0
- *           0 1  1
- *           1 0  1
- *           1 1  0
- *        Here's a table showing the process pairing with 8
- *        processes (r = my_rank, other column heads are 
- *        bitmask)
- *           r     001 010 010 
- *           -     --- --- ---
- *           0 000 001 010 100  
- *           1 001 000 011 101
- *           2 010  x  000 110
- *           3 011  x  001 111
- *           4 100  x   x  000
- *           5 101  x   x  001
- *           6 110  x   x  010
- *           7 111  x   x  111
+ *    1.  Calls Hier_bcast_buf in bcast.c.  One
+ *        int is a short message, so among the node leaders BC_AUTO
+ *        sends it down Binomial's tree:  the parent of a process is
+ *        its rank with the lowest 1 bit cleared, and it sends to its
+ *        children largest subtree first.  Here's the tree with 8
+ *        leaders (r = rank among the leaders)
+ *           r  parent  children
+ *           -  ------  --------
+ *           0    -     4 2 1
+ *           1    0
+ *           2    0     3
+ *           3    2
+ *           4    0     6 5
+ *           5    4
+ *           6    4     7
+ *           7    6
+ *    2.  A child r + mask >= p is skipped, so any p works, and ranks
+ *        are taken relative to the root (bcast.c, notes 1 and 2).
  */
-int Bcast(int in_val, int my_rank, int p, MPI_Comm comm) {
-   int        partner;
-   unsigned   bitmask = 1;
-
-   while (bitmask < p) {
-      if (my_rank < bitmask * 2) {
-         partner = my_rank ^ bitmask ;
-         if (my_rank < partner)
-            MPI_Send(&in_val, 1, MPI_INT, partner, 0, comm);
-         else
-            MPI_Recv(&in_val, 1, MPI_INT, partner, 0, comm, 
-                  MPI_STATUS_IGNORE); 
-      }
-      bitmask <<= 1;
-   }
+int Bcast(int in_val, hier_t* h) {
+   Hier_bcast_buf(h, &in_val, 1, MPI_INT, 0, BC_AUTO);
    return in_val;
-}  /* Bcast */
\ No newline at end of file
+}  /* Bcast */
@@ -0,0 +1,325 @@
+/* File:     allreduce.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the global sums in allreduce.h
+ *
+ * Compile:  link with the caller and ../hier.c, e.g.
+ *           mpicc -g -Wall -O2 -I.. -o gs global_sum_driver.c allreduce.c
+ *              ../hier.c ../ring.c
+ *
+ * Notes:
+ *    1.  Recursive doubling and Rabenseifner both need a power of 2
+ *        processes.  With p = pof2 + rem, pof2 the largest power of 2
+ *        <= p, the first 2*rem processes pair up:  each even ranked
+ *        one sends its vector to the odd one above it, which adds it
+ *        in, and sits out.  The pof2 processes that are left are
+ *        renumbered 0, 1, ..., pof2-1, and when they're done each odd
+ *        process sends the result back to the even one below it.
+ *    2.  Recursive doubling:  at stage s process q exchanges its
+ *        whole vector with q ^ 2^s and adds.  log(pof2) messages of n
+ *        ints, so it's good when latency dominates.
+ *    3.  Rabenseifner:  split the vector into pof2 blocks.
+ *        Recursive halving (a reduce-scatter):  at each stage q
+ *        sends half of the blocks it's still responsible for to its
+ *        partner, gets and adds the partner's copy of the other half,
+ *        so after log(pof2) stages q has the sum of block q.  Then
+ *        recursive doubling gathers the blocks back up.  Each process
+ *        sends about 2n ints in all instead of n log(pof2).
+ *    4.  The message tags keep the stages apart, so a fast process
+ *        can't mix up one stage's message with the next's.
+ *    5.  Hier_allreduce_sum adds up the vectors on each node in
+ *        shared memory, runs one of the algorithms above among the
+ *        node leaders, and copies the result back out to each node in
+ *        shared memory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "allreduce.h"
+#include "ring.h"
+
+typedef struct {
+   int* x;
+   int  n;
+} add_arg_t;
+
+static void Add(int dst[], const int src[], int n);
+static void Add_block(const void* block, int hop, void* arg);
+static int  Fold_in(int x[], int n, int my_rank, int rem, MPI_Comm comm);
+static void Fold_out(int x[], int n, int my_rank, int rem, MPI_Comm comm);
+static int  Real_rank(int new_rank, int rem);
+static int  Block_start(int b, int n, int pof2);
+
+/*-----------------------------------------------------------------
+ * Function:    Allreduce_alg
+ * Purpose:     Convert a command line letter (r, d, h, a, m) to an
+ *              algorithm
+ * In arg:      c
+ * Ret val:     The algorithm, or -1 if c isn't one of the letters
+ */
+ar_alg_t Allreduce_alg(char c) {
+   switch (c) {
+      case 'r': return AR_RING;
+      case 'd': return AR_DOUBLING;
+      case 'h': return AR_RABENSEIFNER;
+      case 'a': return AR_AUTO;
+      case 'm': return AR_MPI;
+      default:  return (ar_alg_t) -1;
+   }
+}  /* Allreduce_alg */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Allreduce_name
+ * Purpose:     Inverse of Allreduce_alg
+ * In arg:      alg
+ */
+char Allreduce_name(ar_alg_t alg) {
+   return "rdham"[alg];
+}  /* Allreduce_name */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Allreduce_sum
+ * Purpose:     Replace x on every process with the elementwise sum of
+ *              x over the processes in comm
+ * In args:     n:  length of x (the same on every process)
+ *              alg:  which algorithm to use
+ *              comm
+ * In/out arg:  x
+ */
+void Allreduce_sum(int x[], int n, ar_alg_t alg, MPI_Comm comm) {
+   if (alg == AR_AUTO)
+      alg = (n*sizeof(int) < AR_LONG_MSG) ? AR_DOUBLING : AR_RABENSEIFNER;
+
+   switch (alg) {
+      case AR_RING:
+         Ring_allreduce(x, n, comm);
+         break;
+      case AR_DOUBLING:
+         Doubling_allreduce(x, n, comm);
+         break;
+      case AR_RABENSEIFNER:
+         Rabenseifner_allreduce(x, n, comm);
+         break;
+      default:
+         MPI_Allreduce(MPI_IN_PLACE, x, n, MPI_INT, MPI_SUM, comm);
+   }
+}  /* Allreduce_sum */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_allreduce_sum
+ * Purpose:     Node-aware version of Allreduce_sum (note 5)
+ * In args:     h:  made by Hier_create on the communicator
+ *              n, alg
+ * In/out arg:  x
+ */
+void Hier_allreduce_sum(hier_t* h, int x[], int n, ar_alg_t alg) {
+   Hier_node_reduce_int(h, x, n);
+   if (h->leaders != MPI_COMM_NULL)
+      Allreduce_sum(x, n, alg, h->leaders);
+   Hier_node_bcast(h, x, n*sizeof(int));
+}  /* Hier_allreduce_sum */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Ring_allreduce
+ * Purpose:     Global sum by passing each process's vector p-1 times
+ *              around the ring (the vector version of
+ *              Ring_pass_global_sum).  Ring_pass adds each vector in
+ *              while the next one is on its way.
+ * In args:     n, comm
+ * In/out arg:  x
+ */
+void Ring_allreduce(int x[], int n, MPI_Comm comm) {
+   int*      mine = malloc(n*sizeof(int));
+   add_arg_t arg = {x, n};
+   int       i;
+
+   for (i = 0; i < n; i++) {
+      mine[i] = x[i];
+      x[i] = 0;
+   }
+   Ring_pass(mine, n, MPI_INT, Add_block, &arg, comm);
+   free(mine);
+}  /* Ring_allreduce */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Doubling_allreduce
+ * Purpose:     Global sum by recursive doubling (note 2)
+ * In args:     n, comm
+ * In/out arg:  x
+ */
+void Doubling_allreduce(int x[], int n, MPI_Comm comm) {
+   int  p, my_rank, pof2, rem, new_rank, mask, partner;
+   int* temp;
+
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+   for (pof2 = 1; 2*pof2 <= p; pof2 *= 2)
+      ;
+   rem = p - pof2;
+
+   temp = malloc(n*sizeof(int));
+   new_rank = Fold_in(x, n, my_rank, rem, comm);
+   if (new_rank >= 0)
+      for (mask = 1; mask < pof2; mask <<= 1) {
+         partner = Real_rank(new_rank ^ mask, rem);
+         MPI_Sendrecv(x, n, MPI_INT, partner, mask, temp, n, MPI_INT,
+               partner, mask, comm, MPI_STATUS_IGNORE);
+         Add(x, temp, n);
+      }
+   Fold_out(x, n, my_rank, rem, comm);
+   free(temp);
+}  /* Doubling_allreduce */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Rabenseifner_allreduce
+ * Purpose:     Global sum by recursive halving and doubling (note 3)
+ * In args:     n, comm
+ * In/out arg:  x
+ */
+void Rabenseifner_allreduce(int x[], int n, MPI_Comm comm) {
+   int  p, my_rank, pof2, rem, new_rank, mask, partner;
+   int  lo, hi, mid, send_lo, send_hi, keep_lo, keep_hi, len;
+   int* temp;
+
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+   for (pof2 = 1; 2*pof2 <= p; pof2 *= 2)
+      ;
+   rem = p - pof2;
+
+   temp = malloc(n*sizeof(int));
+   new_rank = Fold_in(x, n, my_rank, rem, comm);
+   if (new_rank >= 0) {
+      /* Reduce-scatter:  [lo, hi) are the blocks we're still adding */
+      lo = 0;
+      hi = pof2;
+      for (mask = pof2/2; mask > 0; mask >>= 1) {
+         partner = Real_rank(new_rank ^ mask, rem);
+         mid = (lo + hi)/2;
+         if (new_rank & mask) {
+            send_lo = lo; send_hi = mid; keep_lo = mid; keep_hi = hi;
+         } else {
+            send_lo = mid; send_hi = hi; keep_lo = lo; keep_hi = mid;
+         }
+         send_lo = Block_start(send_lo, n, pof2);
+         send_hi = Block_start(send_hi, n, pof2);
+         len = Block_start(keep_hi, n, pof2) - Block_start(keep_lo, n, pof2);
+         MPI_Sendrecv(x + send_lo, send_hi - send_lo, MPI_INT, partner,
+               mask, temp, len, MPI_INT, partner, mask, comm,
+               MPI_STATUS_IGNORE);
+         Add(x + Block_start(keep_lo, n, pof2), temp, len);
+         lo = keep_lo;
+         hi = keep_hi;
+      }
+
+      /* Allgather:  now lo = new_rank, hi = lo + 1 */
+      for (mask = 1; mask < pof2; mask <<= 1) {
+         partner = Real_rank(new_rank ^ mask, rem);
+         if (new_rank & mask) {
+            keep_lo = lo - mask; keep_hi = lo;
+         } else {
+            keep_lo = hi; keep_hi = hi + mask;
+         }
+         MPI_Sendrecv(x + Block_start(lo, n, pof2),
+               Block_start(hi, n, pof2) - Block_start(lo, n, pof2),
+               MPI_INT, partner, pof2 + mask,
+               x + Block_start(keep_lo, n, pof2),
+               Block_start(keep_hi, n, pof2) - Block_start(keep_lo, n, pof2),
+               MPI_INT, partner, pof2 + mask, comm, MPI_STATUS_IGNORE);
+         if (keep_lo < lo) lo = keep_lo; else hi = keep_hi;
+      }
+   }
+   Fold_out(x, n, my_rank, rem, comm);
+   free(temp);
+}  /* Rabenseifner_allreduce */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Add
+ * Purpose:     dst += src, elementwise
+ */
+static void Add(int dst[], const int src[], int n) {
+   int i;
+
+   for (i = 0; i < n; i++)
+      dst[i] += src[i];
+}  /* Add */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Add_block
+ * Purpose:     Ring_pass work function:  add block into arg->x
+ */
+static void Add_block(const void* block, int hop, void* arg) {
+   add_arg_t* a = arg;
+
+   Add(a->x, block, a->n);
+}  /* Add_block */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Fold_in
+ * Purpose:     Reduce the extra rem processes into their neighbors
+ *              (note 1)
+ * In args:     n, my_rank, rem, comm
+ * In/out arg:  x
+ * Ret val:     This process's rank among the pof2 that are left, or
+ *              -1 if it sits out
+ */
+static int Fold_in(int x[], int n, int my_rank, int rem, MPI_Comm comm) {
+   int* temp;
+
+   if (my_rank >= 2*rem)
+      return my_rank - rem;
+   if (my_rank % 2 == 0) {
+      MPI_Send(x, n, MPI_INT, my_rank + 1, 0, comm);
+      return -1;
+   }
+   temp = malloc(n*sizeof(int));
+   MPI_Recv(temp, n, MPI_INT, my_rank - 1, 0, comm, MPI_STATUS_IGNORE);
+   Add(x, temp, n);
+   free(temp);
+   return my_rank/2;
+}  /* Fold_in */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Fold_out
+ * Purpose:     Send the result back to the processes that sat out
+ * In args:     n, my_rank, rem, comm
+ * In/out arg:  x
+ */
+static void Fold_out(int x[], int n, int my_rank, int rem, MPI_Comm comm) {
+   if (my_rank >= 2*rem)
+      return;
+   if (my_rank % 2 == 0)
+      MPI_Recv(x, n, MPI_INT, my_rank + 1, 0, comm, MPI_STATUS_IGNORE);
+   else
+      MPI_Send(x, n, MPI_INT, my_rank - 1, 0, comm);
+}  /* Fold_out */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Real_rank
+ * Purpose:     Convert a rank among the pof2 remaining processes to
+ *              its rank in comm
+ */
+static int Real_rank(int new_rank, int rem) {
+   return (new_rank < rem) ? 2*new_rank + 1 : new_rank + rem;
+}  /* Real_rank */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Block_start
+ * Purpose:     Index of the first element of block b when n elements
+ *              are split into pof2 nearly equal blocks
+ */
+static int Block_start(int b, int n, int pof2) {
+   return (int) ((long) b*n/pof2);
+}  /* Block_start */
@@ -0,0 +1,42 @@
+/* File:     allreduce.h
+ * Author:   Cayla Shaver
+ * Purpose:  Global sums of int vectors (allreduce with MPI_SUM) built
+ *           on point-to-point communication:  a ring, recursive
+ *           doubling (butterfly), and Rabenseifner's reduce-scatter +
+ *           allgather.  All of them work for any number of processes.
+ *
+ * Example:
+ *    #include "allreduce.h"
+ *    . . .
+ *    Allreduce_sum(x, n, Allreduce_alg('a'), comm);
+ *    (now x[i] is the sum of everybody's x[i] on every process)
+ *
+ *    or, on a cluster of multicore nodes (see ../hier.h),
+ *    Hier_allreduce_sum(&h, x, n, Allreduce_alg('a'));
+ */
+#ifndef _ALLREDUCE_H_
+#define _ALLREDUCE_H_
+
+#include <mpi.h>
+#include "hier.h"
+
+typedef enum {
+   AR_RING,        /* r:  pass whole vectors around a ring, p-1 steps    */
+   AR_DOUBLING,    /* d:  recursive doubling, log p steps of n ints      */
+   AR_RABENSEIFNER,/* h:  recursive halving then doubling, ~2n ints sent */
+   AR_AUTO,        /* a:  d for short vectors, h for long ones           */
+   AR_MPI          /* m:  MPI_Allreduce                                  */
+} ar_alg_t;
+
+/* Vectors of at least this many bytes use Rabenseifner under AR_AUTO */
+#define AR_LONG_MSG 8192
+
+ar_alg_t Allreduce_alg(char c);
+char     Allreduce_name(ar_alg_t alg);
+void     Allreduce_sum(int x[], int n, ar_alg_t alg, MPI_Comm comm);
+void     Hier_allreduce_sum(hier_t* h, int x[], int n, ar_alg_t alg);
+void     Ring_allreduce(int x[], int n, MPI_Comm comm);
+void     Doubling_allreduce(int x[], int n, MPI_Comm comm);
+void     Rabenseifner_allreduce(int x[], int n, MPI_Comm comm);
+
+#endif
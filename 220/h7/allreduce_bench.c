@@ -0,0 +1,162 @@
+/* File:     allreduce_bench.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ *
+ * Purpose:  Time the global sums in allreduce.c against MPI_Allreduce
+ *           for a range of vector lengths.
+ *
+ * Input:    None.
+ * Output:   One CSV line per algorithm and vector length:
+ *              alg,hier,p,n,bytes,reps,min_s,median_s,MB_per_s,correct
+ *           hier is 1 for Hier_allreduce_sum, 0 for Allreduce_sum.
+ *           MB_per_s is the vector's size over the median time.
+ *
+ * Compile:  mpicc -g -Wall -O2 -I.. -o allreduce_bench allreduce_bench.c
+ *              allreduce.c ../hier.c ../ring.c
+ * Run:      mpiexec -n <p> allreduce_bench <min n> <max n> [reps]
+ *              n runs over min n, 2*min n, 4*min n, ... <= max n ints.
+ *              reps defaults to 20.
+ *
+ * Notes:
+ *    1.  Each rep starts from a fresh copy of the vector, and its time
+ *        is the longest time taken by any process.
+ *    2.  correct is 1 if every process got the right sum in every
+ *        element on the last rep.
+ *    3.  Compare the rows for several values of p, e.g. 2, 4, 6, 8,
+ *        to see the cost of a p that isn't a power of 2.
+ *    4.  On one machine set HIER_PPN (see ../hier.h) to see what the
+ *        node-aware versions do with more than one node.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "allreduce.h"
+
+void   Usage(char* prog_name, int my_rank);
+int    Cmp_double(const void* a, const void* b);
+int    Check(const int x[], int n, int p, MPI_Comm comm);
+void   Run(ar_alg_t alg, hier_t* h, int n, int reps, int my_rank, int p,
+      MPI_Comm comm);
+
+int main(int argc, char* argv[]) {
+   int      p, my_rank;
+   MPI_Comm comm;
+   int      min_n, max_n, reps = 20, n;
+   ar_alg_t alg;
+   hier_t   h;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   if (argc != 3 && argc != 4) Usage(argv[0], my_rank);
+   min_n = strtol(argv[1], NULL, 10);
+   max_n = strtol(argv[2], NULL, 10);
+   if (argc == 4) reps = strtol(argv[3], NULL, 10);
+   if (min_n <= 0 || max_n < min_n || reps <= 0) Usage(argv[0], my_rank);
+
+   Hier_create(&h, comm);
+   if (my_rank == 0)
+      printf("alg,hier,p,n,bytes,reps,min_s,median_s,MB_per_s,correct\n");
+   for (n = min_n; n <= max_n && n > 0; n *= 2)
+      for (alg = AR_RING; alg <= AR_MPI; alg++) {
+         Run(alg, NULL, n, reps, my_rank, p, comm);
+         Run(alg, &h, n, reps, my_rank, p, comm);
+      }
+   Hier_free(&h);
+
+   MPI_Finalize();
+   return 0;
+}  /* main */
+
+
+/*---------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print a message showing how to run the program and quit
+ * In args:   prog_name, my_rank
+ */
+void Usage(char* prog_name, int my_rank) {
+   if (my_rank == 0)
+      fprintf(stderr, "usage: mpiexec -n <p> %s <min n> <max n> [reps]\n",
+            prog_name);
+   MPI_Finalize();
+   exit(0);
+}  /* Usage */
+
+
+/*---------------------------------------------------------------
+ * Function:  Run
+ * Purpose:   Time reps global sums of n ints with alg, and print the
+ *            results on process 0
+ * In args:   alg
+ *            h:  NULL for Allreduce_sum, else use Hier_allreduce_sum
+ *            n, reps, my_rank, p, comm
+ */
+void Run(ar_alg_t alg, hier_t* h, int n, int reps, int my_rank, int p,
+      MPI_Comm comm) {
+   int*    orig = malloc(n*sizeof(int));
+   int*    x = malloc(n*sizeof(int));
+   double* times = malloc(reps*sizeof(double));
+   double  start, elapsed, median;
+   int     i, r, ok, all_ok;
+
+   for (i = 0; i < n; i++)
+      orig[i] = (my_rank + i) % 7;
+
+   for (r = 0; r < reps; r++) {
+      memcpy(x, orig, n*sizeof(int));
+      MPI_Barrier(comm);
+      start = MPI_Wtime();
+      if (h == NULL)
+         Allreduce_sum(x, n, alg, comm);
+      else
+         Hier_allreduce_sum(h, x, n, alg);
+      elapsed = MPI_Wtime() - start;
+      MPI_Reduce(&elapsed, &times[r], 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+   }
+   ok = Check(x, n, p, comm);
+   MPI_Reduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, 0, comm);
+
+   if (my_rank == 0) {
+      qsort(times, reps, sizeof(double), Cmp_double);
+      median = times[reps/2];
+      printf("%c,%d,%d,%d,%lu,%d,%e,%e,%.1f,%d\n", Allreduce_name(alg),
+            h != NULL, p, n, n*sizeof(int), reps, times[0], median,
+            n*sizeof(int)/median/1.0e6, all_ok);
+   }
+
+   free(times);
+   free(x);
+   free(orig);
+}  /* Run */
+
+
+/*---------------------------------------------------------------
+ * Function:  Check
+ * Purpose:   See whether x[i] is the sum over q of (q + i) % 7
+ * In args:   x, n, p, comm
+ * Ret val:   1 if it is for every i, 0 otherwise
+ */
+int Check(const int x[], int n, int p, MPI_Comm comm) {
+   int i, q, sum;
+
+   for (i = 0; i < n; i++) {
+      for (sum = 0, q = 0; q < p; q++)
+         sum += (q + i) % 7;
+      if (x[i] != sum) return 0;
+   }
+   return 1;
+}  /* Check */
+
+
+/*---------------------------------------------------------------
+ * Function:  Cmp_double
+ * Purpose:   Compare two doubles for qsort
+ */
+int Cmp_double(const void* a, const void* b) {
+   double x = *(const double*) a, y = *(const double*) b;
+
+   return (x > y) - (x < y);
+}  /* Cmp_double */
@@ -9,16 +9,31 @@
  * Output:   Random values generated by processes and sum of random 
  *           values on each process.
  *
- * Compile:  mpicc -g -Wall -o gs global_sum_driver.c
- * Run:      mpiexec -n <number of processes> gs
+ * Compile:  mpicc -g -Wall -I.. -o gs global_sum_driver.c allreduce.c
+ *              ../hier.c ../ring.c
+ * Run:      mpiexec -n <number of processes> gs [r|d|h|a|m [f]]
+ *              r:  Ring_pass_global_sum
+ *              d:  Global_sum, recursive doubling (default)
+ *              h:  Rabenseifner's algorithm
+ *              a:  d or h, depending on the size of the vector
+ *              m:  MPI_Allreduce
+ *              f:  flat:  ignore which processes share a node
  *
  * Notes:     
  *    1.  The result returned by all the processes should be valid.
- *    2.  The Global_sum function is not implemented.
+ *    2.  The algorithms other than the ring are in allreduce.c, and
+ *        work for any number of processes.  allreduce_bench.c times
+ *        them on longer vectors.
+ *    3.  Unless f is given the sums are node-aware:  each node adds
+ *        up its processes' values in shared memory, only one leader
+ *        process per node runs the algorithm, and the leaders copy
+ *        the result back to their nodes (../hier.c).
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <mpi.h>
+#include "allreduce.h"
+#include "ring.h"
 
 const int MAX_CONTRIB = 20;
 
@@ -26,17 +41,31 @@ int Global_sum(int my_contrib, int my_rank, int p, MPI_Comm comm);
 void Print_results(char title[], int value, int my_rank, int p,
       MPI_Comm comm);
 int Ring_pass_global_sum(int my_contrib, int my_rank, int p, MPI_Comm comm);
+int Hier_global_sum(int my_contrib, ar_alg_t alg, hier_t* h);
+void Add_to_sum(const void* block, int hop, void* sum_p);
 
-int main(void) {
+int main(int argc, char* argv[]) {
    int      p, my_rank;
    MPI_Comm comm;
    int      my_contrib;
    int      sum = 0;
+   ar_alg_t alg = AR_DOUBLING;
+   int      flat;
+   hier_t   h;
 
-   MPI_Init(NULL, NULL);
+   MPI_Init(&argc, &argv);
    comm = MPI_COMM_WORLD;
    MPI_Comm_size(comm, &p);
    MPI_Comm_rank(comm, &my_rank);
+   if (argc > 1) alg = Allreduce_alg(argv[1][0]);
+   flat = (argc > 2 && argv[2][0] == 'f');
+   if ((int) alg < 0) {
+      if (my_rank == 0)
+         fprintf(stderr, "usage: mpiexec -n <p> %s [r|d|h|a|m [f]]\n",
+               argv[0]);
+      MPI_Finalize();
+      return 0;
+   }
 
    /* Generate a random int */
    srandom(my_rank);
@@ -44,7 +73,18 @@ int main(void) {
 
    Print_results("Process Values", my_contrib, my_rank, p, comm);
 
-   sum = Ring_pass_global_sum(my_contrib, my_rank, p, comm);
+   if (!flat) {
+      Hier_create(&h, comm);
+      sum = Hier_global_sum(my_contrib, alg, &h);
+      Hier_free(&h);
+   } else if (alg == AR_RING) {
+      sum = Ring_pass_global_sum(my_contrib, my_rank, p, comm);
+   } else if (alg == AR_DOUBLING) {
+      sum = Global_sum(my_contrib, my_rank, p, comm);
+   } else {
+      sum = my_contrib;
+      Allreduce_sum(&sum, 1, alg, comm);
+   }
 
    Print_results("Process Totals", sum, my_rank, p, comm);
 
@@ -89,9 +129,13 @@ void Print_results(char title[], int value, int my_rank, int p,
  * Return val:  Sum of each process's my_contrib:  valid on all
  *              processes
  *
+ * Note:        Uses recursive doubling, so it takes about log_2(p)
+ *              rounds of communication instead of the ring's p-1.
  */
 int Global_sum(int my_contrib, int my_rank, int p, MPI_Comm comm) {
    int sum = my_contrib; 
+
+   Doubling_allreduce(&sum, 1, comm);
    return sum;
 }  /* Global_sum */
 
@@ -106,18 +150,60 @@ int Global_sum(int my_contrib, int my_rank, int p, MPI_Comm comm) {
  *              p = number of processes
  *              comm = communicator
  * Return val:  sum of all ints given by each process
+ *
+ * Note:        The passing is done by Ring_pass (../ring.c), which
+ *              posts each receive along with its send.  A blocking
+ *              send followed by a receive only works while MPI
+ *              buffers the message.
  */
 int Ring_pass_global_sum(int my_contrib, int my_rank, int p, MPI_Comm comm) {
-   int sum, temp; 
-   int i;
-   int dest = (my_rank + 1) % p;
-   int source = (my_rank + p - 1) % p;
-
-   temp = sum = my_contrib;
-   for (i = 1; i < p; i ++){
-      MPI_Send(&temp, 1, MPI_INT, dest, 0, comm);
-      MPI_Recv(&temp, 1, MPI_INT, source, 0, comm, MPI_STATUS_IGNORE);
-      sum += temp;
+   int sum = 0; 
+
+   Ring_pass(&my_contrib, 1, MPI_INT, Add_to_sum, &sum, comm);
+   return sum;
+}  /* Ring_pass_global_sum */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Add_to_sum
+ * Purpose:     Ring_pass work function:  add the int in block to
+ *              *sum_p
+ */
+void Add_to_sum(const void* block, int hop, void* sum_p) {
+   *(int*) sum_p += *(const int*) block;
+}  /* Add_to_sum */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_global_sum
+ * Purpose:     Node-aware global sum:  sum on each node in shared
+ *              memory, then among the node leaders with alg, then
+ *              copy the result to the rest of each node
+ *
+ * Input args:  my_contrib = process's contribution to the global sum
+ *              alg = algorithm for the leaders
+ *              h = node and leader communicators (see ../hier.h)
+ * Return val:  Sum of each process's my_contrib:  valid on all
+ *              processes
+ *
+ * Note:        With AR_RING the leaders use Ring_pass_global_sum, so
+ *              the ring has num_nodes - 1 rounds instead of p - 1.
+ */
+int Hier_global_sum(int my_contrib, ar_alg_t alg, hier_t* h) {
+   int sum = my_contrib;
+   int leader_rank;
+
+   if (alg != AR_RING) {
+      Hier_allreduce_sum(h, &sum, 1, alg);
+      return sum;
+   }
+
+   Hier_node_reduce_int(h, &sum, 1);
+   if (h->leaders != MPI_COMM_NULL) {
+      MPI_Comm_rank(h->leaders, &leader_rank);
+      sum = Ring_pass_global_sum(sum, leader_rank, h->num_nodes,
+            h->leaders);
    }
+   Hier_node_bcast(h, &sum, sizeof(int));
    return sum;
-}  /* Ring_pass_global_sum */
\ No newline at end of file
+}  /* Hier_global_sum */
@@ -4,7 +4,8 @@
  *
  * Purpose: Use bubble sort to sort a list of ints.
  *
- * Compile: gcc -g -Wall -o serial_bubble serial_bubble.c
+ * Compile: gcc -g -Wall -I.. -o serial_bubble serial_bubble.c
+ *            serial_sorts.c
  * Usage:   serial_bubble <n> <g|i>
  *             n:   number of elements in list
  *            'g':  generate list using a random number generator
@@ -16,6 +17,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "timer.h"
+#include "serial_sorts.h"
 
 /* For random list, 0 <= keys < RMAX */
 const int RMAX = 1000000000;
@@ -25,8 +27,6 @@ void Get_args(int argc, char* argv[], int* n_p, char* g_i_p);
 void Generate_list(int a[], int n);
 void Print_list(int a[], int n, char* title);
 void Read_list(int a[], int n);
-void Bubble_sort(int a[], int n);
-void Swap(int* x_p, int* y_p);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
@@ -131,31 +131,3 @@ void Read_list(int a[], int n) {
    for (i = 0; i < n; i++)
       scanf("%d", &a[i]);
 }  /* Read_list */
-
-
-/*-----------------------------------------------------------------
- * Function:     Bubble_sort
- * Purpose:      Sort list using bubble sort
- * In args:      n
- * In/out args:  a
- */
-void Bubble_sort(int a[], int n) {
-   int list_len, i;
-
-   for (list_len = n; list_len >= 2; list_len--)
-      for (i = 0; i < list_len-1; i++)
-         if (a[i] > a[i+1]) Swap(&a[i], &a[i+1]);
-
-}  /* Bubble_sort */
-
-
-/*-----------------------------------------------------------------
- * Function:     Swap
- * Purpose:      Swap contents of x_p and y_p
- * In/out args:  x_p, y_p
- */
-void Swap(int* x_p, int* y_p) {
-   int temp = *x_p;
-   *x_p = *y_p;
-   *y_p = temp;
-}  /* Swap */
\ No newline at end of file
@@ -4,6 +4,7 @@
  *
  * Purpose: Use odd-even transposition sort to sort a list of ints.
  *
+ * Compile: gcc -g -Wall -I.. -o odd_even serial_odd_even.c serial_sorts.c
  * Usage:   odd_even <n> <g|i>
  *             n:   number of elements in list
  *            'g':  generate list using a random number generator
@@ -15,6 +16,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "timer.h"
+#include "serial_sorts.h"
 
 // const int RMAX = 1000000000;
 const int RMAX = 1000000000;
@@ -24,9 +26,6 @@ void Get_args(int argc, char* argv[], int* n_p, char* g_i_p);
 void Generate_list(int a[], int n);
 void Print_list(int a[], int n, char* title);
 void Read_list(int a[], int n);
-void Odd_even_sort(int a[], int n);
-void Odd_even_iter(int a[], int n, int phase);
-void Swap(int* x_p, int* y_p);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
@@ -131,51 +130,3 @@ void Read_list(int a[], int n) {
    for (i = 0; i < n; i++)
       scanf("%d", &a[i]);
 }  /* Read_list */
-
-
-/*-----------------------------------------------------------------
- * Function:     Odd_even_sort
- * Purpose:      Sort list using odd-even transposition sort
- * In args:      n
- * In/out args:  a
- */
-void Odd_even_sort(int a[], int n) {
-   int phase;
-
-   for (phase = 0; phase < n; phase++) {
-      Odd_even_iter(a, n, phase);
-   }
-}  /* Odd_even_sort */
-
-/*-----------------------------------------------------------------
- * Function:    Odd_even_iter
- * Purpose:     Execute one iteration of odd-even transposition sort
- * In args:     n, phase
- * In/out args: a
- */
-void Odd_even_iter(int a[], int n, int phase) {
-   int i, left, right;
-
-   if (phase % 2 == 0) {  /* Even phase:  odd subscripts look left  */
-      for (i = 1; i < n; i += 2) {
-         left = i-1;
-         if (a[left] > a[i]) Swap(&a[left],&a[i]);
-      }
-   } else {  /* Odd phase:  odd subscripts look right */
-      for (i = 1; i < n-1; i += 2) {
-         right = i+1;
-         if (a[i] > a[right]) Swap(&a[i], &a[right]);
-      }
-   }
-}  /* Odd_even_iter */
-      
-/*-----------------------------------------------------------------
- * Function:     Swap
- * Purpose:      Swap contents of x_p and y_p
- * In/out args:  x_p, y_p
- */
-void Swap(int* x_p, int* y_p) {
-   int temp = *x_p;
-   *x_p = *y_p;
-   *y_p = temp;
-}  /* Swap */
\ No newline at end of file
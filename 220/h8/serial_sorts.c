@@ -0,0 +1,76 @@
+/* File:     serial_sorts.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the serial sorts in serial_sorts.h
+ *
+ * Compile:  link with the caller, e.g.
+ *           gcc -g -Wall -I.. -o serial_bubble serial_bubble.c
+ *              serial_sorts.c
+ */
+#include "serial_sorts.h"
+
+/*-----------------------------------------------------------------
+ * Function:     Bubble_sort
+ * Purpose:      Sort list using bubble sort
+ * In args:      n
+ * In/out args:  a
+ */
+void Bubble_sort(int a[], int n) {
+   int list_len, i;
+
+   for (list_len = n; list_len >= 2; list_len--)
+      for (i = 0; i < list_len-1; i++)
+         if (a[i] > a[i+1]) Swap(&a[i], &a[i+1]);
+
+}  /* Bubble_sort */
+
+
+/*-----------------------------------------------------------------
+ * Function:     Odd_even_sort
+ * Purpose:      Sort list using odd-even transposition sort
+ * In args:      n
+ * In/out args:  a
+ */
+void Odd_even_sort(int a[], int n) {
+   int phase;
+
+   for (phase = 0; phase < n; phase++) {
+      Odd_even_iter(a, n, phase);
+   }
+}  /* Odd_even_sort */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Odd_even_iter
+ * Purpose:     Execute one iteration of odd-even transposition sort
+ * In args:     n, phase
+ * In/out args: a
+ */
+void Odd_even_iter(int a[], int n, int phase) {
+   int i, left, right;
+
+   if (phase % 2 == 0) {  /* Even phase:  odd subscripts look left  */
+      for (i = 1; i < n; i += 2) {
+         left = i-1;
+         if (a[left] > a[i]) Swap(&a[left],&a[i]);
+      }
+   } else {  /* Odd phase:  odd subscripts look right */
+      for (i = 1; i < n-1; i += 2) {
+         right = i+1;
+         if (a[i] > a[right]) Swap(&a[i], &a[right]);
+      }
+   }
+}  /* Odd_even_iter */
+
+
+/*-----------------------------------------------------------------
+ * Function:     Swap
+ * Purpose:      Swap contents of x_p and y_p
+ * In/out args:  x_p, y_p
+ */
+void Swap(int* x_p, int* y_p) {
+   int temp = *x_p;
+   *x_p = *y_p;
+   *y_p = temp;
+}  /* Swap */
@@ -0,0 +1,22 @@
+/* File:     serial_sorts.h
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to the serial bubble and odd-even transposition
+ *           sorts in serial_sorts.c, shared by serial_bubble.c,
+ *           serial_odd_even.c and p5/sort_bench.c.
+ *
+ * Example:
+ *    #include "serial_sorts.h"
+ *    . . .
+ *    Bubble_sort(a, n);
+ */
+#ifndef _SERIAL_SORTS_H_
+#define _SERIAL_SORTS_H_
+
+void Bubble_sort(int a[], int n);
+void Odd_even_sort(int a[], int n);
+void Odd_even_iter(int a[], int n, int phase);
+void Swap(int* x_p, int* y_p);
+
+#endif
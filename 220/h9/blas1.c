@@ -0,0 +1,324 @@
+/* File:     blas1.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the level 1 BLAS kernels in blas1.h on a
+ *           pool_t
+ *
+ * Compile:  link with the caller, pool.c, ../numa_rt.c, -lpthread and
+ *           -lm, e.g.
+ *           gcc -g -Wall -O3 -march=native -I.. -o daxpy daxpy.c blas1.c
+ *              pool.c ../numa_rt.c -lpthread -lm
+ *
+ * Notes:
+ *    1.  Each kernel has a serial inner loop on restrict pointers,
+ *        which gcc -O3 vectorizes for whatever -march allows.  The
+ *        loops don't assume n is a multiple of anything:  the
+ *        compiler's epilogue handles the remainder.
+ *    2.  dot and nrm2 keep ACC partial sums in separate accumulators,
+ *        so the additions can be done in SIMD registers without
+ *        -ffast-math.  The threads' partial results are padded to a
+ *        cache line each, and the caller adds them up in rank order,
+ *        so the result doesn't depend on timing.
+ *    3.  nrm2 adds up x[i]^2 directly.  If that overflows or might
+ *        have underflowed, it finds max |x[i]| and does it again with
+ *        x scaled by 1/max.
+ *    4.  Pool_block gives each thread a cache line aligned block.
+ *        With BLAS1_SERIAL_MAX elements or more every thread has at
+ *        least a few thousand.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "blas1.h"
+
+#define ACC 8
+#define CACHE_LINE 64
+
+typedef enum {AXPY, DOT, SCAL, SUMSQ, AMAX, COPY, SWAP} op_t;
+
+typedef struct {
+   double val;
+   char   pad[CACHE_LINE - sizeof(double)];
+} __attribute__((aligned(CACHE_LINE))) partial_t;
+
+typedef struct {
+   op_t       op;
+   long       n;
+   double     alpha;
+   double*    x;
+   double*    y;
+   partial_t* partials;
+} blas_job_t;
+
+static void   Axpy_kernel(long n, double alpha, const double* restrict x,
+                 double* restrict y);
+static double Dot_kernel(long n, const double* restrict x,
+                 const double* restrict y);
+static void   Scal_kernel(long n, double alpha, double* restrict x);
+static double Sumsq_kernel(long n, double scale, const double* restrict x);
+static double Amax_kernel(long n, const double* restrict x);
+static void   Swap_kernel(long n, double* restrict x, double* restrict y);
+static double Run_op(pool_t* pool, op_t op, long n, double alpha, double* x,
+                 double* y);
+static void   Blas_work(int rank, int thread_count, void* arg);
+static double Combine(op_t op, double a, double b);
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_axpy
+ * Purpose:     y = alpha*x + y
+ */
+void Blas_axpy(pool_t* pool, long n, double alpha, const double* x,
+      double* y) {
+   Run_op(pool, AXPY, n, alpha, (double*) x, y);
+}  /* Blas_axpy */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_dot
+ * Purpose:     Return x . y
+ */
+double Blas_dot(pool_t* pool, long n, const double* x, const double* y) {
+   return Run_op(pool, DOT, n, 0.0, (double*) x, (double*) y);
+}  /* Blas_dot */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_scal
+ * Purpose:     x = alpha*x
+ */
+void Blas_scal(pool_t* pool, long n, double alpha, double* x) {
+   Run_op(pool, SCAL, n, alpha, x, NULL);
+}  /* Blas_scal */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_nrm2
+ * Purpose:     Return the 2-norm of x (note 3)
+ */
+double Blas_nrm2(pool_t* pool, long n, const double* x) {
+   double ss, amax;
+
+   ss = Run_op(pool, SUMSQ, n, 1.0, (double*) x, NULL);
+   if (isfinite(ss) && ss > DBL_MIN/DBL_EPSILON)
+      return sqrt(ss);
+
+   amax = Run_op(pool, AMAX, n, 0.0, (double*) x, NULL);
+   if (amax == 0.0 || !isfinite(amax))
+      return amax;
+   ss = Run_op(pool, SUMSQ, n, 1.0/amax, (double*) x, NULL);
+   return amax*sqrt(ss);
+}  /* Blas_nrm2 */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_copy
+ * Purpose:     y = x
+ */
+void Blas_copy(pool_t* pool, long n, const double* x, double* y) {
+   Run_op(pool, COPY, n, 0.0, (double*) x, y);
+}  /* Blas_copy */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_swap
+ * Purpose:     Exchange x and y
+ */
+void Blas_swap(pool_t* pool, long n, double* x, double* y) {
+   Run_op(pool, SWAP, n, 0.0, x, y);
+}  /* Blas_swap */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Run_op
+ * Purpose:     Do op on [0, n), serially if n is small or there's no
+ *              pool, otherwise on the pool
+ * Ret val:     For DOT, SUMSQ and AMAX the reduced value, else 0
+ */
+static double Run_op(pool_t* pool, op_t op, long n, double alpha, double* x,
+      double* y) {
+   int        threads, rank;
+   double     result;
+   blas_job_t job = {op, n, alpha, x, y, NULL};
+   partial_t  one;
+
+   if (pool == NULL || pool->thread_count == 1 || n < BLAS1_SERIAL_MAX) {
+      job.partials = &one;
+      Blas_work(0, 1, &job);
+      return one.val;
+   }
+
+   threads = pool->thread_count;
+   {
+      partial_t partials[threads];
+
+      job.partials = partials;
+      Pool_run(pool, Blas_work, &job);
+      result = partials[0].val;
+      for (rank = 1; rank < threads; rank++)
+         result = Combine(op, result, partials[rank].val);
+   }
+   return result;
+}  /* Run_op */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Combine
+ * Purpose:     Combine two partial results of op
+ */
+static double Combine(op_t op, double a, double b) {
+   if (op == AMAX) return (a > b) ? a : b;
+   return a + b;
+}  /* Combine */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_work
+ * Purpose:     Pool job:  do the job's op on this thread's block
+ * In args:     rank, thread_count, arg:  a blas_job_t
+ * Out arg:     arg->partials[rank]
+ */
+static void Blas_work(int rank, int thread_count, void* arg) {
+   blas_job_t* job = arg;
+   long        first, last, len;
+   double      val = 0.0;
+
+   Pool_block(rank, thread_count, job->n, &first, &last);
+   len = last - first;
+   switch (job->op) {
+      case AXPY:
+         Axpy_kernel(len, job->alpha, job->x + first, job->y + first);
+         break;
+      case DOT:
+         val = Dot_kernel(len, job->x + first, job->y + first);
+         break;
+      case SCAL:
+         Scal_kernel(len, job->alpha, job->x + first);
+         break;
+      case SUMSQ:
+         val = Sumsq_kernel(len, job->alpha, job->x + first);
+         break;
+      case AMAX:
+         val = Amax_kernel(len, job->x + first);
+         break;
+      case COPY:
+         memcpy(job->y + first, job->x + first, len*sizeof(double));
+         break;
+      case SWAP:
+         Swap_kernel(len, job->x + first, job->y + first);
+         break;
+   }
+   job->partials[rank].val = val;
+}  /* Blas_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Axpy_kernel
+ * Purpose:     y = alpha*x + y, serially
+ */
+static void Axpy_kernel(long n, double alpha, const double* restrict x,
+      double* restrict y) {
+   long i;
+
+   for (i = 0; i < n; i++)
+      y[i] += alpha*x[i];
+}  /* Axpy_kernel */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Dot_kernel
+ * Purpose:     Return x . y, serially (note 2)
+ */
+static double Dot_kernel(long n, const double* restrict x,
+      const double* restrict y) {
+   double acc[ACC] = {0.0};
+   double sum = 0.0;
+   long   i;
+   int    j;
+
+   for (i = 0; i + ACC <= n; i += ACC)
+      for (j = 0; j < ACC; j++)
+         acc[j] += x[i+j]*y[i+j];
+   for (; i < n; i++)
+      sum += x[i]*y[i];
+   for (j = 0; j < ACC; j++)
+      sum += acc[j];
+   return sum;
+}  /* Dot_kernel */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Scal_kernel
+ * Purpose:     x = alpha*x, serially
+ */
+static void Scal_kernel(long n, double alpha, double* restrict x) {
+   long i;
+
+   for (i = 0; i < n; i++)
+      x[i] *= alpha;
+}  /* Scal_kernel */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Sumsq_kernel
+ * Purpose:     Return the sum of (scale*x[i])^2, serially
+ */
+static double Sumsq_kernel(long n, double scale, const double* restrict x) {
+   double acc[ACC] = {0.0};
+   double sum = 0.0, t;
+   long   i;
+   int    j;
+
+   for (i = 0; i + ACC <= n; i += ACC)
+      for (j = 0; j < ACC; j++) {
+         t = scale*x[i+j];
+         acc[j] += t*t;
+      }
+   for (; i < n; i++) {
+      t = scale*x[i];
+      sum += t*t;
+   }
+   for (j = 0; j < ACC; j++)
+      sum += acc[j];
+   return sum;
+}  /* Sumsq_kernel */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Amax_kernel
+ * Purpose:     Return max |x[i]|, serially
+ */
+static double Amax_kernel(long n, const double* restrict x) {
+   double acc[ACC] = {0.0};
+   double max = 0.0, t;
+   long   i;
+   int    j;
+
+   for (i = 0; i + ACC <= n; i += ACC)
+      for (j = 0; j < ACC; j++) {
+         t = fabs(x[i+j]);
+         acc[j] = (t > acc[j]) ? t : acc[j];
+      }
+   for (; i < n; i++)
+      if (fabs(x[i]) > max) max = fabs(x[i]);
+   for (j = 0; j < ACC; j++)
+      if (acc[j] > max) max = acc[j];
+   return max;
+}  /* Amax_kernel */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Swap_kernel
+ * Purpose:     Exchange x and y, serially
+ */
+static void Swap_kernel(long n, double* restrict x, double* restrict y) {
+   double t;
+   long   i;
+
+   for (i = 0; i < n; i++) {
+      t = x[i];
+      x[i] = y[i];
+      y[i] = t;
+   }
+}  /* Swap_kernel */
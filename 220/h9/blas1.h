@@ -0,0 +1,36 @@
+/* File:     blas1.h
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to threaded level 1 BLAS kernels on doubles.
+ *           Vectors are contiguous (unit stride).  pool can be NULL,
+ *           and vectors shorter than BLAS1_SERIAL_MAX are done by the
+ *           caller alone.
+ *
+ * Example:
+ *    #include "pool.h"
+ *    #include "blas1.h"
+ *    . . .
+ *    pool_t* pool = Pool_create(thread_count, 1);
+ *    Blas_axpy(pool, n, alpha, x, y);          (y = alpha*x + y)
+ *    dot = Blas_dot(pool, n, x, y);
+ *    . . .
+ *    Pool_destroy(pool);
+ */
+#ifndef _BLAS1_H_
+#define _BLAS1_H_
+
+#include "pool.h"
+
+/* Shorter vectors aren't worth waking the pool for */
+#define BLAS1_SERIAL_MAX 32768
+
+void   Blas_axpy(pool_t* pool, long n, double alpha, const double* x,
+          double* y);
+double Blas_dot(pool_t* pool, long n, const double* x, const double* y);
+void   Blas_scal(pool_t* pool, long n, double alpha, double* x);
+double Blas_nrm2(pool_t* pool, long n, const double* x);
+void   Blas_copy(pool_t* pool, long n, const double* x, double* y);
+void   Blas_swap(pool_t* pool, long n, double* x, double* y);
+
+#endif
@@ -0,0 +1,206 @@
+/* File:     blas1_bench.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Time the level 1 BLAS kernels in blas1.c and compare
+ *           their memory bandwidth with the STREAM triad
+ *           a[i] = b[i] + s*c[i] run on the same pool.
+ *
+ * Compile:  gcc -g -Wall -O3 -march=native -I.. -o blas1_bench
+ *              blas1_bench.c blas1.c pool.c ../numa_rt.c -lpthread -lm
+ * Usage:    blas1_bench <thread_count> <n> [reps]
+ *              n:  vector length.  Use something much bigger than the
+ *                  last level cache, e.g. 20000000.
+ *              reps:  times each kernel is run (default 10)
+ *
+ * Input:    None
+ * Output:   For each kernel its fastest time, the bytes it has to
+ *           move divided by that time in GB/s, the same as a
+ *           percentage of the triad's GB/s, and a check:  dot and nrm2
+ *           against the serial kernels (pool = NULL), copy and swap
+ *           against the values they should leave.
+ *
+ * Notes:
+ *    1.  Bytes moved per element:  triad and axpy 24 (two reads, one
+ *        write), dot 16, scal 16, nrm2 8, copy 16, swap 32.  Write
+ *        allocate traffic isn't counted, as in STREAM.
+ *    2.  The vectors are initialized by a pool job, so each thread's
+ *        block is first touched by the thread that uses it.  The
+ *        pages of a, b and c that are local and remote to the threads
+ *        that use them go to stderr, so a bad NUMA_CPUS map (see
+ *        ../numa_rt.h) shows up before the times do.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "timer.h"
+#include "pool.h"
+#include "blas1.h"
+
+typedef struct {
+   long    n;
+   double* a;
+   double* b;
+   double* c;
+   double  s;
+} triad_t;
+
+void    Usage(char* prog_name);
+double* Alloc_vec(long n);
+void    Init_work(int rank, int thread_count, void* arg);
+void    Triad_work(int rank, int thread_count, void* arg);
+void    Report(const char* name, double secs, double bytes, double triad,
+           int ok);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int     thread_count, reps = 10, r, ok;
+   long    n;
+   pool_t* pool;
+   triad_t t;
+   numa_counts_t counts = {0, 0, 0};
+   double  start, finish, best[7], triad_gbs, d, d_serial, nrm, nrm_serial;
+   double  per_elt[7] = {24, 24, 16, 16, 8, 16, 32};
+   const char* names[7] = {"triad", "axpy", "dot", "scal", "nrm2", "copy",
+         "swap"};
+   int     k;
+
+   if (argc != 3 && argc != 4) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   n = strtol(argv[2], NULL, 10);
+   if (argc == 4) reps = strtol(argv[3], NULL, 10);
+   if (thread_count <= 0 || n <= 0 || reps <= 0) Usage(argv[0]);
+
+   pool = Pool_create(thread_count, 1);
+   t.n = n;
+   t.a = Alloc_vec(n);
+   t.b = Alloc_vec(n);
+   t.c = Alloc_vec(n);
+   t.s = 3.0;
+   Pool_run(pool, Init_work, &t);
+   Pool_placement(pool, t.a, n, sizeof(double), &counts);
+   Pool_placement(pool, t.b, n, sizeof(double), &counts);
+   Pool_placement(pool, t.c, n, sizeof(double), &counts);
+   Numa_print("a, b and c", &counts);
+
+   for (k = 0; k < 7; k++) best[k] = 1e30;
+   for (r = 0; r < reps; r++) {
+      for (k = 0; k < 7; k++) {
+         GET_TIME(start);
+         switch (k) {
+            case 0: Pool_run(pool, Triad_work, &t);               break;
+            case 1: Blas_axpy(pool, n, 0.5, t.b, t.a);            break;
+            case 2: d = Blas_dot(pool, n, t.a, t.b);              break;
+            case 3: Blas_scal(pool, n, 0.5, t.a);                 break;
+            case 4: nrm = Blas_nrm2(pool, n, t.b);                break;
+            case 5: Blas_copy(pool, n, t.b, t.a);                 break;
+            case 6: Blas_swap(pool, n, t.a, t.c);                 break;
+         }
+         GET_TIME(finish);
+         if (finish - start < best[k]) best[k] = finish - start;
+      }
+   }
+
+   /* Each rep ends with a = c = b, since the copy sets a = b and the
+    * swap trades it with c, which started out equal to b */
+   d = Blas_dot(pool, n, t.a, t.b);
+   d_serial = Blas_dot(NULL, n, t.a, t.b);
+   nrm = Blas_nrm2(pool, n, t.b);
+   nrm_serial = Blas_nrm2(NULL, n, t.b);
+
+   triad_gbs = per_elt[0]*n/best[0]/1e9;
+   printf("%d threads, n = %ld, best of %d\n", thread_count, n, reps);
+   printf("%-6s %12s %9s %9s %s\n", "kernel", "seconds", "GB/s",
+         "% triad", "check");
+   for (k = 0; k < 7; k++) {
+      ok = -1;
+      if (k == 2) ok = fabs(d - d_serial) <= 1e-12*fabs(d_serial);
+      if (k == 4) ok = fabs(nrm - nrm_serial) <= 1e-12*nrm_serial;
+      if (k == 5 || k == 6)
+         ok = (t.a[n/2] == (n/2) % 5) && (t.c[n-1] == (n-1) % 5);
+      Report(names[k], best[k], per_elt[k]*n, triad_gbs, ok);
+   }
+
+   free(t.a);
+   free(t.b);
+   free(t.c);
+   Pool_destroy(pool);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   print a message showing what the command line should
+ *            be, and terminate
+ * In arg :   prog_name
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> <n> [reps]\n", prog_name);
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Alloc_vec
+ * Purpose:   Allocate a cache line aligned vector of n doubles
+ */
+double* Alloc_vec(long n) {
+   double* v;
+
+   if (posix_memalign((void**) &v, 64, n*sizeof(double)) != 0) {
+      fprintf(stderr, "Can't allocate %ld doubles\n", n);
+      exit(1);
+   }
+   return v;
+}  /* Alloc_vec */
+
+
+/*------------------------------------------------------------------
+ * Function:  Init_work
+ * Purpose:   Pool job:  a[i] = i % 7, b[i] = c[i] = i % 5 on this
+ *            thread's block (note 2)
+ */
+void Init_work(int rank, int thread_count, void* arg) {
+   triad_t* t = arg;
+   long     i, first, last;
+
+   Pool_block(rank, thread_count, t->n, &first, &last);
+   for (i = first; i < last; i++) {
+      t->a[i] = i % 7;
+      t->b[i] = t->c[i] = i % 5;
+   }
+}  /* Init_work */
+
+
+/*------------------------------------------------------------------
+ * Function:  Triad_work
+ * Purpose:   Pool job:  STREAM triad on this thread's block
+ */
+void Triad_work(int rank, int thread_count, void* arg) {
+   triad_t*         t = arg;
+   double* restrict a = t->a;
+   const double* restrict b = t->b;
+   const double* restrict c = t->c;
+   double           s = t->s;
+   long             i, first, last;
+
+   Pool_block(rank, thread_count, t->n, &first, &last);
+   for (i = first; i < last; i++)
+      a[i] = b[i] + s*c[i];
+}  /* Triad_work */
+
+
+/*------------------------------------------------------------------
+ * Function:  Report
+ * Purpose:   Print one line of the table
+ * In args:   ok:  1 if the check passed, 0 if it failed, -1 if there
+ *               isn't one
+ */
+void Report(const char* name, double secs, double bytes, double triad,
+      int ok) {
+   double gbs = bytes/secs/1e9;
+
+   printf("%-6s %12e %9.2f %9.1f %s\n", name, secs, gbs, 100*gbs/triad,
+         ok < 0 ? "-" : ok ? "ok" : "WRONG");
+}  /* Report */
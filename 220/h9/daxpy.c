@@ -1,88 +1,86 @@
 /* File:     
- *     pth_mat_vect.c 
+ *     daxpy.c 
  *
  * Author: Cayla Shaver
  * Section: 2
  * Purpose:  
- *     Computes a parallel matrix-vector product.  Matrix
- *     is distributed by block rows.  Vectors are distributed by 
- *     blocks.
+ *     Computes y = alpha*x + y with the threaded level 1 BLAS in
+ *     blas1.c.
  *
  * Input:
- *     m, n: order of matrix
- *     A, x: the matrix and the vector to be multiplied
+ *     n, alpha:  length of the vectors and the scalar
+ *     x, y: the vectors
  *
  * Output:
- *     y: the product vector
+ *     y: alpha*x + y
  *
- * Compile:  gcc -g -Wall -o pth_mat_vect pth_mat_vect.c -lpthread
+ * Compile:  gcc -g -Wall -O3 -march=native -I.. -o daxpy daxpy.c blas1.c
+ *              pool.c ../numa_rt.c -lpthread -lm
  * Usage:
- *     pth_mat_vect <thread_count>
+ *     daxpy <thread_count>
  *
  * Notes:  
- *     1.  Local storage for A, x, y is dynamically allocated.
- *     2.  Number of threads (thread_count) should evenly divide both 
- *         m and n.  The program doesn't check for this.
- *     3.  We use a 1-dimensional array for A and compute subscripts
- *         using the formula A[i][j] = A[i*n + j]
- *     4.  Distribution of A, x, and y is logical:  all three are 
- *         globally shared.
+ *     1.  n doesn't have to be divisible by thread_count.
+ *     2.  The threads come from a pool_t (pool.c) that's created once
+ *         and can run any number of kernels.  Vectors shorter than
+ *         BLAS1_SERIAL_MAX are done by the main thread alone.
+ *     3.  blas1_bench.c times all the kernels on long vectors.
+ *     4.  x and y are first touched by the pool right after the
+ *         malloc, so each thread's block is on its own node when the
+ *         main thread reads the input into it.  Set NUMA_CPUS to
+ *         choose the cores (see ../numa_rt.h).  The number of pages
+ *         of x and y that are local and remote to the threads that
+ *         use them goes to stderr.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
+#include "pool.h"
+#include "blas1.h"
 
-/* Global variables */
-int     thread_count;
-int     n;
-double  alpha;
-double* x;
-double* y;
-
-/* Serial functions */
 void Usage(char* prog_name);
 void Read_array(char* prompt, double x[], int n);
 void Print_array(char* title, double y[], int n);
 
-/* Parallel function */
-void *Pth_array(void* rank);
-
 /*------------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
-   long       thread;
-   pthread_t* thread_handles;
+   int     thread_count, n;
+   double  alpha;
+   double* x;
+   double* y;
+   pool_t* pool;
+   numa_counts_t counts = {0, 0, 0};
 
    if (argc != 2) Usage(argv[0]);
    thread_count = strtol(argv[1], NULL, 10);
-   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   if (thread_count <= 0) Usage(argv[0]);
+   pool = Pool_create(thread_count, 1);
 
    printf("Enter n and alpha\n");
    scanf("%d%lf", &n, &alpha);
 
-   
    x = malloc(n*sizeof(double));
    y = malloc(n*sizeof(double));
-   
+   Pool_first_touch(pool, x, n, sizeof(double));
+   Pool_first_touch(pool, y, n, sizeof(double));
+
    Read_array("Enter array for x", x, n);
    Print_array("We read", x, n);
 
    Read_array("Enter array for y", y, n);
    Print_array("We read", y, n);
 
-   for (thread = 0; thread < thread_count; thread++)
-      pthread_create(&thread_handles[thread], NULL,
-         Pth_array, (void*) thread);
-
-   for (thread = 0; thread < thread_count; thread++)
-      pthread_join(thread_handles[thread], NULL);
+   Blas_axpy(pool, n, alpha, x, y);
 
    Print_array("The product is", y, n);
 
-   
+   Pool_placement(pool, x, n, sizeof(double), &counts);
+   Pool_placement(pool, y, n, sizeof(double), &counts);
+   Numa_print("x and y", &counts);
+
    free(x);
    free(y);
-   free(thread_handles);
+   Pool_destroy(pool);
 
    return 0;
 }  /* main */
@@ -114,28 +112,6 @@ void Read_array(char* prompt, double x[], int n) {
 }  /* Read_array */
 
 
-/*------------------------------------------------------------------
- * Function:       Pth_array
- * Purpose:        Multiply an mxn matrix by an nx1 column vector
- * In arg:         rank
- * Global in vars: A, x, y, n, thread_count
- * Global out var: y
- */
-void *Pth_array(void* rank) {
-   long my_rank = (long) rank;
-   int i;
-   int local_n = n/thread_count; 
-   int my_first_row = my_rank*local_n;
-   int my_last_row = my_first_row + local_n - 1;
-
-   for (i = my_first_row; i <= my_last_row; i++) {          
-      y[i] += alpha*x[i];
-   }
-
-   return NULL;
-}  /* Pth_array */
-
-
 /*------------------------------------------------------------------
  * Function:    Print_array
  * Purpose:     Print a vector
@@ -0,0 +1,323 @@
+/* File:     gemm.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the matrix-vector and matrix-matrix multiplies
+ *           in gemm.h on a pool_t
+ *
+ * Compile:  link with the caller, pool.c, ../numa_rt.c and -lpthread,
+ *           e.g.
+ *           gcc -g -Wall -O3 -march=native -I.. -o gemm_bench
+ *              gemm_bench.c gemm.c pool.c ../numa_rt.c -lpthread -lm
+ *
+ * Notes:
+ *    1.  gemv:  each thread gets a block of rows of A and y (as in
+ *        pth_mat_vect), and does GEMV_ROWS rows at a time so that
+ *        each x[j] it loads is used GEMV_ROWS times.
+ *    2.  gemm follows the usual Goto/BLIS loop nest.  For each KC x NC
+ *        panel of B, copy it into NR column wide slivers ("packing"),
+ *        and for each MC x KC panel of A, copy it into MR row slivers.
+ *        Then the micro-kernel multiplies an A sliver by a B sliver
+ *        into an MR x NR block of C held in registers.  The packed
+ *        slivers are contiguous and read in order, so the inner loop
+ *        streams through L1 with no TLB misses or cache conflicts.
+ *    3.  Packing pads the slivers at the edges of the matrices with
+ *        zeros, so the micro-kernel always does a full MR x NR block.
+ *        A full block is added straight into C with vector loads and
+ *        stores (C's rows needn't be aligned).  At the edges it's
+ *        stored to a scratch block and only the part inside C is
+ *        added.
+ *    4.  The micro-kernel uses gcc's vector extensions:  each row of
+ *        the MR x NR block is NR/4 vectors of 4 doubles, so with
+ *        -march=native on AVX2 it's 12 ymm accumulators and each step
+ *        is 2 loads of B, MR broadcasts of A and 12 fused
+ *        multiply-adds:  enough independent FMAs to cover their
+ *        latency on two FMA units.  Without AVX the compiler splits
+ *        the vectors up.
+ *    5.  Threads:  C is split into blocks of columns (or of rows, if
+ *        it's taller than it is wide), one per thread, and each thread
+ *        packs its own panels.  So there's no synchronization inside
+ *        the multiply, at the cost of each thread packing the parts
+ *        of A (or B) that it shares with the others.
+ *    6.  Each thread's packing buffers come from Pool_scratch, so
+ *        they're allocated and faulted in on the first call and
+ *        reused by every gemm after that on the same pool.  With no
+ *        pool they're allocated for each call.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gemm.h"
+
+#define GEMV_ROWS 4
+#define MR GEMM_MR
+#define NR GEMM_NR
+#define MC GEMM_MC
+#define KC GEMM_KC
+#define NC GEMM_NC
+
+typedef double v4d __attribute__((vector_size(32)));
+typedef double v4d_u __attribute__((vector_size(32), aligned(8)));
+
+typedef struct {
+   long          m, n, k;
+   double        alpha, beta;
+   const double* A;
+   long          lda;
+   const double* B;     /* gemm:  B.  gemv:  x */
+   long          ldb;
+   double*       C;     /* gemm:  C.  gemv:  y */
+   long          ldc;
+   pool_t*       pool;  /* gemm:  for Pool_scratch, or NULL */
+} mult_t;
+
+static void Gemv_work(int rank, int thread_count, void* arg);
+static void Gemm_work(int rank, int thread_count, void* arg);
+static void Gemm_block(const mult_t* t, long i0, long i1, long j0, long j1,
+               double* Ap, double* Bp);
+static void Pack_A(long mc, long kc, const double* A, long lda, double* Ap);
+static void Pack_B(long kc, long nc, const double* B, long ldb, double* Bp);
+static void Micro_kernel(long kc, const double* restrict Ap,
+               const double* restrict Bp, double alpha, double* C, long ldc,
+               long mr, long nr);
+static void* Alloc_pack(long doubles);
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_gemv
+ * Purpose:     y = alpha*A*x + beta*y, A m x n (note 1)
+ */
+void Blas_gemv(pool_t* pool, long m, long n, double alpha, const double* A,
+      long lda, const double* x, double beta, double* y) {
+   mult_t t = {m, n, 0, alpha, beta, A, lda, x, 0, y, 0, NULL};
+
+   if (pool == NULL)
+      Gemv_work(0, 1, &t);
+   else
+      Pool_run(pool, Gemv_work, &t);
+}  /* Blas_gemv */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Gemv_work
+ * Purpose:     Pool job:  this thread's block of rows of gemv
+ */
+static void Gemv_work(int rank, int thread_count, void* arg) {
+   const mult_t* t = arg;
+   const double* restrict x = t->B;
+   double*       y = t->C;
+   const double* a[GEMV_ROWS];
+   double        sum[GEMV_ROWS];
+   long          first, last, i, j;
+   int           r;
+
+   Pool_block(rank, thread_count, t->m, &first, &last);
+   for (i = first; i + GEMV_ROWS <= last; i += GEMV_ROWS) {
+      for (r = 0; r < GEMV_ROWS; r++) {
+         a[r] = t->A + (i + r)*t->lda;
+         sum[r] = 0.0;
+      }
+      for (j = 0; j < t->n; j++)
+         for (r = 0; r < GEMV_ROWS; r++)
+            sum[r] += a[r][j]*x[j];
+      for (r = 0; r < GEMV_ROWS; r++)
+         y[i+r] = t->alpha*sum[r] + (t->beta == 0.0 ? 0.0 : t->beta*y[i+r]);
+   }
+   for (; i < last; i++) {
+      a[0] = t->A + i*t->lda;
+      sum[0] = 0.0;
+      for (j = 0; j < t->n; j++)
+         sum[0] += a[0][j]*x[j];
+      y[i] = t->alpha*sum[0] + (t->beta == 0.0 ? 0.0 : t->beta*y[i]);
+   }
+}  /* Gemv_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Blas_gemm
+ * Purpose:     C = alpha*A*B + beta*C, A m x k, B k x n (notes 2-6)
+ */
+void Blas_gemm(pool_t* pool, long m, long n, long k, double alpha,
+      const double* A, long lda, const double* B, long ldb, double beta,
+      double* C, long ldc) {
+   mult_t t = {m, n, k, alpha, beta, A, lda, B, ldb, C, ldc, pool};
+
+   if (pool == NULL)
+      Gemm_work(0, 1, &t);
+   else
+      Pool_run(pool, Gemm_work, &t);
+}  /* Blas_gemm */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Gemm_work
+ * Purpose:     Pool job:  this thread's block of C (notes 5 and 6)
+ */
+static void Gemm_work(int rank, int thread_count, void* arg) {
+   const mult_t* t = arg;
+   long          first, last, i, j;
+   size_t        bytes = ((long) MC*KC + (long) KC*NC)*sizeof(double);
+   double*       Ap;
+   double*       Bp;
+
+   if (t->pool != NULL)
+      Ap = Pool_scratch(t->pool, rank, bytes);
+   else
+      Ap = Alloc_pack((long) MC*KC + (long) KC*NC);
+   Bp = Ap + (long) MC*KC;
+
+   if (t->n >= t->m) {
+      Pool_block(rank, thread_count, t->n, &first, &last);
+      if (first < last) Gemm_block(t, 0, t->m, first, last, Ap, Bp);
+   } else {
+      Pool_block(rank, thread_count, t->m, &first, &last);
+      if (first < last) Gemm_block(t, first, last, 0, t->n, Ap, Bp);
+   }
+
+   /* Nothing to multiply:  just scale */
+   if (t->k == 0 && t->beta != 1.0 && rank == 0)
+      for (i = 0; i < t->m; i++)
+         for (j = 0; j < t->n; j++)
+            t->C[i*t->ldc + j] = (t->beta == 0.0) ? 0.0
+               : t->beta*t->C[i*t->ldc + j];
+
+   if (t->pool == NULL) free(Ap);
+}  /* Gemm_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Gemm_block
+ * Purpose:     C[i0:i1, j0:j1] = alpha*A[i0:i1, :]*B[:, j0:j1]
+ *                 + beta*C[i0:i1, j0:j1]
+ * In args:     t, i0, i1, j0, j1
+ * Scratch:     Ap (MC*KC doubles), Bp (KC*NC doubles)
+ */
+static void Gemm_block(const mult_t* t, long i0, long i1, long j0, long j1,
+      double* Ap, double* Bp) {
+   long    jc, pc, ic, jr, ir, nc, kc, mc, i, j;
+   double* C;
+
+   if (t->k == 0) return;
+   if (t->beta != 1.0)
+      for (i = i0; i < i1; i++)
+         for (j = j0; j < j1; j++)
+            t->C[i*t->ldc + j] = (t->beta == 0.0) ? 0.0
+               : t->beta*t->C[i*t->ldc + j];
+
+   for (jc = j0; jc < j1; jc += NC) {
+      nc = (j1 - jc < NC) ? j1 - jc : NC;
+      for (pc = 0; pc < t->k; pc += KC) {
+         kc = (t->k - pc < KC) ? t->k - pc : KC;
+         Pack_B(kc, nc, t->B + pc*t->ldb + jc, t->ldb, Bp);
+         for (ic = i0; ic < i1; ic += MC) {
+            mc = (i1 - ic < MC) ? i1 - ic : MC;
+            Pack_A(mc, kc, t->A + ic*t->lda + pc, t->lda, Ap);
+            for (jr = 0; jr < nc; jr += NR)
+               for (ir = 0; ir < mc; ir += MR) {
+                  C = t->C + (ic + ir)*t->ldc + jc + jr;
+                  Micro_kernel(kc, Ap + ir*kc, Bp + jr*kc, t->alpha, C,
+                        t->ldc, (mc - ir < MR) ? mc - ir : MR,
+                        (nc - jr < NR) ? nc - jr : NR);
+               }
+         }
+      }
+   }
+}  /* Gemm_block */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pack_A
+ * Purpose:     Copy the mc x kc block A into MR row slivers:
+ *              element (i, p) of sliver s goes to
+ *              Ap[s*MR*kc + p*MR + i].  Rows past mc are 0.
+ */
+static void Pack_A(long mc, long kc, const double* A, long lda, double* Ap) {
+   long s, p, i;
+
+   for (s = 0; s < mc; s += MR)
+      for (p = 0; p < kc; p++)
+         for (i = 0; i < MR; i++)
+            *Ap++ = (s + i < mc) ? A[(s + i)*lda + p] : 0.0;
+}  /* Pack_A */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pack_B
+ * Purpose:     Copy the kc x nc block B into NR column slivers:
+ *              element (p, j) of sliver s goes to
+ *              Bp[s*NR*kc + p*NR + j].  Columns past nc are 0.
+ */
+static void Pack_B(long kc, long nc, const double* B, long ldb, double* Bp) {
+   long s, p, j;
+
+   for (s = 0; s < nc; s += NR)
+      for (p = 0; p < kc; p++) {
+         if (s + NR <= nc) {
+            memcpy(Bp, B + p*ldb + s, NR*sizeof(double));
+            Bp += NR;
+         } else {
+            for (j = 0; j < NR; j++)
+               *Bp++ = (s + j < nc) ? B[p*ldb + s + j] : 0.0;
+         }
+      }
+}  /* Pack_B */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Micro_kernel
+ * Purpose:     C[0:mr, 0:nr] += alpha * (A sliver)(B sliver) (notes
+ *              3 and 4)
+ * In args:     kc, Ap, Bp, alpha, ldc, mr, nr
+ * In/out arg:  C
+ */
+static void Micro_kernel(long kc, const double* restrict Ap,
+      const double* restrict Bp, double alpha, double* C, long ldc,
+      long mr, long nr) {
+   v4d    c[MR][NR/4];
+   v4d    a, b[NR/4];
+   double tile[MR*NR] __attribute__((aligned(32)));
+   long   p;
+   int    i, j;
+
+   for (i = 0; i < MR; i++)
+      for (j = 0; j < NR/4; j++)
+         c[i][j] = (v4d) {0.0, 0.0, 0.0, 0.0};
+
+   for (p = 0; p < kc; p++) {
+      for (j = 0; j < NR/4; j++)
+         b[j] = *(const v4d*) (Bp + p*NR + 4*j);
+      for (i = 0; i < MR; i++) {
+         a = (v4d) {0.0, 0.0, 0.0, 0.0} + Ap[p*MR + i];
+         for (j = 0; j < NR/4; j++)
+            c[i][j] += a*b[j];
+      }
+   }
+
+   if (mr == MR && nr == NR) {
+      for (i = 0; i < MR; i++)
+         for (j = 0; j < NR/4; j++)
+            *(v4d_u*) (C + i*ldc + 4*j) += alpha*c[i][j];
+      return;
+   }
+
+   for (i = 0; i < MR; i++)
+      for (j = 0; j < NR/4; j++)
+         *(v4d*) (tile + i*NR + 4*j) = c[i][j];
+   for (i = 0; i < mr; i++)
+      for (j = 0; j < nr; j++)
+         C[i*ldc + j] += alpha*tile[i*NR + j];
+}  /* Micro_kernel */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Alloc_pack
+ * Purpose:     Allocate a 64 byte aligned buffer of doubles
+ */
+static void* Alloc_pack(long doubles) {
+   void* p;
+
+   if (posix_memalign(&p, 64, doubles*sizeof(double)) != 0) {
+      fprintf(stderr, "Can't allocate packing buffer\n");
+      exit(1);
+   }
+   return p;
+}  /* Alloc_pack */
@@ -0,0 +1,38 @@
+/* File:     gemm.h
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to threaded matrix-vector and matrix-matrix
+ *           multiplies on doubles.  Matrices are stored by rows:
+ *           A[i][j] = A[i*lda + j].
+ *
+ * Example:
+ *    #include "pool.h"
+ *    #include "gemm.h"
+ *    . . .
+ *    pool_t* pool = Pool_create(thread_count, 1);
+ *    Blas_gemv(pool, m, n, 1.0, A, n, x, 0.0, y);        (y = A x)
+ *    Blas_gemm(pool, m, n, k, 1.0, A, k, B, n, 0.0, C, n); (C = A B)
+ */
+#ifndef _GEMM_H_
+#define _GEMM_H_
+
+#include "pool.h"
+
+/* Register tile:  the micro-kernel computes an MR x NR block of C */
+#define GEMM_MR 6
+#define GEMM_NR 8
+
+/* Cache blocks:  an MC x KC panel of A stays in L2, a KC x NR sliver
+ * of B in L1, and a KC x NC panel of B in L3 */
+#define GEMM_MC 96
+#define GEMM_KC 256
+#define GEMM_NC 2048
+
+void Blas_gemv(pool_t* pool, long m, long n, double alpha, const double* A,
+        long lda, const double* x, double beta, double* y);
+void Blas_gemm(pool_t* pool, long m, long n, long k, double alpha,
+        const double* A, long lda, const double* B, long ldb, double beta,
+        double* C, long ldc);
+
+#endif
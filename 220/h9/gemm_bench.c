@@ -0,0 +1,249 @@
+/* File:     gemm_bench.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Time Blas_gemv and Blas_gemm in gemm.c and compare their
+ *           GFLOP/s with the peak floating point rate.
+ *
+ * Compile:  gcc -g -Wall -O3 -march=native -I.. -o gemm_bench
+ *              gemm_bench.c gemm.c pool.c ../numa_rt.c -lpthread -lm
+ * Usage:    gemm_bench <thread_count> <m> <n> <k> [reps [peak]]
+ *              gemv uses an m x n matrix, gemm computes an m x n
+ *                 matrix from m x k and k x n matrices
+ *              reps:  times each multiply is run, default 5
+ *              peak:  theoretical peak in GFLOP/s for thread_count
+ *                 cores (cores x GHz x flops per cycle:  e.g. 32 for
+ *                 an AVX2 core with two FMA units).  If it's omitted,
+ *                 it's measured (note 2).
+ *
+ * Input:    None
+ * Output:   For gemv and gemm the fastest time, GFLOP/s, the percent
+ *           of peak, and the largest relative error in a check.  gemv
+ *           also reports GB/s, since it's memory bound.  If
+ *           m*n*k <= NAIVE_MAX the time of a naive triple loop is
+ *           printed for comparison.
+ *
+ * Notes:
+ *    1.  gemv does 2mn flops and reads 8mn bytes of A.  gemm does
+ *        2mnk flops.
+ *    2.  The measured peak comes from every thread in the pool doing
+ *        independent vector multiply-adds on registers.  It's what
+ *        the compiler can get out of the core, so it can be a bit
+ *        under the theoretical number.
+ *    3.  gemv is checked against a serial loop.  gemm is checked at
+ *        CHECKS random entries, each computed with a dot product.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "timer.h"
+#include "pool.h"
+#include "gemm.h"
+
+#define PEAK_ACC 12
+#define PEAK_ITERS 20000000
+#define CHECKS 200
+#define NAIVE_MAX (1L << 30)
+
+typedef double v4d __attribute__((vector_size(32)));
+
+double peak_sink[64];
+
+void    Usage(char* prog_name);
+double* Alloc_mat(long elts);
+void    Fill(double* a, long elts, unsigned seed);
+double  Measure_peak(pool_t* pool);
+void    Peak_work(int rank, int thread_count, void* arg);
+void    Naive(long m, long n, long k, const double* A, const double* B,
+           double* C);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int     thread_count, reps = 5, r, c;
+   long    m, n, k, i, j, p;
+   double  peak = 0.0, start, finish, best, gflops, err, max_err, dot;
+   double  *A, *B, *C, *x, *y, *y_ref;
+   pool_t* pool;
+
+   if (argc < 5 || argc > 7) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   m = strtol(argv[2], NULL, 10);
+   n = strtol(argv[3], NULL, 10);
+   k = strtol(argv[4], NULL, 10);
+   if (argc >= 6) reps = strtol(argv[5], NULL, 10);
+   if (argc == 7) peak = strtod(argv[6], NULL);
+   if (thread_count <= 0 || m <= 0 || n <= 0 || k <= 0 || reps <= 0)
+      Usage(argv[0]);
+
+   pool = Pool_create(thread_count, 1);
+   if (peak <= 0.0) peak = Measure_peak(pool);
+   printf("%d threads, peak = %.2f GFLOP/s%s\n", thread_count, peak,
+         argc == 7 ? "" : " (measured)");
+
+   /* gemv */
+   A = Alloc_mat(m*n);
+   x = Alloc_mat(n);
+   y = Alloc_mat(m);
+   y_ref = Alloc_mat(m);
+   Fill(A, m*n, 1);
+   Fill(x, n, 2);
+   best = 1e30;
+   for (r = 0; r < reps; r++) {
+      GET_TIME(start);
+      Blas_gemv(pool, m, n, 1.0, A, n, x, 0.0, y);
+      GET_TIME(finish);
+      if (finish - start < best) best = finish - start;
+   }
+   max_err = 0.0;
+   for (i = 0; i < m; i++) {
+      for (dot = 0.0, j = 0; j < n; j++)
+         dot += A[i*n + j]*x[j];
+      err = fabs(y[i] - dot)/(fabs(dot) + 1e-300);
+      if (err > max_err) max_err = err;
+   }
+   gflops = 2.0*m*n/best/1e9;
+   printf("gemv %ld x %ld:  %e s, %.2f GFLOP/s (%.1f%% of peak), "
+         "%.2f GB/s, error %.1e\n", m, n, best, gflops, 100*gflops/peak,
+         8.0*m*n/best/1e9, max_err);
+   free(A); free(x); free(y); free(y_ref);
+
+   /* gemm */
+   A = Alloc_mat(m*k);
+   B = Alloc_mat(k*n);
+   C = Alloc_mat(m*n);
+   Fill(A, m*k, 3);
+   Fill(B, k*n, 4);
+   best = 1e30;
+   for (r = 0; r < reps; r++) {
+      GET_TIME(start);
+      Blas_gemm(pool, m, n, k, 1.0, A, k, B, n, 0.0, C, n);
+      GET_TIME(finish);
+      if (finish - start < best) best = finish - start;
+   }
+   max_err = 0.0;
+   srandom(5);
+   for (c = 0; c < CHECKS; c++) {
+      i = random() % m;
+      j = random() % n;
+      for (dot = 0.0, p = 0; p < k; p++)
+         dot += A[i*k + p]*B[p*n + j];
+      err = fabs(C[i*n + j] - dot)/(fabs(dot) + 1e-300);
+      if (err > max_err) max_err = err;
+   }
+   gflops = 2.0*m*n*k/best/1e9;
+   printf("gemm %ld x %ld x %ld:  %e s, %.2f GFLOP/s (%.1f%% of peak), "
+         "error %.1e\n", m, n, k, best, gflops, 100*gflops/peak, max_err);
+
+   if (m*n*k <= NAIVE_MAX) {
+      GET_TIME(start);
+      Naive(m, n, k, A, B, C);
+      GET_TIME(finish);
+      printf("naive serial triple loop:  %e s, %.2f GFLOP/s\n",
+            finish - start, 2.0*m*n*k/(finish - start)/1e9);
+   }
+
+   free(A); free(B); free(C);
+   Pool_destroy(pool);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   print a message showing what the command line should
+ *            be, and terminate
+ * In arg :   prog_name
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> <m> <n> <k> [reps [peak]]\n",
+         prog_name);
+   fprintf(stderr, "   peak:  peak GFLOP/s (default: measure)\n");
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Alloc_mat
+ * Purpose:   Allocate a 64 byte aligned array of elts doubles
+ */
+double* Alloc_mat(long elts) {
+   double* a;
+
+   if (posix_memalign((void**) &a, 64, elts*sizeof(double)) != 0) {
+      fprintf(stderr, "Can't allocate %ld doubles\n", elts);
+      exit(1);
+   }
+   return a;
+}  /* Alloc_mat */
+
+
+/*------------------------------------------------------------------
+ * Function:  Fill
+ * Purpose:   Fill a with random values in [-1, 1]
+ */
+void Fill(double* a, long elts, unsigned seed) {
+   long i;
+
+   srandom(seed);
+   for (i = 0; i < elts; i++)
+      a[i] = 2.0*random()/RAND_MAX - 1.0;
+}  /* Fill */
+
+
+/*------------------------------------------------------------------
+ * Function:  Measure_peak
+ * Purpose:   Estimate the pool's peak GFLOP/s (note 2)
+ */
+double Measure_peak(pool_t* pool) {
+   double start, finish;
+
+   Pool_run(pool, Peak_work, NULL);   /* Warm up the cores */
+   GET_TIME(start);
+   Pool_run(pool, Peak_work, NULL);
+   GET_TIME(finish);
+   return (double) pool->thread_count*PEAK_ITERS*PEAK_ACC*4*2
+      /(finish - start)/1e9;
+}  /* Measure_peak */
+
+
+/*------------------------------------------------------------------
+ * Function:  Peak_work
+ * Purpose:   Pool job:  PEAK_ITERS rounds of PEAK_ACC independent
+ *            vector multiply-adds.  The result goes to peak_sink so
+ *            the compiler can't drop the loop.
+ */
+void Peak_work(int rank, int thread_count, void* arg) {
+   v4d  acc[PEAK_ACC];
+   v4d  a = {1.0000001, 0.9999999, 1.0000002, 0.9999998};
+   v4d  b = {1e-9, 2e-9, 3e-9, 4e-9};
+   v4d  s = {0.0, 0.0, 0.0, 0.0};
+   long i;
+   int  j;
+
+   for (j = 0; j < PEAK_ACC; j++)
+      acc[j] = (v4d) {j, j, j, j};
+   for (i = 0; i < PEAK_ITERS; i++)
+      for (j = 0; j < PEAK_ACC; j++)
+         acc[j] = acc[j]*a + b;
+   for (j = 0; j < PEAK_ACC; j++)
+      s += acc[j];
+   peak_sink[rank % 64] = s[0] + s[1] + s[2] + s[3];
+}  /* Peak_work */
+
+
+/*------------------------------------------------------------------
+ * Function:  Naive
+ * Purpose:   C = A B with the textbook ikj triple loop, serially
+ */
+void Naive(long m, long n, long k, const double* A, const double* B,
+      double* C) {
+   long i, j, p;
+
+   for (i = 0; i < m; i++) {
+      for (j = 0; j < n; j++)
+         C[i*n + j] = 0.0;
+      for (p = 0; p < k; p++)
+         for (j = 0; j < n; j++)
+            C[i*n + j] += A[i*k + p]*B[p*n + j];
+   }
+}  /* Naive */
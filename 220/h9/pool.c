@@ -0,0 +1,313 @@
+/* File:     pool.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the thread pool in pool.h
+ *
+ * Compile:  link with the caller and -lpthread, e.g.
+ *           gcc -g -Wall -O3 -march=native -I.. -o daxpy daxpy.c blas1.c
+ *              pool.c ../numa_rt.c -lpthread -lm
+ *
+ * Notes:
+ *    1.  The thread that calls Pool_run is rank 0 and does a share of
+ *        the job itself, so a pool of thread_count threads only
+ *        creates thread_count - 1 helpers.
+ *    2.  A job starts when the generation count goes up.  Each helper
+ *        remembers the last generation it ran, so a broadcast on
+ *        start_cond that a helper misses (because it's still
+ *        finishing the previous job) doesn't lose the job.
+ *    3.  With pin set, the thread with rank r is pinned to CPU
+ *        Numa_cpu(r) (../numa_rt.c:  the NUMA_CPUS map, or by default
+ *        r % (number of CPUs)), so the helpers don't wander between
+ *        cores and lose their caches, and the memory they first touch
+ *        stays on their node.  Pool_create pins the calling thread as
+ *        rank 0.
+ *    4.  Pool_block gives each rank a contiguous block of [0, n) whose
+ *        boundaries are multiples of BLOCK_ALIGN elements, so two
+ *        threads don't write to the same cache line of a double
+ *        array.
+ *    5.  Pool_first_touch and Pool_placement use the same blocks as
+ *        Pool_block, so an array that's first touched through the pool
+ *        has each thread's block on that thread's node, and the
+ *        placement report counts each block's pages from the thread
+ *        that works on it.
+ *    6.  Pool_scratch gives each rank a 64 byte aligned buffer that
+ *        lasts until Pool_destroy, so a job that needs workspace (like
+ *        gemm's packing buffers) doesn't malloc and fault in fresh
+ *        pages every time it runs.  It's only reallocated when a job
+ *        asks for more than it has, and it's touched first by the
+ *        rank that uses it.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "pool.h"
+#include "numa_rt.h"
+
+#define BLOCK_ALIGN 8
+
+typedef struct {
+   pool_t* pool;
+   int     rank;
+} helper_arg_t;
+
+typedef struct {
+   char*          p;
+   long           n;
+   size_t         size;
+   numa_counts_t* counts;
+} touch_arg_t;
+
+static void* Helper(void* arg);
+static void  Pin(pthread_t thread, int rank);
+static void  Touch_work(int rank, int thread_count, void* arg);
+static void  Placement_work(int rank, int thread_count, void* arg);
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_create
+ * Purpose:     Start a pool of thread_count threads (note 1)
+ * In args:     thread_count, pin (note 3)
+ * Ret val:     The pool
+ */
+pool_t* Pool_create(int thread_count, int pin) {
+   pool_t*       pool = malloc(sizeof(pool_t));
+   helper_arg_t* args;
+   int           rank;
+
+   if (thread_count < 1) thread_count = 1;
+   pool->thread_count = thread_count;
+   pool->handles = malloc(thread_count*sizeof(pthread_t));
+   pool->scratch = calloc(thread_count, sizeof(void*));
+   pool->scratch_bytes = calloc(thread_count, sizeof(size_t));
+   pthread_mutex_init(&pool->mutex, NULL);
+   pthread_cond_init(&pool->start_cond, NULL);
+   pthread_cond_init(&pool->done_cond, NULL);
+   pool->job = NULL;
+   pool->arg = NULL;
+   pool->generation = 0;
+   pool->running = 0;
+   pool->quit = 0;
+
+   args = malloc(thread_count*sizeof(helper_arg_t));
+   if (pin) Pin(pthread_self(), 0);
+   for (rank = 1; rank < thread_count; rank++) {
+      args[rank].pool = pool;
+      args[rank].rank = rank;
+      pthread_create(&pool->handles[rank], NULL, Helper, &args[rank]);
+      if (pin) Pin(pool->handles[rank], rank);
+   }
+   pool->helper_args = args;
+
+   return pool;
+}  /* Pool_create */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pin
+ * Purpose:     Pin thread to CPU Numa_cpu(rank) (note 3)
+ */
+static void Pin(pthread_t thread, int rank) {
+   cpu_set_t set;
+
+   CPU_ZERO(&set);
+   CPU_SET(Numa_cpu(rank), &set);
+   pthread_setaffinity_np(thread, sizeof(set), &set);
+}  /* Pin */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Helper
+ * Purpose:     Thread function for ranks 1, 2, ...:  wait for a job,
+ *              run it, report that it's done, repeat (note 2)
+ * In arg:      arg:  pool and rank
+ */
+static void* Helper(void* arg) {
+   helper_arg_t* h = arg;
+   pool_t*       pool = h->pool;
+   long          seen = 0;
+   pool_job_t    job;
+   void*         job_arg;
+
+   while (1) {
+      pthread_mutex_lock(&pool->mutex);
+      while (pool->generation == seen && !pool->quit)
+         pthread_cond_wait(&pool->start_cond, &pool->mutex);
+      if (pool->quit) {
+         pthread_mutex_unlock(&pool->mutex);
+         break;
+      }
+      seen = pool->generation;
+      job = pool->job;
+      job_arg = pool->arg;
+      pthread_mutex_unlock(&pool->mutex);
+
+      job(h->rank, pool->thread_count, job_arg);
+
+      pthread_mutex_lock(&pool->mutex);
+      if (--pool->running == 0)
+         pthread_cond_signal(&pool->done_cond);
+      pthread_mutex_unlock(&pool->mutex);
+   }
+   return NULL;
+}  /* Helper */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_run
+ * Purpose:     Run job(rank, thread_count, arg) on every thread in the
+ *              pool, and return when they've all finished
+ * In args:     job, arg
+ * In/out arg:  pool
+ */
+void Pool_run(pool_t* pool, pool_job_t job, void* arg) {
+   if (pool->thread_count == 1) {
+      job(0, 1, arg);
+      return;
+   }
+
+   pthread_mutex_lock(&pool->mutex);
+   pool->job = job;
+   pool->arg = arg;
+   pool->running = pool->thread_count - 1;
+   pool->generation++;
+   pthread_cond_broadcast(&pool->start_cond);
+   pthread_mutex_unlock(&pool->mutex);
+
+   job(0, pool->thread_count, arg);
+
+   pthread_mutex_lock(&pool->mutex);
+   while (pool->running > 0)
+      pthread_cond_wait(&pool->done_cond, &pool->mutex);
+   pthread_mutex_unlock(&pool->mutex);
+}  /* Pool_run */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_destroy
+ * Purpose:     Stop the helpers and free the pool
+ * In/out arg:  pool
+ */
+void Pool_destroy(pool_t* pool) {
+   int rank;
+
+   pthread_mutex_lock(&pool->mutex);
+   pool->quit = 1;
+   pthread_cond_broadcast(&pool->start_cond);
+   pthread_mutex_unlock(&pool->mutex);
+   for (rank = 1; rank < pool->thread_count; rank++)
+      pthread_join(pool->handles[rank], NULL);
+
+   for (rank = 0; rank < pool->thread_count; rank++)
+      free(pool->scratch[rank]);
+   free(pool->scratch);
+   free(pool->scratch_bytes);
+   free(pool->helper_args);
+   free(pool->handles);
+   pthread_mutex_destroy(&pool->mutex);
+   pthread_cond_destroy(&pool->start_cond);
+   pthread_cond_destroy(&pool->done_cond);
+   free(pool);
+}  /* Pool_destroy */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_scratch
+ * Purpose:     Return rank's scratch buffer, with room for at least
+ *              bytes (note 6).  Only rank itself should call this,
+ *              from inside a job.
+ * In args:     pool, rank, bytes
+ * Ret val:     The buffer:  its contents are whatever the last job
+ *              left there
+ */
+void* Pool_scratch(pool_t* pool, int rank, size_t bytes) {
+   if (pool->scratch_bytes[rank] < bytes) {
+      free(pool->scratch[rank]);
+      if (posix_memalign(&pool->scratch[rank], 64, bytes) != 0) {
+         fprintf(stderr, "Can't allocate %zu bytes of scratch\n", bytes);
+         exit(1);
+      }
+      pool->scratch_bytes[rank] = bytes;
+   }
+   return pool->scratch[rank];
+}  /* Pool_scratch */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_block
+ * Purpose:     Find rank's block of [0, n) (note 4)
+ * In args:     rank, thread_count, n
+ * Out args:    first_p, last_p:  the block is [*first_p, *last_p)
+ */
+void Pool_block(int rank, int thread_count, long n, long* first_p,
+      long* last_p) {
+   long first = n*rank/thread_count;
+   long last = n*(rank + 1)/thread_count;
+
+   first -= first % BLOCK_ALIGN;
+   if (rank == thread_count - 1)
+      last = n;
+   else
+      last -= last % BLOCK_ALIGN;
+   *first_p = first;
+   *last_p = last;
+}  /* Pool_block */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_first_touch
+ * Purpose:     Have each thread in the pool first touch its block of
+ *              the n elements of size bytes starting at p (note 5).
+ *              Call it right after the malloc, before anything else
+ *              writes the array.
+ * In args:     pool, n, size
+ * In/out arg:  p:  contents are unchanged
+ */
+void Pool_first_touch(pool_t* pool, void* p, long n, size_t size) {
+   touch_arg_t t = {p, n, size, NULL};
+
+   Pool_run(pool, Touch_work, &t);
+}  /* Pool_first_touch */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Pool_placement
+ * Purpose:     Add up how many pages of each thread's block of the n
+ *              elements of size bytes at p are on that thread's node
+ *              and how many are on another node (note 5)
+ * In args:     pool, p, n, size
+ * In/out arg:  counts:  the pages are added to it
+ */
+void Pool_placement(pool_t* pool, const void* p, long n, size_t size,
+      numa_counts_t* counts) {
+   touch_arg_t t = {(char*) p, n, size, counts};
+
+   Pool_run(pool, Placement_work, &t);
+}  /* Pool_placement */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Touch_work
+ * Purpose:     Pool job for Pool_first_touch
+ */
+static void Touch_work(int rank, int thread_count, void* arg) {
+   touch_arg_t* t = arg;
+   long         first, last;
+
+   Pool_block(rank, thread_count, t->n, &first, &last);
+   Numa_first_touch(t->p + first*t->size, (last - first)*t->size);
+}  /* Touch_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Placement_work
+ * Purpose:     Pool job for Pool_placement
+ */
+static void Placement_work(int rank, int thread_count, void* arg) {
+   touch_arg_t* t = arg;
+   long         first, last;
+
+   Pool_block(rank, thread_count, t->n, &first, &last);
+   Numa_count_pages(t->p + first*t->size, (last - first)*t->size,
+         t->counts);
+}  /* Placement_work */
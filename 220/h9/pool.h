@@ -0,0 +1,58 @@
+/* File:     pool.h
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to a persistent pool of pinned threads.  The
+ *           threads are created once and then run one job after
+ *           another, so a kernel doesn't pay for pthread_create and
+ *           pthread_join every time it's called.
+ *
+ * Example:
+ *    #include "pool.h"
+ *    . . .
+ *    void Work(int rank, int thread_count, void* arg) { ... }
+ *    . . .
+ *    pool_t* pool = Pool_create(thread_count, 1);
+ *    Pool_run(pool, Work, &my_args);    (returns when all are done)
+ *    . . .
+ *    (in Work, a buffer that's kept from job to job)
+ *    double* w = Pool_scratch(pool, rank, bytes);
+ *    . . .
+ *    Pool_destroy(pool);
+ */
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stddef.h>
+#include <pthread.h>
+#include "numa_rt.h"
+
+typedef void (*pool_job_t)(int rank, int thread_count, void* arg);
+
+typedef struct {
+   int             thread_count;    /* Including the caller (rank 0)  */
+   pthread_t*      handles;         /* Ranks 1, ..., thread_count-1   */
+   void**          scratch;         /* Each rank's Pool_scratch       */
+   size_t*         scratch_bytes;
+   void*           helper_args;     /* Each helper's pool and rank    */
+   pthread_mutex_t mutex;
+   pthread_cond_t  start_cond;
+   pthread_cond_t  done_cond;
+   pool_job_t      job;
+   void*           arg;
+   long            generation;      /* Incremented for each job       */
+   int             running;         /* Helpers still working on job   */
+   int             quit;
+} pool_t;
+
+pool_t* Pool_create(int thread_count, int pin);
+void    Pool_run(pool_t* pool, pool_job_t job, void* arg);
+void    Pool_destroy(pool_t* pool);
+void    Pool_block(int rank, int thread_count, long n, long* first_p,
+           long* last_p);
+void*   Pool_scratch(pool_t* pool, int rank, size_t bytes);
+void    Pool_first_touch(pool_t* pool, void* p, long n, size_t size);
+void    Pool_placement(pool_t* pool, const void* p, long n, size_t size,
+           numa_counts_t* counts);
+
+#endif
@@ -0,0 +1,462 @@
+/* File:     spmv.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the sparse matrix formats and the threaded
+ *           sparse matrix-vector multiplies in spmv.h
+ *
+ * Compile:  link with the caller, pool.c, ../numa_rt.c and -lpthread,
+ *           e.g.
+ *           gcc -g -Wall -O3 -march=native -I.. -o spmv_bench
+ *              spmv_bench.c spmv.c pool.c ../numa_rt.c -lpthread -lm
+ *
+ * Notes:
+ *    1.  CSR keeps each row's column indices and values together, so
+ *        y[i] is a dot product of the row with a gather from x.  Each
+ *        nonzero costs 12 bytes of matrix and 2 flops, so SpMV is
+ *        limited by memory bandwidth, not by the FPU.
+ *    2.  Threads don't get equal numbers of rows:  a few long rows
+ *        would make one thread do most of the work while the rest
+ *        wait.  Spmv_block splits the rows (or SELL slices) so each
+ *        thread gets about the same number of nonzeros plus unit for
+ *        each row, with a binary search on row_ptr.  The unit per row
+ *        covers the cost of writing y, so a block of empty rows isn't
+ *        free.  Each call recomputes the blocks, which is
+ *        thread_count*log(m) work, so nothing has to be kept in the
+ *        matrix for a particular number of threads.
+ *    3.  SELL-C-sigma:  the rows are sorted by length, longest first,
+ *        inside windows of sigma rows, and each group of SELL_C
+ *        consecutive sorted rows is a slice.  A slice is padded to
+ *        the length of its longest row and stored by columns:  entry
+ *        j of its row r is at slice_ptr[s] + j*SELL_C + r.  So the
+ *        inner loop does SELL_C rows at once with one vector load of
+ *        values, one of column indices and one gather from x.  Sorting
+ *        puts rows of about the same length in a slice, so there's
+ *        little padding, and keeping the sort inside a window keeps
+ *        the rows of a slice near each other in A, so their x
+ *        accesses stay local.  sigma <= 1 doesn't sort.
+ *    4.  Padding entries have value 0 and the row's last column (or
+ *        column 0 for an empty row), so they read an x that's already
+ *        in cache.
+ *    5.  Csr_read_mm reads coordinate Matrix Market files with real,
+ *        integer or pattern entries (pattern entries are 1), general,
+ *        symmetric or skew-symmetric.  The symmetric ones store only
+ *        the lower triangle, and the upper one is filled in.  Complex
+ *        and dense (array) files are refused.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include "spmv.h"
+
+#define ALIGN 64
+#define MAX_LINE 1024
+
+typedef struct {
+   const void*   A;     /* csr_t or sell_t */
+   const double* x;
+   double*       y;
+} spmv_arg_t;
+
+typedef struct {
+   long len;
+   int  row;
+} row_len_t;
+
+static void  Csr_work(int rank, int thread_count, void* arg);
+static void  Sell_work(int rank, int thread_count, void* arg);
+static long  Lower_bound(const long* ptr, long count, long unit,
+                long target);
+static int   Compare_len(const void* one, const void* two);
+static void* Alloc(long count, size_t size);
+
+/*-------------------------------------------------------------------
+ * Function:    Csr_read_mm
+ * Purpose:     Read a Matrix Market file into A (note 5)
+ * In arg:      path
+ * Out arg:     A
+ * Ret val:     0 if it worked.  Otherwise -1, after printing the
+ *              reason to stderr.
+ */
+int Csr_read_mm(const char* path, csr_t* A) {
+   FILE*   fp;
+   char    line[MAX_LINE], object[64], format[64], field[64], symm[64];
+   long    m, n, nz, k, i, j, count = 0;
+   int     pattern, sign = 0;
+   int*    row;
+   int*    col;
+   double* val;
+   double  v = 1.0;
+
+   if ((fp = fopen(path, "r")) == NULL) {
+      fprintf(stderr, "Can't open %s\n", path);
+      return -1;
+   }
+   if (fgets(line, MAX_LINE, fp) == NULL ||
+         sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s", object,
+            format, field, symm) != 4) {
+      fprintf(stderr, "%s isn't a Matrix Market file\n", path);
+      fclose(fp);
+      return -1;
+   }
+   pattern = (strcasecmp(field, "pattern") == 0);
+   if (strcasecmp(symm, "symmetric") == 0)
+      sign = 1;
+   else if (strcasecmp(symm, "skew-symmetric") == 0)
+      sign = -1;
+   if (strcasecmp(object, "matrix") != 0 ||
+         strcasecmp(format, "coordinate") != 0 ||
+         (!pattern && strcasecmp(field, "real") != 0 &&
+            strcasecmp(field, "double") != 0 &&
+            strcasecmp(field, "integer") != 0) ||
+         (sign == 0 && strcasecmp(symm, "general") != 0)) {
+      fprintf(stderr, "%s:  can't read %s %s %s %s matrices\n", path,
+            object, format, field, symm);
+      fclose(fp);
+      return -1;
+   }
+
+   /* Skip the comments, then read the size line */
+   do {
+      if (fgets(line, MAX_LINE, fp) == NULL) line[0] = '\0';
+   } while (line[0] == '%' || line[0] == '\n');
+   if (sscanf(line, "%ld %ld %ld", &m, &n, &nz) != 3 || m < 0 || n < 0 ||
+         nz < 0 || m > INT_MAX || n > INT_MAX) {
+      fprintf(stderr, "%s:  bad size line\n", path);
+      fclose(fp);
+      return -1;
+   }
+
+   row = Alloc(sign ? 2*nz : nz, sizeof(int));
+   col = Alloc(sign ? 2*nz : nz, sizeof(int));
+   val = Alloc(sign ? 2*nz : nz, sizeof(double));
+   for (k = 0; k < nz; k++) {
+      if (fscanf(fp, "%ld %ld", &i, &j) != 2 ||
+            (!pattern && fscanf(fp, "%lf", &v) != 1) ||
+            i < 1 || i > m || j < 1 || j > n) {
+         fprintf(stderr, "%s:  bad entry %ld\n", path, k + 1);
+         free(row); free(col); free(val);
+         fclose(fp);
+         return -1;
+      }
+      row[count] = i - 1;
+      col[count] = j - 1;
+      val[count++] = v;
+      if (sign != 0 && i != j) {
+         row[count] = j - 1;
+         col[count] = i - 1;
+         val[count++] = sign*v;
+      }
+   }
+   fclose(fp);
+
+   Csr_from_coo(m, n, count, row, col, val, A);
+   free(row);
+   free(col);
+   free(val);
+   return 0;
+}  /* Csr_read_mm */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Csr_from_coo
+ * Purpose:     Build A from nnz (row, col, val) triples in any order.
+ *              Two counting sorts, by column and then stably by row,
+ *              leave each row's columns in increasing order.
+ *              Duplicates are kept.
+ * In args:     m, n, nnz, row, col, val (NULL:  all 1)
+ * Out arg:     A
+ */
+void Csr_from_coo(long m, long n, long nnz, const int* row, const int* col,
+      const double* val, csr_t* A) {
+   long*   ptr = Alloc(n + 1, sizeof(long));
+   int*    t_row = Alloc(nnz, sizeof(int));
+   int*    t_col = Alloc(nnz, sizeof(int));
+   double* t_val = Alloc(nnz, sizeof(double));
+   long    i, k, p;
+
+   memset(ptr, 0, (n + 1)*sizeof(long));
+   for (k = 0; k < nnz; k++)
+      ptr[col[k] + 1]++;
+   for (i = 0; i < n; i++)
+      ptr[i+1] += ptr[i];
+   for (k = 0; k < nnz; k++) {
+      p = ptr[col[k]]++;
+      t_row[p] = row[k];
+      t_col[p] = col[k];
+      t_val[p] = (val == NULL) ? 1.0 : val[k];
+   }
+   free(ptr);
+
+   A->m = m;
+   A->n = n;
+   A->nnz = nnz;
+   A->row_ptr = Alloc(m + 1, sizeof(long));
+   A->col = Alloc(nnz, sizeof(int));
+   A->val = Alloc(nnz, sizeof(double));
+   memset(A->row_ptr, 0, (m + 1)*sizeof(long));
+   for (k = 0; k < nnz; k++)
+      A->row_ptr[t_row[k] + 1]++;
+   for (i = 0; i < m; i++)
+      A->row_ptr[i+1] += A->row_ptr[i];
+   ptr = Alloc(m, sizeof(long));
+   memcpy(ptr, A->row_ptr, m*sizeof(long));
+   for (k = 0; k < nnz; k++) {
+      p = ptr[t_row[k]]++;
+      A->col[p] = t_col[k];
+      A->val[p] = t_val[k];
+   }
+   free(ptr);
+
+   free(t_row);
+   free(t_col);
+   free(t_val);
+}  /* Csr_from_coo */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Csr_free
+ * Purpose:     Free the arrays in A
+ */
+void Csr_free(csr_t* A) {
+   free(A->row_ptr);
+   free(A->col);
+   free(A->val);
+}  /* Csr_free */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Sell_from_csr
+ * Purpose:     Build the SELL-C-sigma form of A (notes 3 and 4)
+ * In args:     A, sigma
+ * Out arg:     S
+ */
+void Sell_from_csr(const csr_t* A, int sigma, sell_t* S) {
+   row_len_t* rows = Alloc(A->m, sizeof(row_len_t));
+   long       i, w, s, k, j, len, width, base, off;
+   int        r, row;
+
+   if (sigma > 1 && sigma % SELL_C != 0)
+      sigma += SELL_C - sigma % SELL_C;
+   S->m = A->m;
+   S->n = A->n;
+   S->nnz = A->nnz;
+   S->sigma = sigma;
+   S->slices = (A->m + SELL_C - 1)/SELL_C;
+
+   for (i = 0; i < A->m; i++) {
+      rows[i].len = A->row_ptr[i+1] - A->row_ptr[i];
+      rows[i].row = i;
+   }
+   if (sigma > 1)
+      for (w = 0; w < A->m; w += sigma)
+         qsort(rows + w, (A->m - w < sigma) ? A->m - w : sigma,
+               sizeof(row_len_t), Compare_len);
+   S->perm = Alloc(A->m, sizeof(int));
+   for (i = 0; i < A->m; i++)
+      S->perm[i] = rows[i].row;
+
+   S->slice_ptr = Alloc(S->slices + 1, sizeof(long));
+   S->slice_ptr[0] = 0;
+   for (s = 0; s < S->slices; s++) {
+      width = 0;
+      for (k = s*SELL_C; k < A->m && k < (s + 1)*SELL_C; k++)
+         if (rows[k].len > width) width = rows[k].len;
+      S->slice_ptr[s+1] = S->slice_ptr[s] + width*SELL_C;
+   }
+   S->stored = S->slice_ptr[S->slices];
+
+   S->col = Alloc(S->stored, sizeof(int));
+   S->val = Alloc(S->stored, sizeof(double));
+   for (s = 0; s < S->slices; s++) {
+      off = S->slice_ptr[s];
+      width = (S->slice_ptr[s+1] - off)/SELL_C;
+      for (r = 0; r < SELL_C; r++) {
+         k = s*SELL_C + r;
+         row = (k < A->m) ? rows[k].row : -1;
+         len = (row >= 0) ? rows[k].len : 0;
+         base = (row >= 0) ? A->row_ptr[row] : 0;
+         for (j = 0; j < width; j++) {
+            if (j < len) {
+               S->col[off + j*SELL_C + r] = A->col[base + j];
+               S->val[off + j*SELL_C + r] = A->val[base + j];
+            } else {
+               S->col[off + j*SELL_C + r] = (len > 0) ?
+                  A->col[base + len - 1] : 0;
+               S->val[off + j*SELL_C + r] = 0.0;
+            }
+         }
+      }
+   }
+
+   free(rows);
+}  /* Sell_from_csr */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Sell_free
+ * Purpose:     Free the arrays in S
+ */
+void Sell_free(sell_t* S) {
+   free(S->slice_ptr);
+   free(S->perm);
+   free(S->col);
+   free(S->val);
+}  /* Sell_free */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Spmv_csr
+ * Purpose:     y = A x, A in CSR.  pool = NULL:  serial.
+ */
+void Spmv_csr(pool_t* pool, const csr_t* A, const double* x, double* y) {
+   spmv_arg_t t = {A, x, y};
+
+   if (pool == NULL)
+      Csr_work(0, 1, &t);
+   else
+      Pool_run(pool, Csr_work, &t);
+}  /* Spmv_csr */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Csr_work
+ * Purpose:     Pool job:  this thread's block of rows of y = A x
+ */
+static void Csr_work(int rank, int thread_count, void* arg) {
+   const spmv_arg_t* t = arg;
+   const csr_t*      A = t->A;
+   const double* restrict x = t->x;
+   const double* restrict val = A->val;
+   const int* restrict    col = A->col;
+   double*           y = t->y;
+   long              first, last, i, k;
+   double            sum;
+
+   Spmv_block(A->row_ptr, A->m, 1, rank, thread_count, &first, &last);
+   for (i = first; i < last; i++) {
+      sum = 0.0;
+      for (k = A->row_ptr[i]; k < A->row_ptr[i+1]; k++)
+         sum += val[k]*x[col[k]];
+      y[i] = sum;
+   }
+}  /* Csr_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Spmv_sell
+ * Purpose:     y = A x, A in SELL-C-sigma.  pool = NULL:  serial.
+ */
+void Spmv_sell(pool_t* pool, const sell_t* S, const double* x, double* y) {
+   spmv_arg_t t = {S, x, y};
+
+   if (pool == NULL)
+      Sell_work(0, 1, &t);
+   else
+      Pool_run(pool, Sell_work, &t);
+}  /* Spmv_sell */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Sell_work
+ * Purpose:     Pool job:  this thread's block of slices of y = A x
+ *              (note 3)
+ */
+static void Sell_work(int rank, int thread_count, void* arg) {
+   const spmv_arg_t* t = arg;
+   const sell_t*     S = t->A;
+   const double* restrict x = t->x;
+   double*           y = t->y;
+   const double*     v;
+   const int*        c;
+   double            sum[SELL_C];
+   long              first, last, s, j, width, k;
+   int               r;
+
+   Spmv_block(S->slice_ptr, S->slices, SELL_C, rank, thread_count, &first,
+         &last);
+   for (s = first; s < last; s++) {
+      v = S->val + S->slice_ptr[s];
+      c = S->col + S->slice_ptr[s];
+      width = (S->slice_ptr[s+1] - S->slice_ptr[s])/SELL_C;
+      for (r = 0; r < SELL_C; r++)
+         sum[r] = 0.0;
+      for (j = 0; j < width; j++, v += SELL_C, c += SELL_C)
+         for (r = 0; r < SELL_C; r++)
+            sum[r] += v[r]*x[c[r]];
+      for (r = 0, k = s*SELL_C; r < SELL_C && k < S->m; r++, k++)
+         y[S->perm[k]] = sum[r];
+   }
+}  /* Sell_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Spmv_block
+ * Purpose:     Find rank's block of [0, count) rows or slices, so the
+ *              blocks have about equal ptr[last] - ptr[first] +
+ *              unit*(last - first) (note 2)
+ * In args:     ptr:  count + 1 offsets (row_ptr or slice_ptr)
+ *              count, unit, rank, thread_count
+ * Out args:    first_p, last_p:  the block is [*first_p, *last_p)
+ */
+void Spmv_block(const long* ptr, long count, long unit, int rank,
+      int thread_count, long* first_p, long* last_p) {
+   long total = ptr[count] + unit*count;
+
+   *first_p = (rank == 0) ? 0 :
+      Lower_bound(ptr, count, unit, total*rank/thread_count);
+   *last_p = (rank == thread_count - 1) ? count :
+      Lower_bound(ptr, count, unit, total*(rank + 1)/thread_count);
+}  /* Spmv_block */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Lower_bound
+ * Purpose:     Return the smallest i in [0, count] with
+ *              ptr[i] + unit*i >= target
+ */
+static long Lower_bound(const long* ptr, long count, long unit,
+      long target) {
+   long lo = 0, hi = count, mid;
+
+   while (lo < hi) {
+      mid = lo + (hi - lo)/2;
+      if (ptr[mid] + unit*mid < target)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}  /* Lower_bound */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Compare_len
+ * Purpose:     qsort comparison:  longer rows first, ties in row order
+ */
+static int Compare_len(const void* one, const void* two) {
+   const row_len_t* a = one;
+   const row_len_t* b = two;
+
+   if (a->len != b->len) return (a->len > b->len) ? -1 : 1;
+   return (a->row > b->row) - (a->row < b->row);
+}  /* Compare_len */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Alloc
+ * Purpose:     Allocate an ALIGN byte aligned array of count elements
+ *              of size bytes, or quit
+ */
+static void* Alloc(long count, size_t size) {
+   void* p;
+
+   if (count < 1) count = 1;
+   if (posix_memalign(&p, ALIGN, count*size) != 0) {
+      fprintf(stderr, "Can't allocate %ld elements\n", count);
+      exit(1);
+   }
+   return p;
+}  /* Alloc */
@@ -0,0 +1,67 @@
+/* File:     spmv.h
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to threaded sparse matrix-vector multiplies
+ *           y = A x, with A in compressed sparse row (CSR) or
+ *           SELL-C-sigma format, and a Matrix Market reader.
+ *
+ * Example:
+ *    #include "pool.h"
+ *    #include "spmv.h"
+ *    . . .
+ *    csr_t  A;
+ *    sell_t S;
+ *    if (Csr_read_mm("matrix.mtx", &A) != 0) exit(1);
+ *    Sell_from_csr(&A, SELL_SIGMA, &S);
+ *    pool_t* pool = Pool_create(thread_count, 1);
+ *    Spmv_csr(pool, &A, x, y);
+ *    Spmv_sell(pool, &S, x, y);
+ *    . . .
+ *    Sell_free(&S);
+ *    Csr_free(&A);
+ */
+#ifndef _SPMV_H_
+#define _SPMV_H_
+
+#include "pool.h"
+
+/* Rows per SELL slice:  one vector of doubles with AVX-512 */
+#define SELL_C 8
+/* Default sorting window for SELL, in rows (a multiple of SELL_C) */
+#define SELL_SIGMA 4096
+
+typedef struct {
+   long    m, n;        /* Rows and columns                        */
+   long    nnz;
+   long*   row_ptr;     /* Row i is entries row_ptr[i], ...,       */
+                        /*    row_ptr[i+1]-1                       */
+   int*    col;         /* nnz column indices, increasing in a row */
+   double* val;         /* nnz values                              */
+} csr_t;
+
+typedef struct {
+   long    m, n;
+   long    nnz;         /* Nonzeros, not counting padding          */
+   long    stored;      /* Entries stored, counting padding        */
+   int     sigma;
+   long    slices;      /* ceil(m/SELL_C)                          */
+   long*   slice_ptr;   /* Slice s starts at entry slice_ptr[s]    */
+   int*    perm;        /* Row k of the sorted matrix is row       */
+                        /*    perm[k] of A                         */
+   int*    col;         /* stored column indices                   */
+   double* val;         /* stored values                           */
+} sell_t;
+
+int  Csr_read_mm(const char* path, csr_t* A);
+void Csr_from_coo(long m, long n, long nnz, const int* row, const int* col,
+        const double* val, csr_t* A);
+void Csr_free(csr_t* A);
+void Sell_from_csr(const csr_t* A, int sigma, sell_t* S);
+void Sell_free(sell_t* S);
+void Spmv_csr(pool_t* pool, const csr_t* A, const double* x, double* y);
+void Spmv_sell(pool_t* pool, const sell_t* S, const double* x, double* y);
+void Spmv_block(const long* ptr, long count, long unit, int rank,
+        int thread_count, long* first_p, long* last_p);
+
+#endif
@@ -0,0 +1,313 @@
+/* File:     spmv_bench.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Time the threaded sparse matrix-vector multiplies in
+ *           spmv.c on a Matrix Market file or on a generated matrix
+ *           with a few very long rows.
+ *
+ * Compile:  gcc -g -Wall -O3 -march=native -I.. -o spmv_bench
+ *              spmv_bench.c spmv.c pool.c ../numa_rt.c -lpthread -lm
+ * Usage:    spmv_bench <thread_count> <matrix file | n> [reps [sigma]]
+ *              matrix file:  a coordinate Matrix Market (.mtx) file
+ *              n:  use an n x n generated matrix (note 1)
+ *              reps:  times each multiply is run (default 20)
+ *              sigma:  SELL sorting window (default SELL_SIGMA)
+ *
+ * Input:    None
+ * Output:   The size of the matrix and its row lengths, and for each
+ *           way of doing the multiply its fastest time, GFLOP/s,
+ *           effective bandwidth in GB/s, the load imbalance (the most
+ *           work any thread gets divided by the average), and the
+ *           largest relative difference from the serial CSR multiply.
+ *
+ * Notes:
+ *    1.  The generated matrix has a diagonal, four off-diagonals (at
+ *        distance 1 and sqrt(n), like a 2d finite difference
+ *        stencil), and in the first 1/HUB_PART of the rows, every
+ *        LONG_EVERY rows a row with LONG_LEN random columns.  So most
+ *        rows are short, but the long ones hold a big share of the
+ *        nonzeros and they're bunched together, so splitting by rows
+ *        gives the first thread much more work than the others.
+ *    2.  "csr rows" splits the rows into equal counts with
+ *        Pool_block, for comparison with the nnz balanced split that
+ *        Spmv_csr and Spmv_sell use (spmv.c, note 2).  The imbalance
+ *        counts nonzeros plus one per row (SELL:  stored entries plus
+ *        one per row).
+ *    3.  Flops are 2*nnz for every format:  the multiplies by SELL's
+ *        padding aren't counted.  Bytes are what the format has to
+ *        read from memory once:  values and column indices (SELL:
+ *        including padding), row_ptr or slice_ptr and perm, x once,
+ *        and y written once.  Reads of x that miss cache aren't
+ *        counted, so the GB/s is a lower bound.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "timer.h"
+#include "pool.h"
+#include "spmv.h"
+
+#define HUB_PART 4
+#define LONG_EVERY 250
+#define LONG_LEN 2000
+
+typedef struct {
+   const csr_t*  A;
+   const double* x;
+   double*       y;
+} rows_arg_t;
+
+void    Usage(char* prog_name);
+void    Generate(long n, csr_t* A);
+void    Rows_work(int rank, int thread_count, void* arg);
+double  Imbalance(const long* ptr, long count, long unit, int by_nnz,
+           int thread_count);
+double  Max_error(const double* y, const double* y_ref, long m);
+void    Report(const char* format, const char* part, double secs, long nnz,
+           double bytes, double imbalance, double err);
+double* Alloc_vec(long n);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int        thread_count, reps = 20, sigma = SELL_SIGMA, r, k;
+   long       n, i, len, max_len = 0;
+   char*      end;
+   csr_t      A;
+   sell_t     S;
+   pool_t*    pool;
+   rows_arg_t t;
+   double     *x, *y, *y_ref;
+   double     start, finish, best, csr_bytes, sell_bytes;
+
+   if (argc < 3 || argc > 5) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   if (argc >= 4) reps = strtol(argv[3], NULL, 10);
+   if (argc == 5) sigma = strtol(argv[4], NULL, 10);
+   if (thread_count <= 0 || reps <= 0) Usage(argv[0]);
+
+   n = strtol(argv[2], &end, 10);
+   if (*end == '\0') {
+      if (n < 2) Usage(argv[0]);
+      Generate(n, &A);
+   } else if (Csr_read_mm(argv[2], &A) != 0) {
+      exit(1);
+   }
+   Sell_from_csr(&A, sigma, &S);
+   for (i = 0; i < A.m; i++) {
+      len = A.row_ptr[i+1] - A.row_ptr[i];
+      if (len > max_len) max_len = len;
+   }
+
+   pool = Pool_create(thread_count, 1);
+   x = Alloc_vec(A.n);
+   y = Alloc_vec(A.m);
+   y_ref = Alloc_vec(A.m);
+   Pool_first_touch(pool, y, A.m, sizeof(double));
+   srandom(1);
+   for (i = 0; i < A.n; i++)
+      x[i] = random()/((double) RAND_MAX) - 0.5;
+   Spmv_csr(NULL, &A, x, y_ref);
+
+   printf("%d threads, %ld x %ld, nnz = %ld, row length avg %.1f max %ld, "
+         "best of %d\n", thread_count, A.m, A.n, A.nnz,
+         (double) A.nnz/(A.m > 0 ? A.m : 1), max_len, reps);
+   printf("SELL-%d-%d:  %ld entries stored, %.1f%% padding\n", SELL_C,
+         S.sigma, S.stored,
+         100.0*(S.stored - S.nnz)/(S.stored > 0 ? S.stored : 1));
+   printf("%-6s %-5s %12s %8s %8s %9s %9s\n", "format", "split", "seconds",
+         "GFLOP/s", "GB/s", "imbalance", "error");
+
+   csr_bytes = 12.0*A.nnz + 8.0*(A.m + 1) + 8.0*A.m + 8.0*A.n;
+   sell_bytes = 12.0*S.stored + 8.0*(S.slices + 1) + 4.0*A.m + 8.0*A.m +
+      8.0*A.n;
+   t.A = &A;
+   t.x = x;
+   t.y = y;
+   for (k = 0; k < 3; k++) {
+      best = 1e30;
+      for (r = 0; r < reps; r++) {
+         GET_TIME(start);
+         switch (k) {
+            case 0: Pool_run(pool, Rows_work, &t);   break;
+            case 1: Spmv_csr(pool, &A, x, y);        break;
+            case 2: Spmv_sell(pool, &S, x, y);       break;
+         }
+         GET_TIME(finish);
+         if (finish - start < best) best = finish - start;
+      }
+      if (k == 0)
+         Report("csr", "rows", best, A.nnz, csr_bytes,
+               Imbalance(A.row_ptr, A.m, 1, 0, thread_count),
+               Max_error(y, y_ref, A.m));
+      else if (k == 1)
+         Report("csr", "nnz", best, A.nnz, csr_bytes,
+               Imbalance(A.row_ptr, A.m, 1, 1, thread_count),
+               Max_error(y, y_ref, A.m));
+      else
+         Report("sell", "nnz", best, A.nnz, sell_bytes,
+               Imbalance(S.slice_ptr, S.slices, SELL_C, 1, thread_count),
+               Max_error(y, y_ref, A.m));
+   }
+
+   free(x);
+   free(y);
+   free(y_ref);
+   Sell_free(&S);
+   Csr_free(&A);
+   Pool_destroy(pool);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print a message showing what the command line should
+ *            be, and terminate
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> <matrix file | n> "
+         "[reps [sigma]]\n", prog_name);
+   fprintf(stderr, "   matrix file:  coordinate Matrix Market file\n");
+   fprintf(stderr, "   n:  generate an n x n matrix (n >= 2)\n");
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Generate
+ * Purpose:   Build the n x n test matrix described in note 1
+ */
+void Generate(long n, csr_t* A) {
+   long    side = (long) sqrt((double) n), i, j, count = 0, cap;
+   long    off[4];
+   long    long_len = (n < LONG_LEN) ? n : LONG_LEN;
+   int*    row;
+   int*    col;
+   double* val;
+
+   if (side < 2) side = 2;
+   off[0] = -side; off[1] = -1; off[2] = 1; off[3] = side;
+   cap = 5*n + (n/LONG_EVERY + 1)*long_len;
+   row = malloc(cap*sizeof(int));
+   col = malloc(cap*sizeof(int));
+   val = malloc(cap*sizeof(double));
+   if (row == NULL || col == NULL || val == NULL) {
+      fprintf(stderr, "Can't allocate the matrix\n");
+      exit(1);
+   }
+
+   srandom(2);
+   for (i = 0; i < n; i++) {
+      row[count] = i;
+      col[count] = i;
+      val[count++] = 4.0;
+      for (j = 0; j < 4; j++)
+         if (i + off[j] >= 0 && i + off[j] < n) {
+            row[count] = i;
+            col[count] = i + off[j];
+            val[count++] = -1.0;
+         }
+      if (i < n/HUB_PART && i % LONG_EVERY == 0)
+         for (j = 0; j < long_len; j++) {
+            row[count] = i;
+            col[count] = random() % n;
+            val[count++] = 1.0/(j + 1);
+         }
+   }
+
+   Csr_from_coo(n, n, count, row, col, val, A);
+   free(row);
+   free(col);
+   free(val);
+}  /* Generate */
+
+
+/*------------------------------------------------------------------
+ * Function:  Rows_work
+ * Purpose:   Pool job:  CSR y = A x on a block of rows from
+ *            Pool_block (note 2)
+ */
+void Rows_work(int rank, int thread_count, void* arg) {
+   rows_arg_t* t = arg;
+   const csr_t* A = t->A;
+   long        first, last, i, k;
+   double      sum;
+
+   Pool_block(rank, thread_count, A->m, &first, &last);
+   for (i = first; i < last; i++) {
+      sum = 0.0;
+      for (k = A->row_ptr[i]; k < A->row_ptr[i+1]; k++)
+         sum += A->val[k]*t->x[A->col[k]];
+      t->y[i] = sum;
+   }
+}  /* Rows_work */
+
+
+/*------------------------------------------------------------------
+ * Function:  Imbalance
+ * Purpose:   Return the most work any thread gets, divided by the
+ *            average, where the work in [first, last) is
+ *            ptr[last] - ptr[first] + unit*(last - first)
+ * In args:   ptr, count, unit
+ *            by_nnz:  1 for Spmv_block's split, 0 for Pool_block's
+ *            thread_count
+ */
+double Imbalance(const long* ptr, long count, long unit, int by_nnz,
+      int thread_count) {
+   long   first, last, work, max = 0;
+   double total = ptr[count] + (double) unit*count;
+   int    rank;
+
+   for (rank = 0; rank < thread_count; rank++) {
+      if (by_nnz)
+         Spmv_block(ptr, count, unit, rank, thread_count, &first, &last);
+      else
+         Pool_block(rank, thread_count, count, &first, &last);
+      work = ptr[last] - ptr[first] + unit*(last - first);
+      if (work > max) max = work;
+   }
+   return (total > 0) ? max/(total/thread_count) : 1.0;
+}  /* Imbalance */
+
+
+/*------------------------------------------------------------------
+ * Function:  Max_error
+ * Purpose:   Largest relative difference between y and y_ref
+ */
+double Max_error(const double* y, const double* y_ref, long m) {
+   double err, max_err = 0.0;
+   long   i;
+
+   for (i = 0; i < m; i++) {
+      err = fabs(y[i] - y_ref[i])/(fabs(y_ref[i]) + 1e-300);
+      if (err > max_err) max_err = err;
+   }
+   return max_err;
+}  /* Max_error */
+
+
+/*------------------------------------------------------------------
+ * Function:  Report
+ * Purpose:   Print one line of the table (note 3)
+ */
+void Report(const char* format, const char* part, double secs, long nnz,
+      double bytes, double imbalance, double err) {
+   printf("%-6s %-5s %12e %8.2f %8.2f %9.2f %9.1e\n", format, part, secs,
+         2.0*nnz/secs/1e9, bytes/secs/1e9, imbalance, err);
+}  /* Report */
+
+
+/*------------------------------------------------------------------
+ * Function:  Alloc_vec
+ * Purpose:   Allocate a vector of n doubles, or quit
+ */
+double* Alloc_vec(long n) {
+   double* v = malloc((n > 0 ? n : 1)*sizeof(double));
+
+   if (v == NULL) {
+      fprintf(stderr, "Can't allocate a vector of %ld doubles\n", n);
+      exit(1);
+   }
+   return v;
+}  /* Alloc_vec */
@@ -0,0 +1,230 @@
+/* File:     hier.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the node-aware building blocks in hier.h
+ *
+ * Compile:  link with the caller, e.g.
+ *           mpicc -g -Wall -I.. -o gs global_sum_driver.c allreduce.c
+ *              ../hier.c ../ring.c
+ *
+ * Notes:
+ *    1.  The node communicator comes from MPI_Comm_split_type with
+ *        MPI_COMM_TYPE_SHARED, so its processes can all load and store
+ *        one window made with MPI_Win_allocate_shared.  The window
+ *        has a slot of HIER_SLOT bytes for each process plus one for
+ *        results, which the leader allocates right after its own
+ *        slot.  Messages longer than a slot go through in pieces.
+ *    2.  MPI_Win_fence on the window is the only synchronization:
+ *        everything stored before a fence can be loaded by any
+ *        process on the node after it.
+ *    3.  Hier_node_reduce_int:  each process stores its piece of x in
+ *        its slot, then process q adds up its share of the elements
+ *        across all the slots, so the node's processes do the sum
+ *        together instead of the leader doing it alone.
+ *    4.  Hier_node_gatherv_int makes a window just for the gather:
+ *        each process asks for count ints and, since the window is
+ *        contiguous, the leader sees all the lists one after another
+ *        in node rank order.  (Querying MPI_PROC_NULL gives the start
+ *        even if the leader's own list is empty.)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hier.h"
+
+static char* Slot(hier_t* h, int q);
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_create
+ * Purpose:     Split comm into nodes and leaders and make the node's
+ *              shared window
+ * In arg:      comm
+ * Out arg:     h
+ */
+void Hier_create(hier_t* h, MPI_Comm comm) {
+   int      my_rank, p, leader_rank = -1, ppn = 0;
+   char*    env = getenv("HIER_PPN");
+   MPI_Aint size;
+   int      disp;
+   void*    my_slot;
+
+   h->comm = comm;
+   MPI_Comm_rank(comm, &my_rank);
+   if (env != NULL) ppn = strtol(env, NULL, 10);
+   if (ppn > 0)
+      MPI_Comm_split(comm, my_rank/ppn, my_rank, &h->node);
+   else
+      MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank,
+            MPI_INFO_NULL, &h->node);
+   MPI_Comm_rank(h->node, &h->node_rank);
+   MPI_Comm_size(h->node, &h->node_size);
+
+   MPI_Comm_split(comm, h->node_rank == 0 ? 0 : MPI_UNDEFINED, my_rank,
+         &h->leaders);
+   if (h->leaders != MPI_COMM_NULL) {
+      MPI_Comm_rank(h->leaders, &leader_rank);
+      MPI_Comm_size(h->leaders, &h->num_nodes);
+   }
+   MPI_Bcast(&leader_rank, 1, MPI_INT, 0, h->node);
+   MPI_Bcast(&h->num_nodes, 1, MPI_INT, 0, h->node);
+   MPI_Comm_size(comm, &p);
+   h->leader_of = malloc(p*sizeof(int));
+   MPI_Allgather(&leader_rank, 1, MPI_INT, h->leader_of, 1, MPI_INT, comm);
+
+   size = (h->node_rank == 0) ? 2*HIER_SLOT : HIER_SLOT;
+   MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, h->node, &my_slot,
+         &h->win);
+   MPI_Win_shared_query(h->win, 0, &size, &disp, &h->base);
+}  /* Hier_create */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_free
+ * Purpose:     Free the communicators and window in h
+ * In/out arg:  h
+ */
+void Hier_free(hier_t* h) {
+   MPI_Win_free(&h->win);
+   if (h->leaders != MPI_COMM_NULL) MPI_Comm_free(&h->leaders);
+   MPI_Comm_free(&h->node);
+   free(h->leader_of);
+}  /* Hier_free */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Slot
+ * Purpose:     Find node rank q's slot in the shared window.  The
+ *              results slot is Slot(h, 1) - HIER_SLOT.
+ */
+static char* Slot(hier_t* h, int q) {
+   return h->base + (q == 0 ? 0 : (q + 1)*(long) HIER_SLOT);
+}  /* Slot */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_root_to_leader
+ * Purpose:     Copy buf from process root to the leader of root's node
+ * In args:     bytes, root (rank in h->comm)
+ * In/out arg:  buf:  in on root, out on its leader
+ *
+ * Note:        The processes on other nodes just return.
+ */
+void Hier_root_to_leader(hier_t* h, void* buf, int bytes, int root) {
+   int       my_rank, root_node_rank;
+   MPI_Group comm_group, node_group;
+
+   MPI_Comm_rank(h->comm, &my_rank);
+   if (h->leader_of[root] != h->leader_of[my_rank]) return;
+
+   MPI_Comm_group(h->comm, &comm_group);
+   MPI_Comm_group(h->node, &node_group);
+   MPI_Group_translate_ranks(comm_group, 1, &root, node_group,
+         &root_node_rank);
+   MPI_Group_free(&comm_group);
+   MPI_Group_free(&node_group);
+
+   if (root_node_rank == 0) return;
+   if (my_rank == root)
+      MPI_Send(buf, bytes, MPI_BYTE, 0, 0, h->node);
+   else if (h->node_rank == 0)
+      MPI_Recv(buf, bytes, MPI_BYTE, root_node_rank, 0, h->node,
+            MPI_STATUS_IGNORE);
+}  /* Hier_root_to_leader */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_node_bcast
+ * Purpose:     Copy buf from the leader to the rest of its node
+ *              through the shared window
+ * In arg:      bytes
+ * In/out arg:  buf:  in on the leader, out on the others
+ */
+void Hier_node_bcast(hier_t* h, void* buf, int bytes) {
+   char* b = buf;
+   int   done, len;
+
+   if (h->node_size == 1) return;
+   for (done = 0; done < bytes; done += len) {
+      len = (bytes - done < HIER_SLOT) ? bytes - done : HIER_SLOT;
+      MPI_Win_fence(0, h->win);
+      if (h->node_rank == 0)
+         memcpy(h->base, b + done, len);
+      MPI_Win_fence(0, h->win);
+      if (h->node_rank != 0)
+         memcpy(b + done, h->base, len);
+   }
+   MPI_Win_fence(0, h->win);
+}  /* Hier_node_bcast */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_node_reduce_int
+ * Purpose:     Sum x over the processes on the node (note 3)
+ * In arg:      n
+ * In/out arg:  x:  in everywhere, the node's sum out on the leader
+ */
+void Hier_node_reduce_int(hier_t* h, int x[], int n) {
+   int  per = HIER_SLOT/sizeof(int);
+   int  done, len, lo, hi, i, q;
+   int* result = (int*) (h->base + HIER_SLOT);
+   int* slot;
+
+   if (h->node_size == 1) return;
+   for (done = 0; done < n; done += len) {
+      len = (n - done < per) ? n - done : per;
+      MPI_Win_fence(0, h->win);
+      memcpy(Slot(h, h->node_rank), x + done, len*sizeof(int));
+      MPI_Win_fence(0, h->win);
+
+      lo = (long) h->node_rank*len/h->node_size;
+      hi = (long) (h->node_rank + 1)*len/h->node_size;
+      for (i = lo; i < hi; i++)
+         result[i] = 0;
+      for (q = 0; q < h->node_size; q++) {
+         slot = (int*) Slot(h, q);
+         for (i = lo; i < hi; i++)
+            result[i] += slot[i];
+      }
+      MPI_Win_fence(0, h->win);
+
+      if (h->node_rank == 0)
+         memcpy(x + done, result, len*sizeof(int));
+   }
+   MPI_Win_fence(0, h->win);
+}  /* Hier_node_reduce_int */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Hier_node_gatherv_int
+ * Purpose:     Gather the lists on the node onto the leader, in node
+ *              rank order (note 4)
+ * In args:     mine, count
+ * Out arg:     all_p:  on the leader, a malloc'ed array with the
+ *                 concatenated lists.  NULL on the other processes.
+ * Ret val:     On the leader, the length of *all_p.  0 elsewhere.
+ */
+int Hier_node_gatherv_int(hier_t* h, const int mine[], int count,
+      int** all_p) {
+   MPI_Win  win;
+   int*     my_part;
+   int*     start;
+   int      total = 0, disp;
+   MPI_Aint size;
+
+   MPI_Reduce(&count, &total, 1, MPI_INT, MPI_SUM, 0, h->node);
+   MPI_Win_allocate_shared(count*sizeof(int), sizeof(int), MPI_INFO_NULL,
+         h->node, &my_part, &win);
+   MPI_Win_fence(0, win);
+   memcpy(my_part, mine, count*sizeof(int));
+   MPI_Win_fence(0, win);
+
+   *all_p = NULL;
+   if (h->node_rank == 0) {
+      MPI_Win_shared_query(win, MPI_PROC_NULL, &size, &disp, &start);
+      *all_p = malloc((total > 0 ? total : 1)*sizeof(int));
+      memcpy(*all_p, start, total*sizeof(int));
+   }
+   MPI_Win_fence(0, win);
+   MPI_Win_free(&win);
+   return total;
+}  /* Hier_node_gatherv_int */
@@ -0,0 +1,53 @@
+/* File:     hier.h
+ * Author:   Cayla Shaver
+ * Purpose:  Building blocks for hierarchical (node-aware) MPI
+ *           collectives.  The processes that share a node talk through
+ *           a shared memory window, and only one process per node, its
+ *           leader, takes part in the communication between nodes.
+ *
+ * Example:
+ *    #include "hier.h"
+ *    . . .
+ *    hier_t h;
+ *    Hier_create(&h, comm);
+ *    Hier_node_reduce_int(&h, x, n);          (sum onto the leader)
+ *    if (h.leaders != MPI_COMM_NULL)
+ *       ... any collective on h.leaders ...
+ *    Hier_node_bcast(&h, x, n*sizeof(int));   (leader to the node)
+ *    . . .
+ *    Hier_free(&h);
+ *
+ * Note:     To try out more than one "node" on one machine, set the
+ *           environment variable HIER_PPN to the number of processes
+ *           per node:  e.g. with HIER_PPN=2, processes 0 and 1 are one
+ *           node, 2 and 3 the next, etc.
+ */
+#ifndef _HIER_H_
+#define _HIER_H_
+
+#include <mpi.h>
+
+/* Bytes each process gets in the node's shared window */
+#define HIER_SLOT 65536
+
+typedef struct {
+   MPI_Comm comm;        /* All the processes                        */
+   MPI_Comm node;        /* The processes on this node               */
+   MPI_Comm leaders;     /* Node rank 0's:  MPI_COMM_NULL elsewhere  */
+   int      node_rank, node_size;
+   int      num_nodes;
+   int*     leader_of;   /* leader_of[q] = rank in leaders of the    */
+                         /*    leader of q's node                    */
+   MPI_Win  win;         /* node_size + 1 slots of HIER_SLOT bytes   */
+   char*    base;        /* Start of slot 0 on this node             */
+} hier_t;
+
+void Hier_create(hier_t* h, MPI_Comm comm);
+void Hier_free(hier_t* h);
+void Hier_root_to_leader(hier_t* h, void* buf, int bytes, int root);
+void Hier_node_bcast(hier_t* h, void* buf, int bytes);
+void Hier_node_reduce_int(hier_t* h, int x[], int n);
+int  Hier_node_gatherv_int(hier_t* h, const int mine[], int count,
+        int** all_p);
+
+#endif
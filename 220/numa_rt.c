@@ -0,0 +1,214 @@
+/* File:     numa_rt.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the NUMA runtime in numa_rt.h
+ *
+ * Compile:  link with the caller and -lpthread, e.g.
+ *           gcc -g -Wall -O3 -march=native -I.. -o daxpy daxpy.c
+ *              blas1.c pool.c ../numa_rt.c -lpthread -lm
+ *
+ * Notes:
+ *    1.  There's no libnuma dependency:  the node of a CPU comes from
+ *        the nodeN entry in /sys/devices/system/cpu/cpuC, and the node
+ *        of a page from the move_pages system call with no target
+ *        nodes, which only reports where the pages are.
+ *    2.  Numa_count_pages counts the pages in a thread's block that
+ *        are local or remote to the node that thread is running on.
+ *        Real local vs remote access counts need hardware counters
+ *        (e.g. perf's node-load-misses), but since each thread
+ *        streams through its own block, the fraction of its pages
+ *        that are remote is the fraction of its accesses that are.
+ *        A page is counted by the block its first byte is in, so a
+ *        page two blocks share is only counted once, and a block
+ *        smaller than a page may count none.  The counts are added
+ *        with atomics, so all the threads can share one
+ *        numa_counts_t.
+ *    3.  On a machine with one node every touched page is local.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include "numa_rt.h"
+
+#define MAX_MAP 4096
+#define PAGE_BATCH 1024
+
+static int            cpu_map[MAX_MAP];
+static int            map_len = 0;
+static pthread_once_t map_once = PTHREAD_ONCE_INIT;
+
+static void Read_map(void);
+
+/*-------------------------------------------------------------------
+ * Function:    Read_map
+ * Purpose:     Parse NUMA_CPUS (note 1 in numa_rt.h) into cpu_map.
+ *              map_len is 0 if it isn't set or can't be parsed.
+ */
+static void Read_map(void) {
+   char* s = getenv("NUMA_CPUS");
+   char* end;
+   long  lo, hi, c;
+
+   while (s != NULL && *s != '\0' && map_len < MAX_MAP) {
+      lo = strtol(s, &end, 10);
+      if (end == s) break;
+      hi = lo;
+      s = end;
+      if (*s == '-') {
+         hi = strtol(s + 1, &end, 10);
+         if (end == s + 1) break;
+         s = end;
+      }
+      for (c = lo; c <= hi && map_len < MAX_MAP; c++)
+         cpu_map[map_len++] = c;
+      if (*s == ',') s++;
+   }
+}  /* Read_map */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_cpu
+ * Purpose:     Return the CPU thread rank should run on
+ */
+int Numa_cpu(int rank) {
+   long cpus;
+
+   pthread_once(&map_once, Read_map);
+   if (map_len > 0) return cpu_map[rank % map_len];
+   cpus = sysconf(_SC_NPROCESSORS_ONLN);
+   if (cpus < 1) cpus = 1;
+   return rank % cpus;
+}  /* Numa_cpu */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_pin
+ * Purpose:     Pin the calling thread to Numa_cpu(rank)
+ * Ret val:     The CPU, or -1 if the pinning failed
+ */
+int Numa_pin(int rank) {
+   int       cpu = Numa_cpu(rank);
+   cpu_set_t set;
+
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+      return -1;
+   return cpu;
+}  /* Numa_pin */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_node_of_cpu
+ * Purpose:     Return the NUMA node of cpu (0 if it can't be found)
+ */
+int Numa_node_of_cpu(int cpu) {
+   char           path[64];
+   DIR*           dir;
+   struct dirent* e;
+   int            node = 0;
+
+   sprintf(path, "/sys/devices/system/cpu/cpu%d", cpu);
+   if ((dir = opendir(path)) == NULL) return 0;
+   while ((e = readdir(dir)) != NULL)
+      if (strncmp(e->d_name, "node", 4) == 0 &&
+            e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+         node = strtol(e->d_name + 4, NULL, 10);
+         break;
+      }
+   closedir(dir);
+   return node;
+}  /* Numa_node_of_cpu */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_my_node
+ * Purpose:     Return the node the calling thread is running on
+ */
+int Numa_my_node(void) {
+   int cpu = sched_getcpu();
+
+   return (cpu < 0) ? 0 : Numa_node_of_cpu(cpu);
+}  /* Numa_my_node */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_first_touch
+ * Purpose:     Write one byte in each page of [p, p + bytes), so the
+ *              pages that haven't been placed yet go on the calling
+ *              thread's node.  The contents are left alone.
+ */
+void Numa_first_touch(void* p, size_t bytes) {
+   volatile char* c = p;
+   long           page = sysconf(_SC_PAGESIZE);
+   size_t         i;
+
+   if (bytes == 0) return;
+   for (i = 0; i < bytes; i += page - ((size_t) (c + i) % page))
+      c[i] = c[i];
+   c[bytes - 1] = c[bytes - 1];
+}  /* Numa_first_touch */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_count_pages
+ * Purpose:     Add the pages that start in [p, p + bytes) that are
+ *              local and remote to the calling thread into counts
+ *              (note 2)
+ * In args:     p, bytes
+ * In/out arg:  counts
+ */
+void Numa_count_pages(const void* p, size_t bytes, numa_counts_t* counts) {
+   long   page = sysconf(_SC_PAGESIZE);
+   int    my_node = Numa_my_node();
+   char*  first = (char*) (((size_t) p + page - 1) & ~(size_t) (page - 1));
+   char*  end = (char*) p + bytes;
+   void*  pages[PAGE_BATCH];
+   int    status[PAGE_BATCH];
+   long   local = 0, remote = 0, absent = 0;
+   int    count, i;
+
+   if (bytes == 0) return;
+   while (first < end) {
+      for (count = 0; count < PAGE_BATCH && first < end;
+            count++, first += page)
+         pages[count] = first;
+      if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0) != 0) {
+         absent += count;
+         continue;
+      }
+      for (i = 0; i < count; i++)
+         if (status[i] < 0)
+            absent++;
+         else if (status[i] == my_node)
+            local++;
+         else
+            remote++;
+   }
+
+   __atomic_fetch_add(&counts->local, local, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&counts->remote, remote, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&counts->absent, absent, __ATOMIC_RELAXED);
+}  /* Numa_count_pages */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Numa_print
+ * Purpose:     Print counts to stderr
+ */
+void Numa_print(const char* title, const numa_counts_t* counts) {
+   long total = counts->local + counts->remote;
+
+   fprintf(stderr, "%s:  %ld local pages, %ld remote pages (%.1f%% local)",
+         title, counts->local, counts->remote,
+         total > 0 ? 100.0*counts->local/total : 100.0);
+   if (counts->absent > 0)
+      fprintf(stderr, ", %ld not placed", counts->absent);
+   fprintf(stderr, "\n");
+}  /* Numa_print */
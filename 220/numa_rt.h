@@ -0,0 +1,48 @@
+/* File:     numa_rt.h
+ * Author:   Cayla Shaver
+ * Purpose:  Thread placement and first-touch memory placement for
+ *           the pthreads programs, so on a multi-socket machine each
+ *           thread works on memory that's attached to its own socket.
+ *
+ * Example:
+ *    #include "numa_rt.h"
+ *    . . .
+ *    (in the thread function)
+ *    Numa_pin(my_rank);                          pin to my core
+ *    Numa_first_touch(x + my_first, my_bytes);   place my block
+ *    . . .
+ *    Numa_count_pages(x + my_first, my_bytes, &counts);
+ *    . . .
+ *    (after the threads are done)
+ *    Numa_print("x", &counts);
+ *
+ * Notes:
+ *    1.  Set NUMA_CPUS to a list of CPUs like "0-7,16-23" or "0,2,4,6"
+ *        to choose where thread r goes:  the (r % list length)th CPU
+ *        in the list.  By default thread r goes to CPU r % (number of
+ *        CPUs).
+ *    2.  Linux puts a page on the node of the thread that first
+ *        writes it.  So a block that's written first by the thread
+ *        that will use it is local to that thread, even if the main
+ *        thread did the malloc.
+ */
+#ifndef _NUMA_RT_H_
+#define _NUMA_RT_H_
+
+#include <stddef.h>
+
+typedef struct {
+   long local;      /* Pages on the counting thread's node  */
+   long remote;     /* Pages on another node                */
+   long absent;     /* Pages that haven't been touched yet  */
+} numa_counts_t;
+
+int  Numa_cpu(int rank);
+int  Numa_pin(int rank);
+int  Numa_node_of_cpu(int cpu);
+int  Numa_my_node(void);
+void Numa_first_touch(void* p, size_t bytes);
+void Numa_count_pages(const void* p, size_t bytes, numa_counts_t* counts);
+void Numa_print(const char* title, const numa_counts_t* counts);
+
+#endif
@@ -0,0 +1,83 @@
+/* File:     heat_setup.c
+ * Author:   Cayla Shaver
+ * Purpose:  Initial and boundary conditions, output and allocation
+ *           shared by the heat equation solvers.
+ *
+ * Compile:  link with the solver, e.g.
+ *           gcc -g -Wall -O3 -o pth_heat pth_heat.c heat_setup.c
+ *               -lpthread -lm
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "heat_setup.h"
+
+/* Alignment of grids, so the stencil loops can use aligned vectors */
+#define GRID_ALIGN 64
+
+/*------------------------------------------------------------------
+ * Function:    Init_temp
+ * Purpose:     Generated starting temperature at x in [0, 1]
+ * In arg:      x
+ * Return val:  100*sin(pi*x), which is 0 at both ends, like the ice
+ */
+double Init_temp(double x) {
+   return 100.0*sin(M_PI*x);
+}  /* Init_temp */
+
+
+/*------------------------------------------------------------------
+ * Function:    Init_rod
+ * Purpose:     Set the starting temperatures at the m+1 gridpoints
+ * In args:     m, g_i:  'g' to generate with Init_temp, 'i' to read
+ *                 m+1 temperatures from stdin
+ * Out arg:     u
+ *
+ * Note:        u[0] and u[m] are always set to ICE.
+ */
+void Init_rod(double u[], long m, char g_i) {
+   long i;
+
+   if (g_i == 'i') {
+      printf("Please enter %ld values for the initial temperatures: \n",
+            m + 1);
+      for (i = 0; i <= m; i++)
+         scanf("%lf", &u[i]);
+   } else {
+      for (i = 0; i <= m; i++)
+         u[i] = Init_temp((double) i/m);
+   }
+   u[0] = u[m] = ICE;
+}  /* Init_rod */
+
+
+/*------------------------------------------------------------------
+ * Function:    Print_row
+ * Purpose:     Print the temperatures at time t_j in p1.c's format
+ * In args:     t_j, u, m
+ */
+void Print_row(double t_j, double u[], long m) {
+   long i;
+
+   printf("%.3f--", t_j);
+   for (i = 0; i <= m; i++)
+      printf("%.3f ", u[i]);
+   printf("\n");
+}  /* Print_row */
+
+
+/*------------------------------------------------------------------
+ * Function:    Alloc_grid
+ * Purpose:     Allocate an aligned array of count doubles on the heap
+ * In arg:      count
+ * Return val:  the array.  Quits if it can't be allocated.
+ */
+double* Alloc_grid(size_t count) {
+   void* p;
+
+   if (posix_memalign(&p, GRID_ALIGN, count*sizeof(double)) != 0) {
+      fprintf(stderr, "Can't allocate %zu doubles\n", count);
+      exit(1);
+   }
+   return (double*) p;
+}  /* Alloc_grid */
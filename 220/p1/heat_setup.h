@@ -0,0 +1,26 @@
+/* File:     heat_setup.h
+ * Author:   Cayla Shaver
+ * Purpose:  Initial and boundary conditions shared by the heat
+ *           equation solvers (pth_heat.c and friends).  They're the
+ *           same as p1.c:  ice (temperature 0) at the ends of the
+ *           rod, and starting temperatures that are either read from
+ *           stdin or generated.
+ *
+ * Example:
+ *    #include "heat_setup.h"
+ *    . . .
+ *    Init_rod(u, m, 'g');
+ */
+#ifndef _HEAT_SETUP_H_
+#define _HEAT_SETUP_H_
+
+#include <stddef.h>
+
+#define ICE 0.0   /* Temperature at the ends of the rod */
+
+double Init_temp(double x);
+void   Init_rod(double u[], long m, char g_i);
+void   Print_row(double t_j, double u[], long m);
+double* Alloc_grid(size_t count);
+
+#endif
@@ -0,0 +1,292 @@
+/* File:    mpi_heat.c
+ * Author:  Cayla Shaver
+ * Purpose: Calculate the temperature at gridpoints along an
+ *          insulated metal rod with ice at each end, at various times,
+ *          using MPI.  The rod is split into blocks of gridpoints, one
+ *          per process, so rods with billions of points can be run
+ *          across nodes.
+ *
+ * Compile: mpicc -g -Wall -O3 -o mpi_heat mpi_heat.c heat_setup.c -lm
+ * Run:     mpiexec -n <p> ./mpi_heat <m> <n> <g|i> [k <file>]
+ *             m:   number of segments on the metal bar
+ *             n:   number of segments of time
+ *            'g':  generate the starting temperatures
+ *            'i':  process 0 reads the m+1 starting temperatures
+ *             k, file:  every k time steps write the temperatures
+ *                  to file as a binary snapshot
+ *
+ * Input:   starting temperatures (optional)
+ * Output:  Snapshots (optional), u(0.5) at t = 1, the sum of the final
+ *          temperatures and the elapsed time.
+ *
+ * Notes:
+ *    1.  Process q owns a contiguous block of the m+1 gridpoints.
+ *        Its local array has one extra "halo" cell on each side for
+ *        the neighbors' boundary points:  local_u[0] and
+ *        local_u[local_n+1].
+ *    2.  Each step posts non-blocking receives and sends for the
+ *        halos, updates the points that don't need them, waits, and
+ *        then updates the two points next to the halos.  So the
+ *        exchange overlaps the bulk of the work.
+ *    3.  The snapshot file is snapshot after snapshot of m+1 native
+ *        doubles, snapshot s holding the temperatures at step s*k.
+ *        It's written with a collective MPI-IO write, each process
+ *        writing its block at its own offset.  MPI counts are ints, so
+ *        a block is written as IO_CHUNK double pieces plus the rest,
+ *        and it can hold more than 2^31 - 1 points.
+ *    4.  Like p1.c, the method is only stable if d/(h*h) <= 0.5.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+#include "heat_setup.h"
+
+#define IO_CHUNK 1048576   /* Doubles per piece of a snapshot write */
+
+void Usage(char* prog_name, int my_rank, MPI_Comm comm);
+void Get_args(int argc, char* argv[], long long* m_p, long* n_p,
+      char* g_i_p, long* k_p, char** file_p, int my_rank, MPI_Comm comm);
+void Init_local(double local_u[], long long my_first, long long local_n,
+      long long m, char g_i, int my_rank, int p, MPI_Comm comm);
+void Update_range(double* restrict new_u, const double* restrict old_u,
+      long long first, long long last, double r);
+void Write_snapshot(MPI_File fh, long snapshot, double local_u[],
+      long long my_first, long long local_n, long long m);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int         p, my_rank, left, right;
+   long long   m, my_first, local_n, lo, hi, mid_lo, mid_hi;
+   long        n, k, j;
+   char        g_i;
+   char*       file = NULL;
+   double      d, h, r, start, finish, my_sum, sum, my_mid, mid;
+   double*     old_u;
+   double*     new_u;
+   double*     temp;
+   MPI_Comm    comm;
+   MPI_Request reqs[4];
+   MPI_File    fh;
+
+   MPI_Init(&argc, &argv);
+   comm = MPI_COMM_WORLD;
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+
+   Get_args(argc, argv, &m, &n, &g_i, &k, &file, my_rank, comm);
+   d = 1.0/n;
+   h = 1.0/m;
+   r = d/(h*h);
+   if (my_rank == 0 && r > 0.5)
+      fprintf(stderr, "Warning: d/(h*h) = %f > 0.5, the method is "
+            "unstable\n", r);
+
+   /* Block distribution of the points 0..m */
+   my_first = my_rank*((m + 1)/p) + (my_rank < (m + 1) % p ? my_rank
+         : (m + 1) % p);
+   local_n = (m + 1)/p + (my_rank < (m + 1) % p ? 1 : 0);
+   left = (my_rank > 0) ? my_rank - 1 : MPI_PROC_NULL;
+   right = (my_rank < p - 1) ? my_rank + 1 : MPI_PROC_NULL;
+
+   old_u = Alloc_grid(local_n + 2);
+   new_u = Alloc_grid(local_n + 2);
+   Init_local(old_u, my_first, local_n, m, g_i, my_rank, p, comm);
+   new_u[1] = old_u[1];
+   new_u[local_n] = old_u[local_n];
+
+   /* Local points lo..hi-1 are updated:  not the ice at 0 and m */
+   lo = (my_first == 0) ? 2 : 1;
+   hi = (my_first + local_n == m + 1) ? local_n : local_n + 1;
+   /* Of those, mid_lo..mid_hi-1 don't need the halos */
+   mid_lo = (lo > 2) ? lo : 2;
+   mid_hi = (hi < local_n) ? hi : local_n;
+
+   if (file != NULL) {
+      if (MPI_File_open(comm, file, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+               MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+         if (my_rank == 0)
+            fprintf(stderr, "Can't open %s for the snapshots\n", file);
+         MPI_Finalize();
+         exit(1);
+      }
+      MPI_File_set_size(fh, 0);
+   }
+
+   MPI_Barrier(comm);
+   start = MPI_Wtime();
+   for (j = 1; j <= n; j++) {
+      MPI_Irecv(&old_u[0], 1, MPI_DOUBLE, left, 0, comm, &reqs[0]);
+      MPI_Irecv(&old_u[local_n + 1], 1, MPI_DOUBLE, right, 0, comm,
+            &reqs[1]);
+      MPI_Isend(&old_u[1], 1, MPI_DOUBLE, left, 0, comm, &reqs[2]);
+      MPI_Isend(&old_u[local_n], 1, MPI_DOUBLE, right, 0, comm, &reqs[3]);
+
+      Update_range(new_u, old_u, mid_lo, mid_hi, r);
+
+      MPI_Waitall(4, reqs, MPI_STATUSES_IGNORE);
+      if (lo == 1 && hi > 1)
+         Update_range(new_u, old_u, 1, 2, r);
+      if (hi == local_n + 1 && local_n > 1)
+         Update_range(new_u, old_u, local_n, local_n + 1, r);
+
+      temp = old_u; old_u = new_u; new_u = temp;
+      if (file != NULL && j % k == 0)
+         Write_snapshot(fh, j/k - 1, old_u, my_first, local_n, m);
+   }
+   finish = MPI_Wtime();
+   if (file != NULL) MPI_File_close(&fh);
+
+   my_sum = 0.0;
+   for (j = 1; j <= local_n; j++)
+      my_sum += old_u[j];
+   /* u(0.5):  gridpoint m/2, or with m odd the average of m/2 and
+    * m/2 + 1, which can be on different processes */
+   my_mid = 0.0;
+   for (j = m/2; j <= m/2 + m % 2; j++)
+      if (my_first <= j && j < my_first + local_n)
+         my_mid += ((m % 2 == 0) ? 1.0 : 0.5)*old_u[j - my_first + 1];
+   MPI_Reduce(&my_sum, &sum, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+   MPI_Reduce(&my_mid, &mid, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+   if (my_rank == 0) {
+      printf("u(0.5) at t = 1 is %.6f\n", mid);
+      printf("Sum of temperatures = %.17e\n", sum);
+      printf("Elapsed time = %e seconds\n", finish - start);
+      printf("%e gridpoint updates per second\n",
+            (double) (m - 1)*n/(finish - start));
+   }
+
+   free(old_u);
+   free(new_u);
+   MPI_Finalize();
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Print a message showing how to run the program, and quit
+ * In args:   prog_name, my_rank, comm
+ */
+void Usage(char* prog_name, int my_rank, MPI_Comm comm) {
+   if (my_rank == 0) {
+      fprintf(stderr, "usage: mpiexec -n <p> %s <m> <n> <g|i> "
+            "[k <file>]\n", prog_name);
+      fprintf(stderr, "   m:   number of segments on the bar\n");
+      fprintf(stderr, "   n:   number of time steps\n");
+      fprintf(stderr, "  'g':  generate starting temperatures\n");
+      fprintf(stderr, "  'i':  read starting temperatures from stdin\n");
+      fprintf(stderr, "   k, file:  write a snapshot to file every k "
+            "steps\n");
+   }
+   MPI_Finalize();
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Get_args
+ * Purpose:   Get and check command line arguments
+ * In args:   argc, argv, my_rank, comm
+ * Out args:  m_p, n_p, g_i_p, k_p, file_p
+ */
+void Get_args(int argc, char* argv[], long long* m_p, long* n_p,
+      char* g_i_p, long* k_p, char** file_p, int my_rank, MPI_Comm comm) {
+   int p;
+
+   MPI_Comm_size(comm, &p);
+   if (argc != 4 && argc != 6) Usage(argv[0], my_rank, comm);
+   *m_p = strtoll(argv[1], NULL, 10);
+   *n_p = strtol(argv[2], NULL, 10);
+   *g_i_p = argv[3][0];
+   *k_p = 0;
+   if (argc == 6) {
+      *k_p = strtol(argv[4], NULL, 10);
+      *file_p = argv[5];
+   }
+   if (*m_p < 2 || *m_p + 1 < p || *n_p <= 0 || (argc == 6 && *k_p <= 0)
+         || (*g_i_p != 'g' && *g_i_p != 'i'))
+      Usage(argv[0], my_rank, comm);
+}  /* Get_args */
+
+
+/*------------------------------------------------------------------
+ * Function:  Init_local
+ * Purpose:   Set the starting temperatures of this process's block
+ * In args:   my_first, local_n, m, g_i, my_rank, p, comm
+ * Out arg:   local_u:  local_u[1..local_n]
+ *
+ * Note:      With 'i' process 0 reads all m+1 temperatures and
+ *            scatters them, so 'i' is only for small rods.
+ */
+void Init_local(double local_u[], long long my_first, long long local_n,
+      long long m, char g_i, int my_rank, int p, MPI_Comm comm) {
+   double*   u = NULL;
+   int*      counts = NULL;
+   int*      displs = NULL;
+   int       q;
+   long long i;
+
+   if (g_i == 'i') {
+      if (my_rank == 0) {
+         u = malloc((m + 1)*sizeof(double));
+         counts = malloc(p*sizeof(int));
+         displs = malloc(p*sizeof(int));
+         Init_rod(u, m, 'i');
+         for (q = 0; q < p; q++) {
+            counts[q] = (m + 1)/p + (q < (m + 1) % p ? 1 : 0);
+            displs[q] = (q == 0) ? 0 : displs[q-1] + counts[q-1];
+         }
+      }
+      MPI_Scatterv(u, counts, displs, MPI_DOUBLE, &local_u[1],
+            (int) local_n, MPI_DOUBLE, 0, comm);
+      free(u);
+      free(counts);
+      free(displs);
+   } else {
+      for (i = 0; i < local_n; i++)
+         local_u[i + 1] = Init_temp((double) (my_first + i)/m);
+   }
+   if (my_first == 0) local_u[1] = ICE;
+   if (my_first + local_n == m + 1) local_u[local_n] = ICE;
+}  /* Init_local */
+
+
+/*------------------------------------------------------------------
+ * Function:    Update_range
+ * Purpose:     Compute the new temperatures at local points
+ *              first..last-1
+ * In args:     old_u, first, last, r
+ * Out arg:     new_u
+ */
+void Update_range(double* restrict new_u, const double* restrict old_u,
+      long long first, long long last, double r) {
+   long long i;
+
+   for (i = first; i < last; i++)
+      new_u[i] = old_u[i] + r*(old_u[i-1] - 2.0*old_u[i] + old_u[i+1]);
+}  /* Update_range */
+
+
+/*------------------------------------------------------------------
+ * Function:  Write_snapshot
+ * Purpose:   Write this process's block of the temperatures into
+ *            snapshot number snapshot of the file (note 3)
+ * In args:   fh, snapshot, local_u, my_first, local_n, m
+ */
+void Write_snapshot(MPI_File fh, long snapshot, double local_u[],
+      long long my_first, long long local_n, long long m) {
+   MPI_Offset   offset = ((MPI_Offset) snapshot*(m + 1) + my_first)
+      *sizeof(double);
+   long long    pieces = local_n/IO_CHUNK;
+   MPI_Datatype chunk;
+
+   /* Every process makes both calls, since they're collective */
+   MPI_Type_contiguous(IO_CHUNK, MPI_DOUBLE, &chunk);
+   MPI_Type_commit(&chunk);
+   MPI_File_write_at_all(fh, offset, &local_u[1], (int) pieces, chunk,
+         MPI_STATUS_IGNORE);
+   MPI_File_write_at_all(fh, offset + pieces*IO_CHUNK*sizeof(double),
+         &local_u[1 + pieces*IO_CHUNK], (int) (local_n % IO_CHUNK),
+         MPI_DOUBLE, MPI_STATUS_IGNORE);
+   MPI_Type_free(&chunk);
+}  /* Write_snapshot */
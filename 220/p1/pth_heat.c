@@ -0,0 +1,541 @@
+/* File:    pth_heat.c
+ * Author:  Cayla Shaver
+ * Purpose: Calculate the temperature at gridpoints along an
+ *          insulated metal rod with ice at each end, at various times,
+ *          using Pthreads.  This is p1.c for rods with millions of
+ *          gridpoints.
+ *
+ * Compile: gcc -g -Wall -O3 -march=native -I.. -o pth_heat pth_heat.c
+ *             heat_setup.c -lpthread -lm
+ * Usage:   pth_heat <thread_count> <m> <n> <g|i> [k [e|t|c [w s]]]
+ *             m:   number of segments on the metal bar
+ *             n:   number of segments of time
+ *            'g':  generate the starting temperatures
+ *            'i':  read the m+1 starting temperatures from stdin
+ *             k:   print the temperatures every k time steps
+ *                  (default 0:  only print the final temperatures)
+ *            'e':  explicit method, one sweep of the rod per step
+ *                  (default)
+ *            't':  explicit method with temporal blocking:  advance
+ *                  tiles of w points s steps at a time
+ *                  (defaults w = TILE_W, s = TILE_S)
+ *            'c':  implicit Crank-Nicolson method
+ *
+ * Input:   starting temperatures (optional)
+ * Output:  Temperatures every k steps, the final temperatures if
+ *          m <= PRINT_MAX, their sum, and the elapsed time.
+ *
+ * Notes:
+ *    1.  old_u and new_u are allocated on the heap.  After each step
+ *        the pointers are swapped instead of copying new_u to old_u.
+ *    2.  Each thread owns a contiguous block of the interior points
+ *        1..m-1.  The threads meet at a barrier once per time step
+ *        ('e') or once per s time steps ('t').  Thread 0 prints while
+ *        the others go on:  that's safe, since the next step only
+ *        reads the row that's being printed.
+ *    3.  Update_block uses restrict pointers and a precomputed
+ *        coefficient so the compiler can vectorize it.
+ *    4.  The explicit method is only stable if d/(h*h) <= 0.5, i.e.
+ *        n >= 2*m*m.  A warning is printed if it isn't.  Crank-Nicolson
+ *        is stable for any n, so n can be orders of magnitude smaller.
+ *    5.  Temporal blocking uses overlapped (ghost zone) tiles.  To
+ *        advance points [lo, hi) s steps, a tile copies points
+ *        [lo-s, hi+s) into a small buffer that stays in cache, and
+ *        the region it updates shrinks by one point on each side per
+ *        step.  Neighboring tiles recompute a few of the same points,
+ *        about s/w extra work, but the rod only streams through
+ *        memory once every s steps instead of every step.  Every
+ *        point is computed by Update_block from the same inputs as in
+ *        'e', so the results are bit-identical.
+ *    6.  Crank-Nicolson solves a tridiagonal system
+ *           -r/2 x[i-1] + (1+r) x[i] - r/2 x[i+1] = b[i],  i = 1..m-1
+ *        each step.  With one thread this is the Thomas algorithm.
+ *        With more, each thread's block of rows is solved with its
+ *        own Thomas factorization, treating the values just outside
+ *        the block as unknowns:
+ *           x = y - x[first-1]*v - x[last]*w
+ *        where y, v and w solve the block's system with right hand
+ *        sides b, -(r/2)e_first and -(r/2)e_last.  The first and last
+ *        x of every block then satisfy a small reduced system of
+ *        2*thread_count equations that thread 0 solves, and each
+ *        thread finishes its block with the formula above.  The
+ *        matrix doesn't change, so the factorizations, v, w and the
+ *        LU factors of the reduced system are computed once.  Each
+ *        block needs at least 2 rows.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "timer.h"
+#include "heat_setup.h"
+
+const long PRINT_MAX = 100;
+const long TILE_W = 4096;
+const long TILE_S = 32;
+
+/* Global variables:  shared by the threads */
+int     thread_count;
+long    m;
+long    n;
+long    k;
+char    method;
+long    tile_w;
+long    tile_s;
+double  d;
+double  h;
+double  r;   /* d/(h*h) */
+double* u_a;
+double* u_b;
+double* final_u;
+pthread_barrier_t barrier;
+
+/* Crank-Nicolson reduced system:  entries 2q and 2q+1 are for the
+ * first and last rows of thread q's block */
+double* red_v;    /* v at the first and last rows of each block */
+double* red_w;    /* w at the first and last rows of each block */
+double* red_x;    /* y, then the solution, at the same rows      */
+double* red_lu;   /* LU factors of the reduced matrix            */
+
+void  Usage(char* prog_name);
+void  Get_args(int argc, char* argv[], char* g_i_p);
+void* Heat_work(void* rank);
+void  Block_range(long my_rank, long* first_p, long* last_p);
+void  Blocked_steps(double* restrict new_u, const double* restrict old_u,
+      long first, long last, long steps, double* tile_a, double* tile_b);
+void  Update_block(double* restrict new_u, const double* restrict old_u,
+      long first, long last, double r);
+void  Cn_work(long my_rank, long my_first, long my_last);
+void  Thomas_factor(double c_prime[], double mult[], long len);
+void  Thomas_solve(double x[], const double b[], const double c_prime[],
+      const double mult[], long len);
+void  Reduced_factor(double lu[], const double v[], const double w[],
+      int size);
+void  Reduced_solve(double x[], const double lu[], int size);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long       thread, i;
+   pthread_t* thread_handles;
+   char       g_i;
+   double     start, finish, sum;
+
+   Get_args(argc, argv, &g_i);
+   d = 1.0/n;
+   h = 1.0/m;
+   r = d/(h*h);
+   if (r > 0.5 && method != 'c')
+      fprintf(stderr, "Warning: d/(h*h) = %f > 0.5, the method is "
+            "unstable\n", r);
+
+   u_a = Alloc_grid(m + 1);
+   u_b = Alloc_grid(m + 1);
+   Init_rod(u_a, m, g_i);
+   u_b[0] = u_b[m] = ICE;
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   pthread_barrier_init(&barrier, NULL, thread_count);
+   if (method == 'c') {
+      red_v = malloc(2*thread_count*sizeof(double));
+      red_w = malloc(2*thread_count*sizeof(double));
+      red_x = malloc(2*thread_count*sizeof(double));
+      red_lu = malloc(4*thread_count*thread_count*sizeof(double));
+   }
+
+   GET_TIME(start);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Heat_work,
+            (void*) thread);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+   GET_TIME(finish);
+
+   if (m <= PRINT_MAX && (k == 0 || n % k != 0))
+      Print_row(n*d, final_u, m);
+   sum = 0.0;
+   for (i = 0; i <= m; i++)
+      sum += final_u[i];
+   /* With m odd, x = 0.5 is halfway between two gridpoints */
+   printf("u(0.5) at t = 1 is %.6f\n", (m % 2 == 0) ? final_u[m/2]
+         : 0.5*(final_u[m/2] + final_u[m/2 + 1]));
+   printf("Sum of temperatures = %.17e\n", sum);
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("%e gridpoint updates per second\n",
+         (double) (m - 1)*n/(finish - start));
+
+   pthread_barrier_destroy(&barrier);
+   if (method == 'c') {
+      free(red_v);
+      free(red_w);
+      free(red_x);
+      free(red_lu);
+   }
+   free(thread_handles);
+   free(u_a);
+   free(u_b);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Summary of how to run program
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> <m> <n> <g|i> "
+         "[k [e|t|c [w s]]]\n", prog_name);
+   fprintf(stderr, "   m:   number of segments on the bar\n");
+   fprintf(stderr, "   n:   number of time steps\n");
+   fprintf(stderr, "  'g':  generate starting temperatures\n");
+   fprintf(stderr, "  'i':  read starting temperatures from stdin\n");
+   fprintf(stderr, "   k:   print temperatures every k steps\n");
+   fprintf(stderr, "  'e':  explicit method (default)\n");
+   fprintf(stderr, "  't':  explicit method, temporally blocked in tiles\n");
+   fprintf(stderr, "        of w points and s steps (default %ld %ld)\n",
+         TILE_W, TILE_S);
+   fprintf(stderr, "  'c':  implicit Crank-Nicolson method\n");
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Get_args
+ * Purpose:   Get and check command line arguments
+ * In args:   argc, argv
+ * Out arg:   g_i_p
+ * Globals:   thread_count, m, n, k, method, tile_w, tile_s (out)
+ */
+void Get_args(int argc, char* argv[], char* g_i_p) {
+   if (argc < 5 || argc == 8 || argc > 9) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   m = strtol(argv[2], NULL, 10);
+   n = strtol(argv[3], NULL, 10);
+   *g_i_p = argv[4][0];
+   k = (argc >= 6) ? strtol(argv[5], NULL, 10) : 0;
+   method = (argc >= 7) ? argv[6][0] : 'e';
+   tile_w = (argc == 9) ? strtol(argv[7], NULL, 10) : TILE_W;
+   tile_s = (argc == 9) ? strtol(argv[8], NULL, 10) : TILE_S;
+
+   if (thread_count <= 0 || m < 2 || n <= 0 || k < 0
+         || (*g_i_p != 'g' && *g_i_p != 'i')
+         || (method != 'e' && method != 't' && method != 'c')
+         || tile_w <= 0 || tile_s <= 0)
+      Usage(argv[0]);
+   if (method == 'c' && thread_count > 1 && m - 1 < 2*thread_count) {
+      fprintf(stderr, "Crank-Nicolson needs at least 2 points per "
+            "thread\n");
+      exit(0);
+   }
+}  /* Get_args */
+
+
+/*------------------------------------------------------------------
+ * Function:    Heat_work
+ * Purpose:     Thread function:  advance this thread's block of the
+ *              rod n time steps
+ * In arg:      rank
+ * Globals:     thread_count, m, n, k, method, tile_w, tile_s, d, r (in)
+ *              u_a, u_b (in/out), final_u (out)
+ */
+void* Heat_work(void* rank) {
+   long    my_rank = (long) rank;
+   long    my_first, my_last, j, steps;
+   double* old_u = u_a;
+   double* new_u = u_b;
+   double* temp;
+   double* tile_a = NULL;
+   double* tile_b = NULL;
+
+   Block_range(my_rank, &my_first, &my_last);
+   if (method == 'c') {
+      Cn_work(my_rank, my_first, my_last);
+      return NULL;
+   }
+   if (method == 't') {
+      tile_a = Alloc_grid(tile_w + 2*tile_s);
+      tile_b = Alloc_grid(tile_w + 2*tile_s);
+   }
+
+   for (j = 0; j < n; j += steps) {
+      if (method == 't') {
+         /* Stop at the next step that's printed */
+         steps = (n - j < tile_s) ? n - j : tile_s;
+         if (k > 0 && k - j % k < steps) steps = k - j % k;
+         Blocked_steps(new_u, old_u, my_first, my_last, steps,
+               tile_a, tile_b);
+      } else {
+         steps = 1;
+         Update_block(new_u, old_u, my_first, my_last, r);
+      }
+      pthread_barrier_wait(&barrier);
+      temp = old_u; old_u = new_u; new_u = temp;
+      if (my_rank == 0 && k > 0 && (j + steps) % k == 0)
+         Print_row((j + steps)*d, old_u, m);
+   }
+
+   if (my_rank == 0) final_u = old_u;
+   free(tile_a);
+   free(tile_b);
+   return NULL;
+}  /* Heat_work */
+
+
+/*------------------------------------------------------------------
+ * Function:    Block_range
+ * Purpose:     Find the interior points [first, last) that belong to
+ *              a thread
+ * In arg:      my_rank
+ * Out args:    first_p, last_p
+ * Globals:     m, thread_count (in)
+ *
+ * Note:        The first (m-1) % thread_count threads get one extra
+ *              point.
+ */
+void Block_range(long my_rank, long* first_p, long* last_p) {
+   long interior = m - 1;
+   long quotient = interior/thread_count;
+   long remainder = interior % thread_count;
+
+   if (my_rank < remainder) {
+      *first_p = 1 + my_rank*(quotient + 1);
+      *last_p = *first_p + quotient + 1;
+   } else {
+      *first_p = 1 + my_rank*quotient + remainder;
+      *last_p = *first_p + quotient;
+   }
+}  /* Block_range */
+
+
+/*------------------------------------------------------------------
+ * Function:    Blocked_steps
+ * Purpose:     Advance points [first, last) steps time steps, one tile
+ *              of at most tile_w points at a time
+ * In args:     old_u, first, last, steps
+ * Out arg:     new_u
+ * Scratch:     tile_a, tile_b:  tile_w + 2*tile_s doubles each
+ * Globals:     m, r, tile_w (in)
+ *
+ * Note:        Index g of the rod is stored at g - base in the tile
+ *              buffers.  Points 0 and m are copied in and never
+ *              updated, so they stay ICE.
+ */
+void Blocked_steps(double* restrict new_u, const double* restrict old_u,
+      long first, long last, long steps, double* tile_a, double* tile_b) {
+   long    lo, hi, base, top, s, u_lo, u_hi;
+   double* src;
+   double* dst;
+   double* temp;
+
+   for (lo = first; lo < last; lo += tile_w) {
+      hi = (lo + tile_w < last) ? lo + tile_w : last;
+      base = (lo - steps > 0) ? lo - steps : 0;
+      top = (hi + steps < m + 1) ? hi + steps : m + 1;
+      memcpy(tile_a, old_u + base, (top - base)*sizeof(double));
+      tile_b[0] = tile_a[0];
+      tile_b[top - base - 1] = tile_a[top - base - 1];
+
+      src = tile_a;
+      dst = tile_b;
+      for (s = 1; s <= steps; s++) {
+         /* Points that are still valid after s steps */
+         u_lo = (lo - steps + s > 1) ? lo - steps + s : 1;
+         u_hi = (hi + steps - s < m) ? hi + steps - s : m;
+         Update_block(dst - base, src - base, u_lo, u_hi, r);
+         temp = src; src = dst; dst = temp;
+      }
+      memcpy(new_u + lo, src + (lo - base), (hi - lo)*sizeof(double));
+   }
+}  /* Blocked_steps */
+
+
+/*------------------------------------------------------------------
+ * Function:    Update_block
+ * Purpose:     Compute the new temperatures at points first..last-1
+ * In args:     old_u, first, last, r
+ * Out arg:     new_u
+ */
+void Update_block(double* restrict new_u, const double* restrict old_u,
+      long first, long last, double r) {
+   long i;
+
+   for (i = first; i < last; i++)
+      new_u[i] = old_u[i] + r*(old_u[i-1] - 2.0*old_u[i] + old_u[i+1]);
+}  /* Update_block */
+
+
+/*------------------------------------------------------------------
+ * Function:    Cn_work
+ * Purpose:     Advance this thread's block of rows n time steps with
+ *              the Crank-Nicolson method (see note 6)
+ * In args:     my_rank, my_first, my_last
+ * Globals:     thread_count, m, n, k, d, r (in), u_a, u_b, red_v,
+ *              red_w, red_x, red_lu (in/out), final_u (out)
+ */
+void Cn_work(long my_rank, long my_first, long my_last) {
+   long    len = my_last - my_first;
+   long    i, j;
+   int     size = 2*thread_count;
+   double  x_left, x_right, half_r = r/2.0;
+   double* old_u = u_a;
+   double* new_u = u_b;
+   double* temp;
+   double* c_prime = malloc(len*sizeof(double));
+   double* mult = malloc(len*sizeof(double));
+   double* b = malloc(len*sizeof(double));
+   double* v = NULL;
+   double* w = NULL;
+
+   Thomas_factor(c_prime, mult, len);
+   if (thread_count > 1) {
+      v = malloc(len*sizeof(double));
+      w = malloc(len*sizeof(double));
+      for (i = 0; i < len; i++)
+         b[i] = 0.0;
+      b[0] = -half_r;
+      Thomas_solve(v, b, c_prime, mult, len);
+      b[0] = 0.0;
+      b[len-1] = -half_r;
+      Thomas_solve(w, b, c_prime, mult, len);
+      red_v[2*my_rank] = v[0];
+      red_v[2*my_rank + 1] = v[len-1];
+      red_w[2*my_rank] = w[0];
+      red_w[2*my_rank + 1] = w[len-1];
+      pthread_barrier_wait(&barrier);
+      if (my_rank == 0) Reduced_factor(red_lu, red_v, red_w, size);
+   }
+
+   for (j = 1; j <= n; j++) {
+      /* Right hand side.  The ends are ICE at both time levels. */
+      for (i = 0; i < len; i++)
+         b[i] = half_r*old_u[my_first+i-1] + (1.0 - r)*old_u[my_first+i]
+            + half_r*old_u[my_first+i+1];
+      if (my_first == 1) b[0] += half_r*ICE;
+      if (my_last == m) b[len-1] += half_r*ICE;
+      Thomas_solve(new_u + my_first, b, c_prime, mult, len);
+
+      if (thread_count > 1) {
+         red_x[2*my_rank] = new_u[my_first];
+         red_x[2*my_rank + 1] = new_u[my_last-1];
+         pthread_barrier_wait(&barrier);
+         if (my_rank == 0) Reduced_solve(red_x, red_lu, size);
+         pthread_barrier_wait(&barrier);
+         x_left = (my_rank > 0) ? red_x[2*my_rank - 1] : 0.0;
+         x_right = (my_rank < thread_count - 1) ? red_x[2*my_rank + 2]
+            : 0.0;
+         for (i = 0; i < len; i++)
+            new_u[my_first+i] -= x_left*v[i] + x_right*w[i];
+      }
+      pthread_barrier_wait(&barrier);
+      temp = old_u; old_u = new_u; new_u = temp;
+      if (my_rank == 0 && k > 0 && j % k == 0)
+         Print_row(j*d, old_u, m);
+   }
+
+   if (my_rank == 0) final_u = old_u;
+   free(c_prime);
+   free(mult);
+   free(b);
+   free(v);
+   free(w);
+}  /* Cn_work */
+
+
+/*------------------------------------------------------------------
+ * Function:    Thomas_factor
+ * Purpose:     Factor the len x len tridiagonal matrix with 1+r on the
+ *              diagonal and -r/2 off it
+ * In arg:      len
+ * Out args:    c_prime:  modified superdiagonal
+ *              mult:  reciprocals of the modified diagonal
+ * Global:      r (in)
+ */
+void Thomas_factor(double c_prime[], double mult[], long len) {
+   double a = -r/2.0, diag = 1.0 + r;
+   long   i;
+
+   mult[0] = 1.0/diag;
+   c_prime[0] = a*mult[0];
+   for (i = 1; i < len; i++) {
+      mult[i] = 1.0/(diag - a*c_prime[i-1]);
+      c_prime[i] = a*mult[i];
+   }
+}  /* Thomas_factor */
+
+
+/*------------------------------------------------------------------
+ * Function:    Thomas_solve
+ * Purpose:     Solve the factored tridiagonal system with right hand
+ *              side b
+ * In args:     b, c_prime, mult, len
+ * Out arg:     x
+ * Global:      r (in)
+ */
+void Thomas_solve(double x[], const double b[], const double c_prime[],
+      const double mult[], long len) {
+   double a = -r/2.0;
+   long   i;
+
+   x[0] = b[0]*mult[0];
+   for (i = 1; i < len; i++)
+      x[i] = (b[i] - a*x[i-1])*mult[i];
+   for (i = len - 2; i >= 0; i--)
+      x[i] -= c_prime[i]*x[i+1];
+}  /* Thomas_solve */
+
+
+/*------------------------------------------------------------------
+ * Function:    Reduced_factor
+ * Purpose:     Build and LU factor the reduced system for the first
+ *              and last rows of the blocks
+ * In args:     v, w, size = 2*thread_count
+ * Out arg:     lu:  size x size, L and U stored in place
+ *
+ * Notes:
+ *    1.  Row 2q (first row of block q) and row 2q+1 (last row) are
+ *           x[2q+e] + v[2q+e]*x[2q-1] + w[2q+e]*x[2q+2] = y[2q+e]
+ *        where x[2q-1] is the last row of block q-1 and x[2q+2] the
+ *        first row of block q+1 (dropped at the ends of the rod).
+ *    2.  The matrix comes from a diagonally dominant one, so we don't
+ *        pivot.
+ */
+void Reduced_factor(double lu[], const double v[], const double w[],
+      int size) {
+   int row, col, i, q;
+
+   for (i = 0; i < size*size; i++)
+      lu[i] = 0.0;
+   for (row = 0; row < size; row++) {
+      q = row/2;
+      lu[row*size + row] = 1.0;
+      if (q > 0) lu[row*size + 2*q - 1] = v[row];
+      if (q < size/2 - 1) lu[row*size + 2*q + 2] = w[row];
+   }
+
+   for (col = 0; col < size; col++)
+      for (row = col + 1; row < size; row++) {
+         lu[row*size + col] /= lu[col*size + col];
+         for (i = col + 1; i < size; i++)
+            lu[row*size + i] -= lu[row*size + col]*lu[col*size + i];
+      }
+}  /* Reduced_factor */
+
+
+/*------------------------------------------------------------------
+ * Function:    Reduced_solve
+ * Purpose:     Solve the reduced system with the LU factors from
+ *              Reduced_factor
+ * In args:     lu, size
+ * In/out arg:  x:  in y, out the solution
+ */
+void Reduced_solve(double x[], const double lu[], int size) {
+   int row, i;
+
+   for (row = 1; row < size; row++)
+      for (i = 0; i < row; i++)
+         x[row] -= lu[row*size + i]*x[i];
+   for (row = size - 1; row >= 0; row--) {
+      for (i = row + 1; i < size; i++)
+         x[row] -= lu[row*size + i]*x[i];
+      x[row] /= lu[row*size + row];
+   }
+}  /* Reduced_solve */
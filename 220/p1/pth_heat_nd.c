@@ -0,0 +1,389 @@
+/* File:    pth_heat_nd.c
+ * Author:  Cayla Shaver
+ * Purpose: Calculate the temperature at gridpoints of an insulated
+ *          square plate (2D) or cube (3D) with ice on the boundary,
+ *          using Pthreads.  This is p1.c with a 5-point (2D) or
+ *          7-point (3D) stencil, and a report of how close the sweep
+ *          gets to the memory bandwidth of the machine.
+ *
+ * Compile: gcc -g -Wall -O3 -march=native -I.. -o pth_heat_nd
+ *             pth_heat_nd.c heat_setup.c -lpthread -lm
+ * Usage:   pth_heat_nd <thread_count> <2|3> <m> <n> [tile [peak]]
+ *             2|3:  number of dimensions
+ *             m:    number of segments on each side
+ *             n:    number of segments of time
+ *             tile: width of the cache blocks in the inner dimensions
+ *                   (default TILE)
+ *             peak: peak memory bandwidth in GB/s.  If it's omitted
+ *                   it's measured with a STREAM triad.
+ *
+ * Input:   None
+ * Output:  The temperature at the center at t = 1, the sum of the
+ *          temperatures, the elapsed time, and a roofline report:
+ *          GFLOP/s, GB/s, arithmetic intensity and the fraction of
+ *          peak bandwidth the sweep achieved.
+ *
+ * Notes:
+ *    1.  The grid has (m+1)^dims points, stored row-major in one
+ *        array:  u[(i*(m+1) + j)*(m+1) + k] in 3D.  Points on the
+ *        boundary are ICE.  The starting temperatures are the product
+ *        of Init_temp in each coordinate.
+ *    2.  Each thread owns a slab of consecutive rows (2D) or planes
+ *        (3D).  The threads meet at a barrier once per time step and
+ *        the grids are swapped.
+ *    3.  The sweep over a slab is cache blocked:  the inner dimensions
+ *        are done tile points at a time, so the rows (or planes) the
+ *        stencil reads are still in cache when they're reused.  The
+ *        innermost loop is contiguous and uses restrict pointers so
+ *        it vectorizes.
+ *    4.  Traffic is counted like STREAM:  each update reads one
+ *        double and writes one, 16 bytes, and does FLOPS_2D or
+ *        FLOPS_3D flops.  So the sweep is bandwidth bound on any
+ *        current machine, and the fraction of triad bandwidth it
+ *        reaches is the fraction of the roofline it reaches.  Grids
+ *        that fit in cache can go over 100%.
+ *    5.  The method is only stable if d/(h*h) <= 1/(2*dims).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "timer.h"
+#include "heat_setup.h"
+
+const long TILE = 256;
+const long STREAM_N = 1 << 24;
+const int  STREAM_REPS = 10;
+const double FLOPS_2D = 7.0;
+const double FLOPS_3D = 9.0;
+const double BYTES_PER_UPDATE = 16.0;
+
+/* Global variables:  shared by the threads */
+int     thread_count;
+int     dims;
+long    m;
+long    n;
+long    tile;
+double  r;
+double* u_a;
+double* u_b;
+double* final_u;
+double* s_a;
+double* s_b;
+double* s_c;
+double  triad_time;
+pthread_barrier_t barrier;
+
+void  Usage(char* prog_name);
+void  Get_args(int argc, char* argv[], double* peak_p);
+void  Init_grid(double u[]);
+void  Slab_range(long my_rank, long* first_p, long* last_p);
+void* Heat_work(void* rank);
+void  Update_2d(double* restrict new_u, const double* restrict old_u,
+      long first, long last);
+void  Update_3d(double* restrict new_u, const double* restrict old_u,
+      long first, long last);
+double Measure_bandwidth(void);
+void* Triad_work(void* rank);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long       thread, i, points, interior, side;
+   pthread_t* thread_handles;
+   double     start, finish, elapsed, peak, sum, flops, bytes, gbs;
+
+   Get_args(argc, argv, &peak);
+   side = m + 1;
+   r = (1.0/n)*m*m;
+   if (r > 0.5/dims)
+      fprintf(stderr, "Warning: d/(h*h) = %f > %f, the method is "
+            "unstable\n", r, 0.5/dims);
+
+   points = (dims == 2) ? side*side : side*side*side;
+   interior = (dims == 2) ? (m - 1)*(m - 1) : (m - 1)*(m - 1)*(m - 1);
+   u_a = Alloc_grid(points);
+   u_b = Alloc_grid(points);
+   Init_grid(u_a);
+   for (i = 0; i < points; i++)
+      u_b[i] = u_a[i];
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   pthread_barrier_init(&barrier, NULL, thread_count);
+   if (peak <= 0.0) peak = Measure_bandwidth();
+
+   GET_TIME(start);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Heat_work,
+            (void*) thread);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+   GET_TIME(finish);
+   elapsed = finish - start;
+
+   sum = 0.0;
+   for (i = 0; i < points; i++)
+      sum += final_u[i];
+   i = (dims == 2) ? (m/2)*side + m/2 : ((m/2)*side + m/2)*side + m/2;
+   printf("u(center) at t = 1 is %.6e\n", final_u[i]);
+   printf("Sum of temperatures = %.17e\n", sum);
+   printf("Elapsed time = %e seconds\n", elapsed);
+
+   flops = ((dims == 2) ? FLOPS_2D : FLOPS_3D)*interior*n;
+   bytes = BYTES_PER_UPDATE*interior*n;
+   gbs = bytes/elapsed/1.0e9;
+   printf("Roofline report (%dD, %d threads, tile = %ld):\n", dims,
+         thread_count, tile);
+   printf("   arithmetic intensity = %.3f flop/byte\n", flops/bytes);
+   printf("   achieved             = %.3f GFLOP/s, %.3f GB/s\n",
+         flops/elapsed/1.0e9, gbs);
+   printf("   peak bandwidth       = %.3f GB/s\n", peak);
+   printf("   bandwidth bound      = %.3f GFLOP/s\n", peak*flops/bytes);
+   printf("   fraction of bound    = %.1f%%\n", 100.0*gbs/peak);
+
+   pthread_barrier_destroy(&barrier);
+   free(thread_handles);
+   free(u_a);
+   free(u_b);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Summary of how to run program
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> <2|3> <m> <n> [tile [peak]]\n",
+         prog_name);
+   fprintf(stderr, "   2|3:  number of dimensions\n");
+   fprintf(stderr, "   m:    number of segments on each side\n");
+   fprintf(stderr, "   n:    number of time steps\n");
+   fprintf(stderr, "   tile: cache block width (default %ld)\n", TILE);
+   fprintf(stderr, "   peak: peak bandwidth in GB/s (default: measure)\n");
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Get_args
+ * Purpose:   Get and check command line arguments
+ * In args:   argc, argv
+ * Out arg:   peak_p:  0 if it should be measured
+ * Globals:   thread_count, dims, m, n, tile (out)
+ */
+void Get_args(int argc, char* argv[], double* peak_p) {
+   if (argc < 5 || argc > 7) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   dims = strtol(argv[2], NULL, 10);
+   m = strtol(argv[3], NULL, 10);
+   n = strtol(argv[4], NULL, 10);
+   tile = (argc >= 6) ? strtol(argv[5], NULL, 10) : TILE;
+   *peak_p = (argc == 7) ? strtod(argv[6], NULL) : 0.0;
+
+   if (thread_count <= 0 || (dims != 2 && dims != 3) || m < 2 || n <= 0
+         || tile <= 0)
+      Usage(argv[0]);
+}  /* Get_args */
+
+
+/*------------------------------------------------------------------
+ * Function:  Init_grid
+ * Purpose:   Set the starting temperatures:  the product of
+ *            Init_temp in each coordinate, and ICE on the boundary
+ * Out arg:   u
+ * Globals:   dims, m (in)
+ */
+void Init_grid(double u[]) {
+   long    side = m + 1, i, j, k;
+   double* t = malloc(side*sizeof(double));
+
+   for (i = 0; i <= m; i++)
+      t[i] = Init_temp((double) i/m)/100.0;
+   t[0] = t[m] = 0.0;
+
+   for (i = 0; i <= m; i++)
+      for (j = 0; j <= m; j++)
+         if (dims == 2) {
+            u[i*side + j] = 100.0*t[i]*t[j];
+            if (t[i] == 0.0 || t[j] == 0.0) u[i*side + j] = ICE;
+         } else {
+            for (k = 0; k <= m; k++) {
+               u[(i*side + j)*side + k] = 100.0*t[i]*t[j]*t[k];
+               if (t[i] == 0.0 || t[j] == 0.0 || t[k] == 0.0)
+                  u[(i*side + j)*side + k] = ICE;
+            }
+         }
+   free(t);
+}  /* Init_grid */
+
+
+/*------------------------------------------------------------------
+ * Function:    Slab_range
+ * Purpose:     Find the interior rows or planes [first, last) that
+ *              belong to a thread
+ * In arg:      my_rank
+ * Out args:    first_p, last_p
+ * Globals:     m, thread_count (in)
+ */
+void Slab_range(long my_rank, long* first_p, long* last_p) {
+   long interior = m - 1;
+   long quotient = interior/thread_count;
+   long remainder = interior % thread_count;
+
+   if (my_rank < remainder) {
+      *first_p = 1 + my_rank*(quotient + 1);
+      *last_p = *first_p + quotient + 1;
+   } else {
+      *first_p = 1 + my_rank*quotient + remainder;
+      *last_p = *first_p + quotient;
+   }
+}  /* Slab_range */
+
+
+/*------------------------------------------------------------------
+ * Function:    Heat_work
+ * Purpose:     Thread function:  advance this thread's slab n time
+ *              steps
+ * In arg:      rank
+ * Globals:     dims, n (in), u_a, u_b (in/out), final_u (out)
+ */
+void* Heat_work(void* rank) {
+   long    my_rank = (long) rank;
+   long    my_first, my_last, j;
+   double* old_u = u_a;
+   double* new_u = u_b;
+   double* temp;
+
+   Slab_range(my_rank, &my_first, &my_last);
+   for (j = 1; j <= n; j++) {
+      if (dims == 2)
+         Update_2d(new_u, old_u, my_first, my_last);
+      else
+         Update_3d(new_u, old_u, my_first, my_last);
+      pthread_barrier_wait(&barrier);
+      temp = old_u; old_u = new_u; new_u = temp;
+   }
+
+   if (my_rank == 0) final_u = old_u;
+   return NULL;
+}  /* Heat_work */
+
+
+/*------------------------------------------------------------------
+ * Function:    Update_2d
+ * Purpose:     Apply the 5-point stencil to rows [first, last),
+ *              tile columns at a time
+ * In args:     old_u, first, last
+ * Out arg:     new_u
+ * Globals:     m, r, tile (in)
+ */
+void Update_2d(double* restrict new_u, const double* restrict old_u,
+      long first, long last) {
+   long side = m + 1;
+   long i, jj, j, j_end, c;
+
+   for (jj = 1; jj < m; jj += tile) {
+      j_end = (jj + tile < m) ? jj + tile : m;
+      for (i = first; i < last; i++) {
+         c = i*side;
+         for (j = jj; j < j_end; j++)
+            new_u[c+j] = old_u[c+j] + r*(old_u[c+j-side] + old_u[c+j+side]
+                  + old_u[c+j-1] + old_u[c+j+1] - 4.0*old_u[c+j]);
+      }
+   }
+}  /* Update_2d */
+
+
+/*------------------------------------------------------------------
+ * Function:    Update_3d
+ * Purpose:     Apply the 7-point stencil to planes [first, last),
+ *              in tile x tile blocks of each plane
+ * In args:     old_u, first, last
+ * Out arg:     new_u
+ * Globals:     m, r, tile (in)
+ */
+void Update_3d(double* restrict new_u, const double* restrict old_u,
+      long first, long last) {
+   long side = m + 1, plane = side*side;
+   long i, jj, kk, j, k, j_end, k_end, c;
+
+   for (jj = 1; jj < m; jj += tile) {
+      j_end = (jj + tile < m) ? jj + tile : m;
+      for (kk = 1; kk < m; kk += tile) {
+         k_end = (kk + tile < m) ? kk + tile : m;
+         for (i = first; i < last; i++)
+            for (j = jj; j < j_end; j++) {
+               c = i*plane + j*side;
+               for (k = kk; k < k_end; k++)
+                  new_u[c+k] = old_u[c+k] + r*(old_u[c+k-plane]
+                        + old_u[c+k+plane] + old_u[c+k-side]
+                        + old_u[c+k+side] + old_u[c+k-1] + old_u[c+k+1]
+                        - 6.0*old_u[c+k]);
+            }
+      }
+   }
+}  /* Update_3d */
+
+
+/*------------------------------------------------------------------
+ * Function:    Measure_bandwidth
+ * Purpose:     Estimate the peak memory bandwidth with a threaded
+ *              STREAM triad, a[i] = b[i] + s*c[i]
+ * Return val:  bandwidth in GB/s, counting 24 bytes per element
+ * Globals:     thread_count (in), s_a, s_b, s_c, triad_time (out)
+ */
+double Measure_bandwidth(void) {
+   pthread_t* thread_handles = malloc(thread_count*sizeof(pthread_t));
+   long       thread;
+
+   s_a = Alloc_grid(STREAM_N);
+   s_b = Alloc_grid(STREAM_N);
+   s_c = Alloc_grid(STREAM_N);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Triad_work,
+            (void*) thread);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+
+   free(s_a);
+   free(s_b);
+   free(s_c);
+   free(thread_handles);
+   return 24.0*STREAM_N*STREAM_REPS/triad_time/1.0e9;
+}  /* Measure_bandwidth */
+
+
+/*------------------------------------------------------------------
+ * Function:    Triad_work
+ * Purpose:     Thread function:  initialize this thread's block of the
+ *              STREAM arrays, then run the triad on it STREAM_REPS
+ *              times.  Thread 0 times the triads.
+ * In arg:      rank
+ */
+void* Triad_work(void* rank) {
+   long   my_rank = (long) rank;
+   long   first = my_rank*STREAM_N/thread_count;
+   long   last = (my_rank + 1)*STREAM_N/thread_count;
+   long   i;
+   int    rep;
+   double start = 0.0, finish;
+   double* restrict a = s_a;
+   const double* restrict b = s_b;
+   const double* restrict c = s_c;
+
+   for (i = first; i < last; i++) {
+      s_a[i] = 0.0;
+      s_b[i] = 1.0;
+      s_c[i] = 2.0;
+   }
+   pthread_barrier_wait(&barrier);
+   if (my_rank == 0) GET_TIME(start);
+   for (rep = 0; rep < STREAM_REPS; rep++)
+      for (i = first; i < last; i++)
+         a[i] = b[i] + 3.0*c[i];
+   pthread_barrier_wait(&barrier);
+   if (my_rank == 0) {
+      GET_TIME(finish);
+      triad_time = finish - start;
+   }
+   return NULL;
+}  /* Triad_work */
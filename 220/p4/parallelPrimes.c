@@ -7,21 +7,29 @@
  * Input:    n:  integer >= 2 (from command line)
  * Output:   Sorted list of primes between 2 and n,
  *
- * Compile:  mpicc -g -Wall -o p p4.c -lm
+ * Compile:  mpicc -g -Wall -I.. -o p parallelPrimes.c ../hier.c -lm
  * Usage:    mpiexec -n 4 p 10
  *              n:  max int to test for primality
  *
+ * Notes:
+ *    1.  Global_List is node-aware:  the lists of the processes on a
+ *        node are gathered onto the node's leader in shared memory
+ *        (../hier.c), and only the leaders take part in the tree
+ *        structured merge.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <mpi.h>
+#include "hier.h"
 
 
 int Is_prime(int i);
 void Merge(int** master, int* master_count, int your_primeHolder[], int recv_count, int** temp);
-void Global_List(int** master, int c, int my_rank, int p, int n, MPI_Comm comm, int tpc);
+void Global_List(int** master, int c, MPI_Comm comm, int* tpc_p);
+void Tree_merge(int** my_primeHolder, int c, int my_rank, int p, MPI_Comm comm, int tpc);
+int  Cmp_int(const void* a, const void* b);
 void Print_master_list(int master[], int total);
 
 
@@ -43,20 +51,21 @@ int main(int argc, char* argv[]) {
    }
    MPI_Bcast(&n, 1, MPI_INT, 0, comm);
 
-   max = n / (2 * p) + 2;
+   max = n / (2 * p) + 3;
 
    primeHolder = malloc(max *sizeof(int));
-   for (i = 2 * my_rank + 3; i < n; i += 2 * p){
+   if (my_rank == 0 && n >= 2)
+      primeHolder[count++] = 2;
+   for (i = 2 * my_rank + 3; i <= n; i += 2 * p){
      if (Is_prime(i)){
-         primeHolder[count] += i;
+         primeHolder[count] = i;
          count += 1;
      } 
    }
 
 
      
-   Global_List(&primeHolder, count, my_rank, p, n, comm,
-         total_prime_count);
+   Global_List(&primeHolder, count, comm, &total_prime_count);
    
 
    if (my_rank == 0)
@@ -131,29 +140,66 @@ void Merge(int** master, int* curr_m_size, int your_primeHolder[], int your_size
  * Input args:
  *    my_primeHolder:  the calling process' list of prime #s
  *    c: 		size of my_primeHolder
- *    my_rank:     the calling process' rank in the communicator
- *    p:           the number of processes in the communicator
  *    comm:        the communicator used for sends and receives
- *    tpc:			the total prime counter
+ * Output arg:
+ *    tpc_p:			the total prime count
+ *
+ * Algorithm:  Gather the lists on each node onto its leader in shared
+ *    memory and sort them, then merge the leaders' lists with
+ *    Tree_merge.  Process 0 is always a leader, so the master list
+ *    ends up in *my_primeHolder on process 0.
+ */
+
+void Global_List(int** my_primeHolder, int c, MPI_Comm comm, int* tpc_p) {
+    hier_t h;
+    int* node_list;
+    int node_count, leader_rank;
+
+    MPI_Allreduce(&c, tpc_p, 1, MPI_INT, MPI_SUM, comm);
+
+    Hier_create(&h, comm);
+    node_count = Hier_node_gatherv_int(&h, *my_primeHolder, c, &node_list);
+    if (h.leaders != MPI_COMM_NULL) {
+        qsort(node_list, node_count, sizeof(int), Cmp_int);
+        free(*my_primeHolder);
+        *my_primeHolder = realloc(node_list, (*tpc_p + 1)*sizeof(int));
+        MPI_Comm_rank(h.leaders, &leader_rank);
+        Tree_merge(my_primeHolder, node_count, leader_rank, h.num_nodes,
+              h.leaders, *tpc_p);
+    }
+    Hier_free(&h);
+    /* Valid only on 0 */
+
+}  /* Global_List */
+
+
+/*---------------------------------------------------------------
+ * Function:  Tree_merge
+ * Purpose:   Merge the sorted lists of the processes in comm onto
+ *            process 0
+ * Input args:
+ *    c:           size of my_primeHolder
+ *    my_rank, p, comm:  the usual MPI values
+ *    tpc:         the total prime count
+ * In/out arg:
+ *    my_primeHolder:  the calling process' list, with room for tpc
+ *                 ints.  The merged list on process 0.
  *
  * Algorithm:  Use tree structured communication, pairing processes
  *    to communicate.           
  */
-
-void Global_List(int** my_primeHolder, int c, int my_rank, int p, int n, MPI_Comm comm, int tpc) {
+void Tree_merge(int** my_primeHolder, int c, int my_rank, int p, MPI_Comm comm, int tpc) {
     int partner, recv_count;
     int* your_primeHolder;
     int* temp;
+    int* swap;
     int done = 0;
     unsigned bitmask = (unsigned) 1;
     int curr_master_size = c;
     MPI_Status status;
 
-
-
-    MPI_Allreduce(&curr_master_size, &tpc, 1, MPI_INT, MPI_SUM, comm);
-    your_primeHolder = malloc(tpc*sizeof(int));
-    temp = malloc(tpc*sizeof(int));
+    your_primeHolder = malloc((tpc + 1)*sizeof(int));
+    temp = malloc((tpc + 1)*sizeof(int));
 
 #   ifdef DEBUG
     int my_pass = -1;
@@ -162,10 +208,6 @@ void Global_List(int** my_primeHolder, int c, int my_rank, int p, int n, MPI_Com
         my_rank, partner, bitmask, my_pass);
     fflush(stdout);
 #   endif
-    //for (i = 0; i < c; i++)
-       //master[i] = my_primeHolder[i];
-
-
 
     while (!done && bitmask < p) {
         partner = my_rank ^ bitmask;
@@ -184,10 +226,13 @@ void Global_List(int** my_primeHolder, int c, int my_rank, int p, int n, MPI_Com
 
                 Merge(my_primeHolder, &curr_master_size, your_primeHolder, recv_count, &temp);
                 curr_master_size += recv_count;
+                swap = *my_primeHolder;
+                *my_primeHolder = temp;
+                temp = swap;
             }
             bitmask <<= 1;
         } else {
-            MPI_Send(my_primeHolder, tpc, MPI_INT, partner, 0, comm); //master total size or tpc
+            MPI_Send(*my_primeHolder, curr_master_size, MPI_INT, partner, 0, comm);
             done = 1;
         }
 
@@ -195,9 +240,18 @@ void Global_List(int** my_primeHolder, int c, int my_rank, int p, int n, MPI_Com
 
     free(temp);
     free(your_primeHolder);
-    /* Valid only on 0 */
+}  /* Tree_merge */
 
-}  /* Global_List */
+
+/*-------------------------------------------------------------------
+ * Function:   Cmp_int
+ * Purpose:    Compare two ints for qsort
+ */
+int Cmp_int(const void* a, const void* b) {
+   int x = *(const int*) a, y = *(const int*) b;
+
+   return (x > y) - (x < y);
+}  /* Cmp_int */
 
 
 /*-------------------------------------------------------------------
@@ -208,7 +262,7 @@ void Global_List(int** my_primeHolder, int c, int my_rank, int p, int n, MPI_Com
 void Print_master_list(int master[], int total){
   int i;
 
-  for(i = 0; i <= total; i ++){
+  for(i = 0; i < total; i ++){
     printf("%d\n", master[i]);
   }
 }  /* Print_master_list */
@@ -0,0 +1,618 @@
+/* File:     ext_sort.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Sort a binary file of ints that may be much larger than
+ *           memory (external merge sort).
+ *
+ * Compile:  gcc -g -Wall -O2 -I.. -o ext_sort ext_sort.c pth_bitonic.c
+ *              ../numa_rt.c -lpthread
+ * Usage:    ext_sort <thread_count> <run keys> <fan in> <in file>
+ *              <out file> [tmp dir]
+ *              thread_count:  threads used to sort each run
+ *              run keys:  number of keys sorted in memory at once
+ *              fan in:    maximum number of runs merged at once
+ *              tmp dir:   where runs are stored (default ".")
+ *           ext_sort g <n> <file>
+ *              write n random keys to file
+ *           ext_sort c <file>
+ *              check that file is sorted
+ *
+ * Input:    A file of native ints (4 bytes each, no header)
+ * Output:   The same keys, in increasing order, in out file.  Times
+ *           for the run and merge phases are printed on stdout.
+ *
+ * Algorithm:
+ *    1.  Run phase:  read the input run keys at a time, sort each
+ *        block with Pth_bitonic_sort, and append it to a temporary
+ *        file as a sorted run.
+ *    2.  Merge phase:  while there are more than fan in runs, merge
+ *        groups of fan in runs into longer runs in a second temporary
+ *        file.  The last pass merges into the output file.  Each
+ *        merge picks the next key with a loser tree, so it costs
+ *        about log2(k) comparisons per key for k runs.
+ *    3.  All file I/O goes through double-buffered readers and
+ *        writers (Reader_next, Writer_put).  While the caller works
+ *        on one buffer, a helper thread reads or writes the other,
+ *        so reading, sorting/merging and writing overlap.
+ *
+ * Notes:
+ *    1.  Memory use is about 6*run keys ints in the run phase (two
+ *        read buffers, two write buffers and the two sort buffers)
+ *        and about 2*(fan in + 1)*block ints in the merge phase,
+ *        where block = run keys/(fan in + 1).
+ *    2.  The temporary files are unlinked as soon as they're opened,
+ *        so they disappear even if the program is killed.
+ */
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "timer.h"
+#include "pth_bitonic.h"
+
+const int RMAX = 1000000000;
+const long long EXHAUSTED = LLONG_MAX;
+const size_t MIN_BLOCK = 4096;
+
+/* Double-buffered reader for keys [first, first+count) of a file */
+typedef struct {
+   int       fd;
+   off_t     next_off;   /* Byte offset of the next read          */
+   long long left;       /* Keys not yet handed to a read thread  */
+   int*      buf[2];
+   size_t    count[2];   /* Keys in each buffer                   */
+   size_t    cap;        /* Capacity of each buffer               */
+   int       fill;       /* Buffer the read thread is filling     */
+   int       pending;    /* Is a read thread running?             */
+   pthread_t thread;
+} reader_t;
+
+/* Double-buffered writer that appends to a file */
+typedef struct {
+   int       fd;
+   off_t     next_off;
+   int*      buf[2];
+   size_t    count;      /* Keys in the buffer being filled       */
+   size_t    cap;
+   int       cur;        /* Buffer the caller is filling          */
+   int*      w_buf;      /* Buffer the write thread is writing    */
+   size_t    w_count;
+   off_t     w_off;
+   int       pending;
+   pthread_t thread;
+} writer_t;
+
+/* A sorted run in a temporary file */
+typedef struct {
+   off_t     first;      /* Index of the first key in the file    */
+   long long count;
+} run_t;
+
+void Usage(char* prog_name);
+void Generate_file(long long n, char* name);
+void Check_file(char* name);
+int  Open_temp(char* dir);
+void Full_pread(int fd, void* buf, size_t bytes, off_t off);
+void Full_pwrite(int fd, void* buf, size_t bytes, off_t off);
+
+void  Reader_init(reader_t* r, int fd, off_t first, long long count,
+      size_t cap);
+int*  Reader_next(reader_t* r, size_t* count_p);
+void  Reader_free(reader_t* r);
+void* Read_work(void* reader);
+void  Writer_init(writer_t* w, int fd, off_t first, size_t cap);
+void  Writer_put(writer_t* w);
+void  Writer_close(writer_t* w);
+void* Write_work(void* writer);
+
+int  Make_runs(int in_fd, int run_fd, int thread_count, size_t run_keys,
+      run_t** runs_p, long long* n_p);
+void Merge_runs(int in_fd, run_t runs[], int k, int out_fd, off_t out_first,
+      size_t block);
+void Adjust(int tree[], long long key[], int k, int s);
+
+/*------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int       thread_count, fan_in, in_fd, out_fd, tmp_fd[2], src, dst;
+   int       run_count, new_count, i, k, fd;
+   size_t    run_keys, block;
+   long long n, merged;
+   run_t*    runs;
+   run_t*    new_runs;
+   char*     tmp_dir = ".";
+   double    start, mid, finish;
+
+   if (argc == 4 && argv[1][0] == 'g') {
+      Generate_file(strtoll(argv[2], NULL, 10), argv[3]);
+      return 0;
+   } else if (argc == 3 && argv[1][0] == 'c') {
+      Check_file(argv[2]);
+      return 0;
+   } else if (argc != 6 && argc != 7) {
+      Usage(argv[0]);
+   }
+   thread_count = strtol(argv[1], NULL, 10);
+   run_keys = strtoll(argv[2], NULL, 10);
+   fan_in = strtol(argv[3], NULL, 10);
+   if (argc == 7) tmp_dir = argv[6];
+   if (thread_count <= 0 || run_keys < 2 || run_keys > INT_MAX || fan_in < 2)
+      Usage(argv[0]);
+
+   in_fd = open(argv[4], O_RDONLY);
+   out_fd = open(argv[5], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (in_fd < 0 || out_fd < 0) {
+      fprintf(stderr, "Can't open %s or %s\n", argv[4], argv[5]);
+      exit(1);
+   }
+   tmp_fd[0] = Open_temp(tmp_dir);
+   tmp_fd[1] = Open_temp(tmp_dir);
+
+   GET_TIME(start);
+   run_count = Make_runs(in_fd, tmp_fd[0], thread_count, run_keys, &runs,
+         &n);
+   GET_TIME(mid);
+   printf("Run phase:   %d runs of <= %zu keys, %e seconds\n", run_count,
+         run_keys, mid - start);
+
+   /* Merge passes.  The last one writes the output file. */
+   src = 0;
+   dst = 1;
+   block = run_keys/(fan_in + 1);
+   if (block < MIN_BLOCK) block = MIN_BLOCK;
+   new_runs = malloc(((run_count + fan_in - 1)/fan_in)*sizeof(run_t));
+   do {
+      new_count = 0;
+      merged = 0;
+      fd = (run_count <= fan_in) ? out_fd : tmp_fd[dst];
+      for (i = 0; i < run_count; i += fan_in) {
+         k = (run_count - i < fan_in) ? run_count - i : fan_in;
+         new_runs[new_count].first = merged;
+         new_runs[new_count].count = 0;
+         Merge_runs(tmp_fd[src], runs + i, k, fd, merged, block);
+         for (; k > 0; k--)
+            new_runs[new_count].count += runs[i + k - 1].count;
+         merged += new_runs[new_count].count;
+         new_count++;
+      }
+      memcpy(runs, new_runs, new_count*sizeof(run_t));
+      run_count = new_count;
+      src = 1 - src;
+      dst = 1 - dst;
+   } while (fd != out_fd);
+   GET_TIME(finish);
+   printf("Merge phase: %lld keys, %e seconds\n", n, finish - mid);
+   printf("Total:       %e seconds\n", finish - start);
+
+   free(runs);
+   free(new_runs);
+   close(tmp_fd[0]);
+   close(tmp_fd[1]);
+   close(in_fd);
+   close(out_fd);
+   return 0;
+}  /* main */
+
+
+/*------------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   print a message showing what the command line should
+ *            be, and terminate
+ * In arg :   prog_name
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> <run keys> <fan in> "
+         "<in file> <out file> [tmp dir]\n", prog_name);
+   fprintf(stderr, "       %s g <n> <file>   (generate n random keys)\n",
+         prog_name);
+   fprintf(stderr, "       %s c <file>       (check file is sorted)\n",
+         prog_name);
+   exit(0);
+}  /* Usage */
+
+
+/*------------------------------------------------------------------
+ * Function:  Generate_file
+ * Purpose:   Write n random ints to a file
+ * In args:   n, name
+ */
+void Generate_file(long long n, char* name) {
+   writer_t  w;
+   long long i;
+   int       fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+   if (fd < 0) {
+      fprintf(stderr, "Can't open %s\n", name);
+      exit(1);
+   }
+   srandom(1);
+   Writer_init(&w, fd, 0, 1 << 20);
+   for (i = 0; i < n; i++) {
+      w.buf[w.cur][w.count++] = random() % RMAX;
+      if (w.count == w.cap) Writer_put(&w);
+   }
+   Writer_close(&w);
+   close(fd);
+}  /* Generate_file */
+
+
+/*------------------------------------------------------------------
+ * Function:  Check_file
+ * Purpose:   Check whether the ints in a file are in increasing
+ *            order and print the result
+ * In arg:    name
+ */
+void Check_file(char* name) {
+   reader_t  r;
+   int*      buf;
+   size_t    count, i;
+   long long n, seen = 0, bad = 0;
+   long long prev = LLONG_MIN;
+   int       fd = open(name, O_RDONLY);
+
+   if (fd < 0) {
+      fprintf(stderr, "Can't open %s\n", name);
+      exit(1);
+   }
+   n = lseek(fd, 0, SEEK_END)/sizeof(int);
+   Reader_init(&r, fd, 0, n, 1 << 20);
+   while ((buf = Reader_next(&r, &count)) != NULL) {
+      for (i = 0; i < count; i++) {
+         if (buf[i] < prev) bad++;
+         prev = buf[i];
+      }
+      seen += count;
+   }
+   Reader_free(&r);
+   close(fd);
+   printf("%s: %lld keys, %s\n", name, seen,
+         bad ? "NOT sorted" : "sorted");
+}  /* Check_file */
+
+
+/*------------------------------------------------------------------
+ * Function:    Open_temp
+ * Purpose:     Create and open a temporary file in dir, and unlink it
+ * In arg:      dir
+ * Return val:  file descriptor
+ */
+int Open_temp(char* dir) {
+   char name[PATH_MAX];
+   int  fd;
+
+   snprintf(name, PATH_MAX, "%s/ext_sort.XXXXXX", dir);
+   fd = mkstemp(name);
+   if (fd < 0) {
+      fprintf(stderr, "Can't create temporary file in %s\n", dir);
+      exit(1);
+   }
+   unlink(name);
+   return fd;
+}  /* Open_temp */
+
+
+/*------------------------------------------------------------------
+ * Function:  Full_pread, Full_pwrite
+ * Purpose:   pread/pwrite exactly bytes bytes at offset off, retrying
+ *            short transfers.  Quit on an error.
+ */
+void Full_pread(int fd, void* buf, size_t bytes, off_t off) {
+   ssize_t got;
+
+   while (bytes > 0) {
+      got = pread(fd, buf, bytes, off);
+      if (got <= 0) {
+         fprintf(stderr, "Read failed at byte %lld\n", (long long) off);
+         exit(1);
+      }
+      buf = (char*) buf + got;
+      bytes -= got;
+      off += got;
+   }
+}  /* Full_pread */
+
+void Full_pwrite(int fd, void* buf, size_t bytes, off_t off) {
+   ssize_t put;
+
+   while (bytes > 0) {
+      put = pwrite(fd, buf, bytes, off);
+      if (put <= 0) {
+         fprintf(stderr, "Write failed at byte %lld\n", (long long) off);
+         exit(1);
+      }
+      buf = (char*) buf + put;
+      bytes -= put;
+      off += put;
+   }
+}  /* Full_pwrite */
+
+
+/*------------------------------------------------------------------
+ * Function:  Reader_init
+ * Purpose:   Set up a reader for count keys starting at key first,
+ *            and start reading the first buffer
+ * In args:   fd, first, count, cap
+ * Out arg:   r
+ */
+void Reader_init(reader_t* r, int fd, off_t first, long long count,
+      size_t cap) {
+   r->fd = fd;
+   r->next_off = first*sizeof(int);
+   r->left = count;
+   r->cap = cap;
+   r->buf[0] = malloc(cap*sizeof(int));
+   r->buf[1] = malloc(cap*sizeof(int));
+   r->count[0] = r->count[1] = 0;
+   r->fill = 0;
+   r->pending = 0;
+   if (r->left > 0) {
+      r->pending = 1;
+      pthread_create(&r->thread, NULL, Read_work, r);
+   }
+}  /* Reader_init */
+
+
+/*------------------------------------------------------------------
+ * Function:    Reader_next
+ * Purpose:     Wait for the buffer that's being read, start reading
+ *              the other one, and return the full one
+ * In/out arg:  r
+ * Out arg:     count_p:  number of keys in the returned buffer
+ * Return val:  the buffer, or NULL if there are no more keys
+ *
+ * Note:        The returned buffer is valid until the next call.
+ */
+int* Reader_next(reader_t* r, size_t* count_p) {
+   int full;
+
+   if (!r->pending) return NULL;
+   pthread_join(r->thread, NULL);
+   full = r->fill;
+   *count_p = r->count[full];
+
+   r->fill = 1 - full;
+   r->pending = 0;
+   if (r->left > 0) {
+      r->pending = 1;
+      pthread_create(&r->thread, NULL, Read_work, r);
+   }
+   return r->buf[full];
+}  /* Reader_next */
+
+
+/*------------------------------------------------------------------
+ * Function:    Read_work
+ * Purpose:     Thread function:  read the next block into buf[fill]
+ * In/out arg:  reader
+ */
+void* Read_work(void* reader) {
+   reader_t* r = (reader_t*) reader;
+   size_t    count = (r->left < (long long) r->cap) ? r->left : r->cap;
+
+   Full_pread(r->fd, r->buf[r->fill], count*sizeof(int), r->next_off);
+   r->count[r->fill] = count;
+   r->next_off += count*sizeof(int);
+   r->left -= count;
+   return NULL;
+}  /* Read_work */
+
+
+/*------------------------------------------------------------------
+ * Function:    Reader_free
+ * Purpose:     Wait for any outstanding read and free the buffers
+ * In/out arg:  r
+ */
+void Reader_free(reader_t* r) {
+   if (r->pending) pthread_join(r->thread, NULL);
+   free(r->buf[0]);
+   free(r->buf[1]);
+}  /* Reader_free */
+
+
+/*------------------------------------------------------------------
+ * Function:  Writer_init
+ * Purpose:   Set up a writer that writes at key first of fd
+ * In args:   fd, first, cap
+ * Out arg:   w
+ */
+void Writer_init(writer_t* w, int fd, off_t first, size_t cap) {
+   w->fd = fd;
+   w->next_off = first*sizeof(int);
+   w->cap = cap;
+   w->buf[0] = malloc(cap*sizeof(int));
+   w->buf[1] = malloc(cap*sizeof(int));
+   w->count = 0;
+   w->cur = 0;
+   w->pending = 0;
+}  /* Writer_init */
+
+
+/*------------------------------------------------------------------
+ * Function:    Writer_put
+ * Purpose:     Hand the buffer the caller has filled to a write thread
+ *              and switch the caller to the other buffer
+ * In/out arg:  w
+ *
+ * Note:        Waits for the previous write, so at most one write is
+ *              outstanding and writes happen in order.
+ */
+void Writer_put(writer_t* w) {
+   if (w->pending) pthread_join(w->thread, NULL);
+   w->pending = 0;
+   if (w->count == 0) return;
+
+   w->w_buf = w->buf[w->cur];
+   w->w_count = w->count;
+   w->w_off = w->next_off;
+   w->next_off += w->count*sizeof(int);
+   w->pending = 1;
+   pthread_create(&w->thread, NULL, Write_work, w);
+
+   w->cur = 1 - w->cur;
+   w->count = 0;
+}  /* Writer_put */
+
+
+/*------------------------------------------------------------------
+ * Function:    Write_work
+ * Purpose:     Thread function:  write the buffer handed over by
+ *              Writer_put
+ * In/out arg:  writer
+ */
+void* Write_work(void* writer) {
+   writer_t* w = (writer_t*) writer;
+
+   Full_pwrite(w->fd, w->w_buf, w->w_count*sizeof(int),
+         w->w_off);
+   return NULL;
+}  /* Write_work */
+
+
+/*------------------------------------------------------------------
+ * Function:    Writer_close
+ * Purpose:     Write anything left in the current buffer, wait for
+ *              the writes to finish, and free the buffers
+ * In/out arg:  w
+ */
+void Writer_close(writer_t* w) {
+   Writer_put(w);
+   if (w->pending) pthread_join(w->thread, NULL);
+   free(w->buf[0]);
+   free(w->buf[1]);
+}  /* Writer_close */
+
+
+/*------------------------------------------------------------------
+ * Function:    Make_runs
+ * Purpose:     Read the input in blocks of run_keys keys, sort each
+ *              block and write it to run_fd
+ * In args:     in_fd, run_fd, thread_count, run_keys
+ * Out args:    runs_p:  the runs that were written
+ *              n_p:  total number of keys
+ * Return val:  number of runs
+ *
+ * Note:        While block i is being sorted, block i+1 is being read
+ *              and block i-1 is being written.
+ */
+int Make_runs(int in_fd, int run_fd, int thread_count, size_t run_keys,
+      run_t** runs_p, long long* n_p) {
+   reader_t  r;
+   writer_t  w;
+   int*      buf;
+   size_t    count;
+   int       run_count = 0;
+   off_t     size = lseek(in_fd, 0, SEEK_END);
+
+   if (size % sizeof(int) != 0) {
+      fprintf(stderr, "Input isn't a whole number of ints\n");
+      exit(1);
+   }
+   *n_p = size/sizeof(int);
+   *runs_p = malloc(((*n_p + run_keys - 1)/run_keys + 1)*sizeof(run_t));
+
+   Reader_init(&r, in_fd, 0, *n_p, run_keys);
+   Writer_init(&w, run_fd, 0, run_keys);
+   while ((buf = Reader_next(&r, &count)) != NULL) {
+      Pth_bitonic_sort(buf, count, thread_count);
+      memcpy(w.buf[w.cur], buf, count*sizeof(int));
+      w.count = count;
+      (*runs_p)[run_count].first = w.next_off/sizeof(int);
+      (*runs_p)[run_count].count = count;
+      run_count++;
+      Writer_put(&w);
+   }
+   Writer_close(&w);
+   Reader_free(&r);
+
+   return run_count;
+}  /* Make_runs */
+
+
+/*------------------------------------------------------------------
+ * Function:    Merge_runs
+ * Purpose:     Merge k sorted runs of in_fd into one run that starts
+ *              at key out_first of out_fd
+ * In args:     in_fd, runs, k, out_fd, out_first, block
+ *
+ * Notes:
+ *    1.  key[i] is the current key of run i (EXHAUSTED when run i is
+ *        used up).  key[k] is a dummy that's smaller than any key and
+ *        is only used while the tree is built.
+ *    2.  tree[0] is the index of the run with the smallest key.
+ *        tree[1..k-1] hold the losers of the matches in the tree.
+ */
+void Merge_runs(int in_fd, run_t runs[], int k, int out_fd, off_t out_first,
+      size_t block) {
+   reader_t*  r = malloc(k*sizeof(reader_t));
+   int**      buf = malloc(k*sizeof(int*));
+   size_t*    pos = malloc(k*sizeof(size_t));
+   size_t*    count = malloc(k*sizeof(size_t));
+   long long* key = malloc((k + 1)*sizeof(long long));
+   int*       tree = malloc(k*sizeof(int));
+   writer_t   w;
+   int        i, win;
+
+   tree[0] = k;
+   for (i = 0; i < k; i++) {
+      Reader_init(&r[i], in_fd, runs[i].first, runs[i].count, block);
+      buf[i] = Reader_next(&r[i], &count[i]);
+      pos[i] = 0;
+      key[i] = (buf[i] != NULL) ? buf[i][0] : EXHAUSTED;
+   }
+   Writer_init(&w, out_fd, out_first, block);
+
+   key[k] = LLONG_MIN;
+   for (i = 0; i < k; i++)
+      tree[i] = k;
+   for (i = k - 1; i >= 0; i--)
+      Adjust(tree, key, k, i);
+
+   while (key[win = tree[0]] != EXHAUSTED) {
+      w.buf[w.cur][w.count++] = (int) key[win];
+      if (w.count == w.cap) Writer_put(&w);
+
+      if (++pos[win] == count[win]) {
+         buf[win] = Reader_next(&r[win], &count[win]);
+         pos[win] = 0;
+      }
+      key[win] = (buf[win] != NULL) ? buf[win][pos[win]] : EXHAUSTED;
+      Adjust(tree, key, k, win);
+   }
+   Writer_close(&w);
+
+   for (i = 0; i < k; i++)
+      Reader_free(&r[i]);
+   free(r);
+   free(buf);
+   free(pos);
+   free(count);
+   free(key);
+   free(tree);
+}  /* Merge_runs */
+
+
+/*------------------------------------------------------------------
+ * Function:    Adjust
+ * Purpose:     Replay the matches on the path from leaf s to the root
+ *              of the loser tree after key[s] has changed
+ * In args:     key, k, s
+ * In/out arg:  tree
+ */
+void Adjust(int tree[], long long key[], int k, int s) {
+   int t = (s + k)/2;
+   int temp;
+
+   while (t > 0) {
+      if (key[s] > key[tree[t]]) {
+         temp = s;
+         s = tree[t];
+         tree[t] = temp;
+      }
+      t /= 2;
+   }
+   tree[0] = s;
+}  /* Adjust */
@@ -0,0 +1,262 @@
+/* File:     pth_bitonic.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Sort a list of ints with a threaded bitonic sort.  This is
+ *           the sort that used to live in bitonic_sort.c, pulled out of
+ *           its driver so that bitonic_sort.c, sort_bench.c and
+ *           ext_sort.c all call the same one on their own lists.
+ *
+ * Compile:  link with the caller, e.g.
+ *           gcc -g -Wall -O2 -I.. -o sort_bench sort_bench.c pth_bitonic.c
+ *               ../numa_rt.c -lpthread
+ *
+ * Algorithm:
+ *    1.  The list is copied into a buffer whose length is a multiple
+ *        of the number of threads, padding the tail with INT_MAX.
+ *        Each thread copies its own block.
+ *    2.  Each thread qsorts its block.
+ *    3.  Threads pair up with butterfly structured communication and
+ *        do a merge-split with their partner's block.  Each step
+ *        reads from one buffer and writes to the other, and the
+ *        threads meet at a barrier before the buffers are swapped.
+ *    4.  The first n elements of the buffer are copied back.
+ *
+ * Notes:
+ *    1.  The number of threads must be a power of 2.  If it isn't,
+ *        the largest power of 2 that is less than it is used (see
+ *        Bitonic_thread_count).
+ *    2.  Pth_bitonic_sort isn't reentrant:  it keeps its state in
+ *        file scope globals.
+ *    3.  Thread r is pinned with Numa_pin(r) (../numa_rt.c), and the
+ *        main thread only mallocs the buffers.  Each thread writes its
+ *        own block of buf_a (the copy in step 1) and of buf_b before
+ *        anyone else does, so on a NUMA machine both blocks are on the
+ *        node of the thread that sorts them and merge-splits into them.
+ *        Only the partner's block is read across nodes.  Before it
+ *        finishes, each thread counts the pages of its two blocks that
+ *        are local and remote to it, and Bitonic_placement returns the
+ *        totals for the last sort.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include "pth_bitonic.h"
+
+/* File scope globals:  shared by the threads of one sort */
+static int  b_thread_count;
+static int  block_n;
+static int* list;
+static int  list_n;
+static int* buf_a;
+static int* buf_b;
+static pthread_barrier_t barrier;
+static numa_counts_t placement;
+
+static void* Bitonic_work(void* rank);
+static int   Compare(const void* one, const void* two);
+static void  Merge_split_low(int my_list[], int partner_list[],
+      int out_list[], int block_n);
+static void  Merge_split_high(int my_list[], int partner_list[],
+      int out_list[], int block_n);
+
+/*-------------------------------------------------------------------
+ * Function:    Bitonic_thread_count
+ * Purpose:     Return the number of threads Pth_bitonic_sort will
+ *              actually use when it's asked for thread_count
+ * In arg:      thread_count
+ * Return val:  largest power of 2 <= thread_count (at least 1)
+ */
+int Bitonic_thread_count(int thread_count) {
+   int p = 1;
+
+   while (2*p <= thread_count)
+      p *= 2;
+   return p;
+}  /* Bitonic_thread_count */
+
+
+/*-------------------------------------------------------------------
+ * Function:     Pth_bitonic_sort
+ * Purpose:      Sort a list of ints into increasing order
+ * In args:      n, thread_count
+ * In/out arg:   a
+ */
+void Pth_bitonic_sort(int a[], int n, int thread_count) {
+   long       thread;
+   pthread_t* thread_handles;
+   size_t     padded_n;
+
+   memset(&placement, 0, sizeof(placement));
+   b_thread_count = Bitonic_thread_count(thread_count);
+   if (b_thread_count == 1 || n < 2*b_thread_count) {
+      qsort(a, n, sizeof(int), Compare);
+      return;
+   }
+
+   block_n = (n + b_thread_count - 1)/b_thread_count;
+   padded_n = (size_t) block_n*b_thread_count;
+   list = a;
+   list_n = n;
+   buf_a = malloc(padded_n*sizeof(int));
+   buf_b = malloc(padded_n*sizeof(int));
+
+   thread_handles = malloc(b_thread_count*sizeof(pthread_t));
+   pthread_barrier_init(&barrier, NULL, b_thread_count);
+
+   for (thread = 0; thread < b_thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Bitonic_work,
+            (void*) thread);
+   for (thread = 0; thread < b_thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+
+   /* Bitonic_work leaves the result in buf_a */
+   memcpy(a, buf_a, n*sizeof(int));
+
+   pthread_barrier_destroy(&barrier);
+   free(thread_handles);
+   free(buf_a);
+   free(buf_b);
+}  /* Pth_bitonic_sort */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Bitonic_placement
+ * Purpose:     Get the page placement of the last threaded sort's
+ *              buffers (note 3).  All zero if the last sort was done
+ *              by one thread.
+ * Out arg:     counts
+ */
+void Bitonic_placement(numa_counts_t* counts) {
+   *counts = placement;
+}  /* Bitonic_placement */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Bitonic_work
+ * Purpose:     Copy this thread's block of the list and sort it,
+ *              then take part in the butterfly of merge-splits
+ * In arg:      rank
+ * Globals:     b_thread_count, block_n, list, list_n (in), buf_a,
+ *              buf_b, placement (in/out)
+ *
+ * Notes:
+ *    1.  When (my_rank & size) is 0 the thread is in an increasing
+ *        sequence and the lower ranked thread keeps the smaller keys.
+ *        Otherwise it's in a decreasing sequence and the lower ranked
+ *        thread keeps the larger keys.
+ *    2.  Every thread swaps its local src/dst pointers after every
+ *        step, so they all agree on which buffer is current.  The
+ *        number of steps is even or odd for every thread alike, and
+ *        thread 0 copies the result into buf_a if it ended in buf_b.
+ */
+static void* Bitonic_work(void* rank) {
+   long     my_rank = (long) rank;
+   int*     src = buf_a;
+   int*     dst = buf_b;
+   int*     swap;
+   int      size, bitmask, partner;
+   size_t   my_first = (size_t) my_rank*block_n;
+   size_t   partner_first, i, copy_n;
+
+   Numa_pin(my_rank);
+   copy_n = (my_first >= list_n) ? 0 :
+      (my_first + block_n <= list_n) ? block_n : list_n - my_first;
+   memcpy(buf_a + my_first, list + my_first, copy_n*sizeof(int));
+   for (i = copy_n; i < block_n; i++)
+      buf_a[my_first + i] = INT_MAX;
+   Numa_first_touch(buf_b + my_first, block_n*sizeof(int));
+
+   qsort(src + my_first, block_n, sizeof(int), Compare);
+   pthread_barrier_wait(&barrier);
+
+   for (size = 2; size <= b_thread_count; size <<= 1) {
+      for (bitmask = size >> 1; bitmask > 0; bitmask >>= 1) {
+         partner = my_rank ^ bitmask;
+         partner_first = (size_t) partner*block_n;
+         if (((my_rank & size) == 0) == (my_rank < partner))
+            Merge_split_low(src + my_first, src + partner_first,
+                  dst + my_first, block_n);
+         else
+            Merge_split_high(src + my_first, src + partner_first,
+                  dst + my_first, block_n);
+         pthread_barrier_wait(&barrier);
+         swap = src; src = dst; dst = swap;
+      }
+   }
+
+   if (src != buf_a)
+      memcpy(buf_a + my_first, src + my_first, block_n*sizeof(int));
+
+   Numa_count_pages(buf_a + my_first, block_n*sizeof(int), &placement);
+   Numa_count_pages(buf_b + my_first, block_n*sizeof(int), &placement);
+   return NULL;
+}  /* Bitonic_work */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Compare
+ * Purpose:     Comparison function for qsort
+ * In args:     one, two:  pointers to the ints being compared
+ */
+static int Compare(const void* one, const void* two) {
+   int x = *((const int*) one);
+   int y = *((const int*) two);
+
+   if (x > y)
+      return 1;
+   else if (x < y)
+      return -1;
+   else
+      return 0;
+}  /* Compare */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Merge_split_low
+ * Purpose:     Merge the smallest block_n keys of my_list and
+ *              partner_list into out_list
+ * In args:     my_list, partner_list, block_n
+ * Out arg:     out_list
+ */
+static void Merge_split_low(int my_list[], int partner_list[],
+      int out_list[], int block_n) {
+   int my_index, your_index, our_index;
+
+   my_index = your_index = our_index = 0;
+   while (our_index < block_n) {
+      if (my_list[my_index] <= partner_list[your_index]) {
+         out_list[our_index] = my_list[my_index];
+         our_index++; my_index++;
+      } else {
+         out_list[our_index] = partner_list[your_index];
+         our_index++; your_index++;
+      }
+   }
+}  /* Merge_split_low */
+
+
+/*-------------------------------------------------------------------
+ * Function:    Merge_split_high
+ * Purpose:     Merge the largest block_n keys of my_list and
+ *              partner_list into out_list
+ * In args:     my_list, partner_list, block_n
+ * Out arg:     out_list
+ */
+static void Merge_split_high(int my_list[], int partner_list[],
+      int out_list[], int block_n) {
+   int my_index, your_index, our_index;
+
+   my_index = your_index = our_index = block_n - 1;
+   while (our_index >= 0) {
+      if (my_list[my_index] >= partner_list[your_index]) {
+         out_list[our_index] = my_list[my_index];
+         our_index--; my_index--;
+      } else {
+         out_list[our_index] = partner_list[your_index];
+         our_index--; your_index--;
+      }
+   }
+}  /* Merge_split_high */
@@ -0,0 +1,21 @@
+/* File:     pth_bitonic.h
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Interface to the threaded bitonic sort in pth_bitonic.c.
+ *
+ * Example:
+ *    #include "pth_bitonic.h"
+ *    . . .
+ *    Pth_bitonic_sort(a, n, thread_count);
+ */
+#ifndef _PTH_BITONIC_H_
+#define _PTH_BITONIC_H_
+
+#include "numa_rt.h"
+
+void Pth_bitonic_sort(int a[], int n, int thread_count);
+int  Bitonic_thread_count(int thread_count);
+void Bitonic_placement(numa_counts_t* counts);
+
+#endif
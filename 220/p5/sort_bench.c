@@ -0,0 +1,392 @@
+/* File:     sort_bench.c
+ *
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Run every sorter we have on the same inputs and report
+ *           how long each one takes.  The sorters are
+ *              qsort:     the C library sort (baseline)
+ *              bubble:    Bubble_sort (h8/serial_sorts.c)
+ *              odd_even:  Odd_even_sort (h8/serial_sorts.c)
+ *              bitonic:   the threaded bitonic sort (pth_bitonic.c)
+ *
+ * Compile:  gcc -g -Wall -O2 -I.. -o sort_bench sort_bench.c pth_bitonic.c
+ *              ../h8/serial_sorts.c ../numa_rt.c -lpthread -lm
+ * Usage:    sort_bench <min n> <max n> <max threads> [reps]
+ *              min n, max n:  n runs from min n to max n, multiplying
+ *                 by 10 each time (e.g. 1000 1000000000)
+ *              max threads:   bitonic runs with 1, 2, 4, ... threads
+ *                 up to max threads
+ *              reps:  number of times each sort is timed (default 5)
+ *
+ * Input:    None
+ * Output:   One CSV line per (sorter, distribution, n, threads):
+ *              sorter,dist,n,threads,reps,min_s,median_s,keys_per_s,
+ *              efficiency,correct
+ *           keys_per_s uses the median time.  efficiency is
+ *           T(1 thread)/(threads*T(threads)) for the same sorter,
+ *           distribution and n.
+ *
+ * Notes:
+ *    1.  The input distributions are
+ *           random:      uniform in [0, RMAX)
+ *           sorted:      0, 1, 2, ...
+ *           reverse:     n-1, n-2, ...
+ *           few_unique:  uniform in [0, FEW_UNIQUE)
+ *           zipf:        Zipf(ZIPF_S) over ZIPF_KEYS distinct keys
+ *        Every distribution is generated with srandom(1), so every
+ *        sorter sees exactly the same list.
+ *    2.  Bubble sort and odd-even sort are quadratic, so they're only
+ *        run for n <= QUAD_MAX.
+ *    3.  After each run the output is checked to be in increasing
+ *        order and to have the same checksum as the input.
+ *    4.  For the random lists, the page placement of the threaded
+ *        bitonic sort's buffers (pth_bitonic.c, note 3) goes to
+ *        stderr, so it doesn't get mixed into the CSV.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "timer.h"
+#include "pth_bitonic.h"
+#include "h8/serial_sorts.h"
+
+/* For random list, 0 <= keys < RMAX */
+const int RMAX = 1000000000;
+const int FEW_UNIQUE = 16;
+const int ZIPF_KEYS = 100000;
+const double ZIPF_S = 1.0;
+const int QUAD_MAX = 65536;
+const int DEFAULT_REPS = 5;
+
+typedef enum {RANDOM, SORTED, REVERSE, FEW_UNIQ, ZIPF, DIST_COUNT} dist_t;
+const char* dist_names[] = {"random", "sorted", "reverse", "few_unique",
+   "zipf"};
+
+typedef void (*sorter_t)(int a[], int n, int thread_count);
+
+void Usage(char* prog_name);
+void Get_args(int argc, char* argv[], long* min_n_p, long* max_n_p,
+      int* max_threads_p, int* reps_p);
+void Generate_list(int a[], int n, dist_t dist);
+void Generate_zipf(int a[], int n);
+unsigned long long Checksum(int a[], int n);
+int  Is_sorted(int a[], int n);
+int  Compare_double(const void* x, const void* y);
+int  Compare_int(const void* x, const void* y);
+double Time_sort(sorter_t sort, int in[], int work[], int n,
+      int thread_count, int reps, double* min_p, int* correct_p);
+void Print_row(const char* sorter, dist_t dist, int n, int threads,
+      int reps, double min, double median, double t1, int correct);
+
+void Qsort_sort(int a[], int n, int thread_count);
+void Bubble_run(int a[], int n, int thread_count);
+void Odd_even_run(int a[], int n, int thread_count);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long   min_n, max_n, n;
+   int    max_threads, reps, threads, correct;
+   int*   in;
+   int*   work;
+   dist_t dist;
+   double min, median, t1;
+   numa_counts_t counts;
+   char   title[64];
+
+   Get_args(argc, argv, &min_n, &max_n, &max_threads, &reps);
+   in = malloc(max_n*sizeof(int));
+   work = malloc(max_n*sizeof(int));
+   if (in == NULL || work == NULL) {
+      fprintf(stderr, "Can't allocate lists of %ld ints\n", max_n);
+      exit(1);
+   }
+
+   printf("sorter,dist,n,threads,reps,min_s,median_s,keys_per_s,"
+         "efficiency,correct\n");
+   for (n = min_n; n <= max_n; n *= 10) {
+      for (dist = 0; dist < DIST_COUNT; dist++) {
+         Generate_list(in, n, dist);
+
+         median = Time_sort(Qsort_sort, in, work, n, 1, reps, &min,
+               &correct);
+         Print_row("qsort", dist, n, 1, reps, min, median, median,
+               correct);
+
+         if (n <= QUAD_MAX) {
+            median = Time_sort(Bubble_run, in, work, n, 1, reps, &min,
+                  &correct);
+            Print_row("bubble", dist, n, 1, reps, min, median, median,
+                  correct);
+            median = Time_sort(Odd_even_run, in, work, n, 1, reps, &min,
+                  &correct);
+            Print_row("odd_even", dist, n, 1, reps, min, median, median,
+                  correct);
+         }
+
+         t1 = 0.0;
+         for (threads = 1; threads <= max_threads; threads *= 2) {
+            median = Time_sort(Pth_bitonic_sort, in, work, n, threads,
+                  reps, &min, &correct);
+            if (threads == 1) t1 = median;
+            Print_row("bitonic", dist, n, threads, reps, min, median, t1,
+                  correct);
+            if (dist == RANDOM && threads > 1) {
+               Bitonic_placement(&counts);
+               sprintf(title, "bitonic n = %ld, %d threads", n,
+                     Bitonic_thread_count(threads));
+               Numa_print(title, &counts);
+            }
+         }
+         fflush(stdout);
+      }
+   }
+
+   free(in);
+   free(work);
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------
+ * Function:  Usage
+ * Purpose:   Summary of how to run program
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage:   %s <min n> <max n> <max threads> [reps]\n",
+         prog_name);
+   fprintf(stderr, "   n runs from min n to max n by factors of 10\n");
+   fprintf(stderr, "   bitonic runs with 1, 2, 4, ... max threads\n");
+   fprintf(stderr, "   reps:  times each sort is run (default %d)\n",
+         DEFAULT_REPS);
+}  /* Usage */
+
+
+/*-----------------------------------------------------------------
+ * Function:  Get_args
+ * Purpose:   Get and check command line arguments
+ * In args:   argc, argv
+ * Out args:  min_n_p, max_n_p, max_threads_p, reps_p
+ */
+void Get_args(int argc, char* argv[], long* min_n_p, long* max_n_p,
+      int* max_threads_p, int* reps_p) {
+   if (argc != 4 && argc != 5) {
+      Usage(argv[0]);
+      exit(0);
+   }
+   *min_n_p = strtol(argv[1], NULL, 10);
+   *max_n_p = strtol(argv[2], NULL, 10);
+   *max_threads_p = strtol(argv[3], NULL, 10);
+   *reps_p = (argc == 5) ? strtol(argv[4], NULL, 10) : DEFAULT_REPS;
+
+   if (*min_n_p <= 0 || *max_n_p < *min_n_p || *max_n_p > 0x7fffffffL
+         || *max_threads_p <= 0 || *reps_p <= 0) {
+      Usage(argv[0]);
+      exit(0);
+   }
+}  /* Get_args */
+
+
+/*-----------------------------------------------------------------
+ * Function:  Generate_list
+ * Purpose:   Generate a list with the given distribution
+ * In args:   n, dist
+ * Out args:  a
+ */
+void Generate_list(int a[], int n, dist_t dist) {
+   int i;
+
+   srandom(1);
+   switch (dist) {
+      case RANDOM:
+         for (i = 0; i < n; i++)
+            a[i] = random() % RMAX;
+         break;
+      case SORTED:
+         for (i = 0; i < n; i++)
+            a[i] = i;
+         break;
+      case REVERSE:
+         for (i = 0; i < n; i++)
+            a[i] = n - 1 - i;
+         break;
+      case FEW_UNIQ:
+         for (i = 0; i < n; i++)
+            a[i] = random() % FEW_UNIQUE;
+         break;
+      default:
+         Generate_zipf(a, n);
+         break;
+   }
+}  /* Generate_list */
+
+
+/*-----------------------------------------------------------------
+ * Function:  Generate_zipf
+ * Purpose:   Generate a list of keys in [0, ZIPF_KEYS) where key k
+ *            has probability proportional to 1/(k+1)^ZIPF_S
+ * In args:   n
+ * Out args:  a
+ *
+ * Note:      Uses the inverse of the cumulative distribution, found
+ *            with a binary search.
+ */
+void Generate_zipf(int a[], int n) {
+   double* cdf = malloc(ZIPF_KEYS*sizeof(double));
+   double  sum = 0.0, u;
+   int     i, k, lo, hi;
+
+   for (k = 0; k < ZIPF_KEYS; k++) {
+      sum += 1.0/pow(k + 1, ZIPF_S);
+      cdf[k] = sum;
+   }
+   for (i = 0; i < n; i++) {
+      u = (random()/((double) RAND_MAX + 1.0))*sum;
+      lo = 0; hi = ZIPF_KEYS - 1;
+      while (lo < hi) {
+         k = (lo + hi)/2;
+         if (cdf[k] < u) lo = k + 1;
+         else hi = k;
+      }
+      a[i] = lo;
+   }
+   free(cdf);
+}  /* Generate_zipf */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Time_sort
+ * Purpose:     Run sort reps times on copies of in and check each
+ *              result
+ * In args:     sort, in, n, thread_count, reps
+ * Scratch:     work
+ * Out args:    min_p:  fastest time
+ *              correct_p:  1 if every run sorted the list, 0 otherwise
+ * Return val:  median time
+ */
+double Time_sort(sorter_t sort, int in[], int work[], int n,
+      int thread_count, int reps, double* min_p, int* correct_p) {
+   double* times = malloc(reps*sizeof(double));
+   double  start, finish, median;
+   unsigned long long in_sum = Checksum(in, n);
+   int     r;
+
+   *correct_p = 1;
+   for (r = 0; r < reps; r++) {
+      memcpy(work, in, n*sizeof(int));
+      GET_TIME(start);
+      sort(work, n, thread_count);
+      GET_TIME(finish);
+      times[r] = finish - start;
+      if (!Is_sorted(work, n) || Checksum(work, n) != in_sum)
+         *correct_p = 0;
+   }
+
+   qsort(times, reps, sizeof(double), Compare_double);
+   *min_p = times[0];
+   if (reps % 2 == 1)
+      median = times[reps/2];
+   else
+      median = (times[reps/2 - 1] + times[reps/2])/2.0;
+   free(times);
+   return median;
+}  /* Time_sort */
+
+
+/*-----------------------------------------------------------------
+ * Function:  Print_row
+ * Purpose:   Print one line of CSV output
+ * In args:   sorter, dist, n, threads, reps, min, median, correct
+ *            t1:  median time of the same sort with 1 thread
+ */
+void Print_row(const char* sorter, dist_t dist, int n, int threads,
+      int reps, double min, double median, double t1, int correct) {
+   int used = threads;
+
+   if (strcmp(sorter, "bitonic") == 0)
+      used = Bitonic_thread_count(threads);
+   printf("%s,%s,%d,%d,%d,%e,%e,%e,%.3f,%s\n", sorter, dist_names[dist],
+         n, used, reps, min, median, n/median, t1/(used*median),
+         correct ? "yes" : "no");
+}  /* Print_row */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Checksum
+ * Purpose:     Order independent checksum of the list, so we can
+ *              check that a sort didn't lose or invent keys
+ * In args:     a, n
+ */
+unsigned long long Checksum(int a[], int n) {
+   unsigned long long sum = 0, sq = 0, x;
+   int i;
+
+   for (i = 0; i < n; i++) {
+      x = (unsigned) a[i];
+      sum += x;
+      sq += x*x;
+   }
+   return sum ^ (sq*0x9e3779b97f4a7c15ULL);
+}  /* Checksum */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Is_sorted
+ * Purpose:     Check whether the list is in increasing order
+ * In args:     a, n
+ */
+int Is_sorted(int a[], int n) {
+   int i;
+
+   for (i = 1; i < n; i++)
+      if (a[i-1] > a[i]) return 0;
+   return 1;
+}  /* Is_sorted */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Compare_double, Compare_int
+ * Purpose:     Comparison functions for qsort
+ */
+int Compare_double(const void* x, const void* y) {
+   double a = *((const double*) x), b = *((const double*) y);
+   return (a > b) - (a < b);
+}  /* Compare_double */
+
+int Compare_int(const void* x, const void* y) {
+   int a = *((const int*) x), b = *((const int*) y);
+   return (a > b) - (a < b);
+}  /* Compare_int */
+
+
+/*-----------------------------------------------------------------
+ * Function:     Qsort_sort
+ * Purpose:      Sort list with the C library qsort
+ * In args:      n, thread_count (ignored)
+ * In/out args:  a
+ */
+void Qsort_sort(int a[], int n, int thread_count) {
+   qsort(a, n, sizeof(int), Compare_int);
+}  /* Qsort_sort */
+
+
+/*-----------------------------------------------------------------
+ * Function:     Bubble_run
+ * Purpose:      Sort list with Bubble_sort (../h8/serial_sorts.c)
+ * In args:      n, thread_count (ignored)
+ * In/out args:  a
+ */
+void Bubble_run(int a[], int n, int thread_count) {
+   Bubble_sort(a, n);
+}  /* Bubble_run */
+
+
+/*-----------------------------------------------------------------
+ * Function:     Odd_even_run
+ * Purpose:      Sort list with Odd_even_sort (../h8/serial_sorts.c)
+ * In args:      n, thread_count (ignored)
+ * In/out args:  a
+ */
+void Odd_even_run(int a[], int n, int thread_count) {
+   Odd_even_sort(a, n);
+}  /* Odd_even_run */
@@ -0,0 +1,92 @@
+/* File:     ring.c
+ * Author:   Cayla Shaver
+ * Section:  2
+ * Purpose:  Implement the ring communication in ring.h
+ *
+ * Compile:  link with the caller, e.g.
+ *           mpicc -g -Wall -I.. -o mpi_hello0 mpi_hello0.c ../ring.c
+ *
+ * Notes:
+ *    1.  If every process does MPI_Send to the right and then
+ *        MPI_Recv from the left, nobody's receive is posted until
+ *        their send returns.  That only works while the MPI library
+ *        buffers the message (the "eager" protocol).  Above the eager
+ *        limit every send waits for a matching receive, and the ring
+ *        hangs.  Here the receive is always posted with the send:
+ *        MPI_Sendrecv in Ring_shift, MPI_Irecv before MPI_Isend in
+ *        Ring_pass.  So any message size works.
+ *    2.  Ring_pass takes p - 1 hops.  At hop h the block that came
+ *        from process my_rank - h is passed to the right while work
+ *        is called on it, and the block from my_rank - h - 1 is
+ *        received into a second buffer.  Then the buffers trade
+ *        places.  So the work on each block overlaps the transfer of
+ *        the next one, and buf itself is only read.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "ring.h"
+
+/*-----------------------------------------------------------------
+ * Function:    Ring_shift
+ * Purpose:     Send send_buf to the process on the right while
+ *              receiving recv_buf from the process on the left
+ * In args:     send_buf, send_count, recv_count, type, comm
+ * Out arg:     recv_buf
+ */
+void Ring_shift(const void* send_buf, int send_count, void* recv_buf,
+      int recv_count, MPI_Datatype type, MPI_Comm comm) {
+   int p, my_rank;
+
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+   MPI_Sendrecv(send_buf, send_count, type, (my_rank + 1) % p, 0,
+         recv_buf, recv_count, type, (my_rank + p - 1) % p, 0, comm,
+         MPI_STATUS_IGNORE);
+}  /* Ring_shift */
+
+
+/*-----------------------------------------------------------------
+ * Function:    Ring_pass
+ * Purpose:     Pass every process's block around the ring, calling
+ *              work on each one (note 2)
+ * In args:     buf:  this process's block of count elements of type
+ *              count, type
+ *              work:  called on each of the p blocks, this process's
+ *                 own first (hop 0)
+ *              arg:  passed to work
+ *              comm
+ */
+void Ring_pass(const void* buf, int count, MPI_Datatype type,
+      ring_work_t work, void* arg, MPI_Comm comm) {
+   int         p, my_rank, left, right, hop;
+   MPI_Aint    lb, extent;
+   MPI_Request reqs[2];
+   char*       tmp[2];
+   const void* cur = buf;
+   char*       next;
+
+   MPI_Comm_size(comm, &p);
+   MPI_Comm_rank(comm, &my_rank);
+   right = (my_rank + 1) % p;
+   left = (my_rank + p - 1) % p;
+   MPI_Type_get_extent(type, &lb, &extent);
+   tmp[0] = malloc(count*extent + 1);
+   tmp[1] = malloc(count*extent + 1);
+   next = tmp[0];
+
+   for (hop = 0; hop < p; hop++) {
+      if (hop < p - 1) {
+         MPI_Irecv(next, count, type, left, 0, comm, &reqs[0]);
+         MPI_Isend(cur, count, type, right, 0, comm, &reqs[1]);
+      }
+      work(cur, hop, arg);
+      if (hop < p - 1) {
+         MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+         cur = next;
+         next = (next == tmp[0]) ? tmp[1] : tmp[0];
+      }
+   }
+
+   free(tmp[0]);
+   free(tmp[1]);
+}  /* Ring_pass */
@@ -0,0 +1,31 @@
+/* File:     ring.h
+ * Author:   Cayla Shaver
+ * Purpose:  Deadlock-free communication around a ring of processes:
+ *           process q sends to q+1 and receives from q-1 (mod p).
+ *
+ * Example:
+ *    #include "ring.h"
+ *    . . .
+ *    Ring_shift(mine, n, from_left, n, MPI_INT, comm);
+ *
+ *    or, to visit every process's block with the communication of
+ *    the next hop going on while the work on this one is done,
+ *
+ *    void Work(const void* block, int hop, void* arg) { ... }
+ *    . . .
+ *    Ring_pass(mine, n, MPI_INT, Work, &totals, comm);
+ */
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <mpi.h>
+
+/* Called with the block that came from process my_rank - hop */
+typedef void (*ring_work_t)(const void* block, int hop, void* arg);
+
+void Ring_shift(const void* send_buf, int send_count, void* recv_buf,
+        int recv_count, MPI_Datatype type, MPI_Comm comm);
+void Ring_pass(const void* buf, int count, MPI_Datatype type,
+        ring_work_t work, void* arg, MPI_Comm comm);
+
+#endif